@@ -0,0 +1,639 @@
+/*
+    MicroDSP - Day 10: Waveform Overview Cache (Peak Files)
+
+    What this program does:
+    - Reads a 16-bit PCM WAV file in ONE streaming pass, split across all CPU cores
+    - Builds a "peak pyramid": for every 256 samples it stores the min, max
+      and RMS value, then for every 512, 1024, 2048... all the way up
+    - Optionally stores a log-magnitude spectrogram (one 1024-point FFT per
+      1024 samples, squeezed into 256 bytes per frame)
+    - Saves everything to a small sidecar file: <file>.peaks
+    - Answers zoom queries ("draw 0..30 s into 800 pixels") and spectrogram
+      queries ("which band is loudest in each column") using ONLY the
+      sidecar, never touching the audio again
+
+    Why a pyramid?
+    A screen is maybe 2000 pixels wide. To draw a one-hour file, each pixel
+    covers ~86,000 samples. Scanning them all for every redraw is slow, but
+    with a pyramid we just pick the level whose bins are a bit smaller than
+    one pixel and combine a handful of bins per pixel. Every level is half
+    the size of the one below, so the whole pyramid costs about 2x level 0,
+    which is ~1/40th the size of the audio.
+
+    Content hash:
+    The sidecar records a 64-bit hash of the audio data. The hash is built
+    from fixed-size chunks (hashed in parallel) and then combined in order,
+    so it comes out the same no matter how many threads were used. The
+    sidecar also stores the WAV's size and modification time. A query
+    trusts the sidecar when both still match, without reading any audio.
+    When they don't (the WAV was edited, touched, or copied over), it
+    hashes the audio again: the same hash means only the metadata changed,
+    so the sidecar is updated and used; a different hash means the peaks
+    are stale, so the sidecar is rebuilt before answering.
+
+    Usage:
+        peak_cache build [--spectrogram] file.wav
+        peak_cache query file.wav startSeconds endSeconds pixels
+        peak_cache spectrogram file.wav startSeconds endSeconds columns
+    With no arguments it builds input.wav.peaks and runs an example of
+    each query.
+
+    Build:
+        g++ -std=c++17 -O3 -march=native -pthread peak_cache.cpp -o peak_cache
+
+    Author: Jesse Whiting (GhostWire Audio)
+    GitHub: ghostwireaudio
+*/
+
+#define _USE_MATH_DEFINES
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <complex>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <filesystem>
+#include <cstdio>
+#include <cstdlib>
+
+// Force the compiler to pack the struct exactly as written
+// with no padding bytes added for alignment, which ensures
+// sizeof(WavHeader) == 44 bytes
+#pragma pack(push, 1)
+struct WavHeader {
+    // RIFF Chunk Descriptor
+    char     riff[4];        // "RIFF"
+    uint32_t chunkSize;      // 36 + Subchunk2Size
+    char     wave[4];        // "WAVE"
+
+    // fmt subchunk
+    char     fmt[4];         // "fmt "
+    uint32_t subchunk1Size;  // 16 for PCM
+    uint16_t audioFormat;    // 1 for PCM
+    uint16_t numChannels;    // 1 for mono
+    uint32_t sampleRate;     // e.g., 44100
+    uint32_t byteRate;       // sampleRate * numChannels * bitsPerSample/8
+    uint16_t blockAlign;     // numChannels * bitsPerSample/8
+    uint16_t bitsPerSample;  // 16
+
+    // data subchunk
+    char     data[4];        // "data"
+    uint32_t subchunk2Size;  // NumSamples * numChannels * bitsPerSample/8
+};
+
+// One entry of the pyramid (per channel): 6 bytes
+struct PeakBin {
+    int16_t  minValue;
+    int16_t  maxValue;
+    uint16_t rms;
+};
+
+// Start of the sidecar file. Everything after it is data.
+struct PeakFileHeader {
+    char     magic[4];           // "MDPK"
+    uint32_t version;            // 1
+    uint64_t contentHash;        // Hash of the audio data
+    uint64_t sourceSize;         // WAV file size in bytes (freshness check)
+    int64_t  sourceModified;     // WAV modification time (freshness check)
+    uint32_t sampleRate;
+    uint32_t numChannels;
+    uint64_t numFrames;
+    uint32_t baseBinSize;        // Frames per bin at level 0
+    uint32_t numLevels;
+    uint32_t spectrogramFrames;  // 0 = no spectrogram stored
+    uint32_t spectrogramFftSize;
+    uint32_t spectrogramBands;
+    uint32_t reserved;
+};
+#pragma pack(pop)
+
+const uint32_t baseBinSize = 256;    // Frames per bin at level 0
+const uint64_t chunkFrames = 1 << 18; // Unit of work for threads and hashing (multiple of everything below)
+const int fftSize = 1024;            // Spectrogram FFT size (and hop)
+const int spectrogramBands = 256;    // Bytes stored per spectrogram frame
+
+// ---------------------------------------------------------------------------
+// Hashing: a fast 64-bit multiply/rotate hash over 8-byte words
+// ---------------------------------------------------------------------------
+inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+uint64_t hashBytes(const uint8_t* data, size_t size, uint64_t seed) {
+    const uint64_t prime1 = 0x9E3779B185EBCA87ull;
+    const uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+    uint64_t h = seed ^ (size * prime1);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        h = rotl(h ^ (word * prime2), 31) * prime1;
+    }
+    for (; i < size; ++i) h = rotl(h ^ (data[i] * prime2), 11) * prime1;
+    h ^= h >> 33;
+    h *= prime2;
+    h ^= h >> 29;
+    return h;
+}
+
+// The sidecar's hash: one hash per chunk (seeded with its first frame), then
+// the chunk hashes hashed together in order
+uint64_t combineChunkHashes(const std::vector<uint64_t>& chunkHashes, uint64_t numFrames, uint32_t sampleRate) {
+    return hashBytes(reinterpret_cast<const uint8_t*>(chunkHashes.data()), chunkHashes.size() * sizeof(uint64_t),
+                     numFrames * 31 + sampleRate);
+}
+
+// ---------------------------------------------------------------------------
+// Minimal radix-2 FFT for the spectrogram (see Day 9 for a full explanation)
+// ---------------------------------------------------------------------------
+void fftInPlace(std::vector<std::complex<float>>& a) {
+    const size_t n = a.size();
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(a[i], a[j]);
+    }
+    for (size_t len = 2; len <= n; len <<= 1) {
+        const std::complex<float> wLen = std::polar(1.0f, static_cast<float>(-2.0 * M_PI / len));
+        for (size_t start = 0; start < n; start += len) {
+            std::complex<float> w(1.0f, 0.0f);
+            for (size_t j = 0; j < len / 2; ++j) {
+                const std::complex<float> u = a[start + j];
+                const std::complex<float> v = a[start + j + len / 2] * w;
+                a[start + j] = u + v;
+                a[start + j + len / 2] = u - v;
+                w *= wLen;
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Per-thread analysis of a range of chunks
+// ---------------------------------------------------------------------------
+struct SegmentResult {
+    std::vector<PeakBin> bins;         // Level-0 bins, [bin][channel]
+    std::vector<double> sumSquares;    // Exact energy per bin, used to build upper levels
+    std::vector<uint64_t> chunkHashes; // One hash per chunk
+    std::vector<uint8_t> spectrogram;  // [frame][band]
+    bool ok = true;
+};
+
+void analyzeSegment(const std::string& path, const WavHeader& header, uint64_t firstFrame, uint64_t endFrame,
+                    bool withSpectrogram, SegmentResult& result) {
+    const int channels = header.numChannels;
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        result.ok = false;
+        return;
+    }
+    in.seekg(static_cast<std::streamoff>(sizeof(WavHeader) + firstFrame * header.blockAlign));
+
+    std::vector<int16_t> chunk(chunkFrames * channels);
+    std::vector<float> window(fftSize);
+    for (int n = 0; n < fftSize; ++n) window[n] = 0.5f - 0.5f * std::cos(static_cast<float>(2.0 * M_PI * n / fftSize));
+    std::vector<std::complex<float>> spectrum(fftSize);
+    const float fullScale = 32768.0f * fftSize / 4.0f; // Magnitude of a full-scale sine through a Hann window
+
+    for (uint64_t start = firstFrame; start < endFrame; start += chunkFrames) {
+        const uint64_t frames = std::min<uint64_t>(chunkFrames, endFrame - start);
+        in.read(reinterpret_cast<char*>(chunk.data()), static_cast<std::streamsize>(frames * header.blockAlign));
+        if (static_cast<uint64_t>(in.gcount()) != frames * header.blockAlign) {
+            result.ok = false;
+            return;
+        }
+
+        result.chunkHashes.push_back(hashBytes(reinterpret_cast<const uint8_t*>(chunk.data()), frames * header.blockAlign, start));
+
+        // Level-0 bins: one pass over the samples, min/max/sum-of-squares per channel
+        for (uint64_t binStart = 0; binStart < frames; binStart += baseBinSize) {
+            const uint64_t binFrames = std::min<uint64_t>(baseBinSize, frames - binStart);
+            for (int c = 0; c < channels; ++c) {
+                int32_t lo = 32767, hi = -32768;
+                int64_t energy = 0; // Exact: 256 * 32768^2 fits easily
+                const int16_t* s = chunk.data() + binStart * channels + c;
+                for (uint64_t i = 0; i < binFrames; ++i) {
+                    const int32_t v = s[i * channels];
+                    lo = std::min(lo, v);
+                    hi = std::max(hi, v);
+                    energy += static_cast<int64_t>(v) * v;
+                }
+                const double rms = std::sqrt(static_cast<double>(energy) / binFrames);
+                result.bins.push_back({ static_cast<int16_t>(lo), static_cast<int16_t>(hi), static_cast<uint16_t>(std::lround(rms)) });
+                result.sumSquares.push_back(static_cast<double>(energy));
+            }
+        }
+
+        // Spectrogram: non-overlapping frames of the channel average.
+        // chunkFrames is a multiple of fftSize, so frames never straddle chunks.
+        if (withSpectrogram) {
+            for (uint64_t f = 0; f + fftSize <= frames; f += fftSize) {
+                for (int n = 0; n < fftSize; ++n) {
+                    float sum = 0.0f;
+                    for (int c = 0; c < channels; ++c) sum += chunk[(f + n) * channels + c];
+                    spectrum[n] = std::complex<float>(window[n] * sum / channels, 0.0f);
+                }
+                fftInPlace(spectrum);
+
+                // Keep the louder of each pair of bins and map -120..0 dBFS onto 0..255
+                for (int b = 0; b < spectrogramBands; ++b) {
+                    const float mag = std::max(std::abs(spectrum[2 * b]), std::abs(spectrum[2 * b + 1]));
+                    const float db = 20.0f * std::log10(mag / fullScale + 1e-9f);
+                    const float scaled = (db + 120.0f) * (255.0f / 120.0f);
+                    result.spectrogram.push_back(static_cast<uint8_t>(std::clamp(scaled, 0.0f, 255.0f)));
+                }
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Building and writing the sidecar
+// ---------------------------------------------------------------------------
+int64_t modifiedTime(const std::string& path) {
+    return static_cast<int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count());
+}
+
+int buildPeakFile(const std::string& path, bool withSpectrogram) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cerr << "Error: Could not open " << path << "\n";
+        return 1;
+    }
+    WavHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(WavHeader));
+    if (!in || header.bitsPerSample != 16 || header.numChannels == 0 || header.blockAlign != header.numChannels * 2) {
+        std::cerr << "Error: " << path << " is not a 16-bit PCM WAV file.\n";
+        return 1;
+    }
+    in.close();
+
+    const int channels = header.numChannels;
+    const uint64_t numFrames = header.subchunk2Size / header.blockAlign;
+    const uint64_t numChunks = (numFrames + chunkFrames - 1) / chunkFrames;
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    // Hand out whole chunks to each thread, so segment edges never split a bin
+    const unsigned numThreads = static_cast<unsigned>(std::max<uint64_t>(1, std::min<uint64_t>(std::thread::hardware_concurrency(), numChunks)));
+    std::vector<SegmentResult> results(numThreads);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < numThreads; ++t) {
+        const uint64_t firstChunk = numChunks * t / numThreads;
+        const uint64_t endChunk = numChunks * (t + 1) / numThreads;
+        const uint64_t first = firstChunk * chunkFrames;
+        const uint64_t end = std::min(numFrames, endChunk * chunkFrames);
+        threads.emplace_back(analyzeSegment, std::cref(path), std::cref(header), first, end, withSpectrogram, std::ref(results[t]));
+    }
+    for (std::thread& t : threads) t.join();
+
+    // Stitch the segments together (they are already in file order)
+    std::vector<std::vector<PeakBin>> levels(1);
+    std::vector<double> energy;
+    std::vector<uint64_t> chunkHashes;
+    std::vector<uint8_t> spectrogram;
+    for (SegmentResult& r : results) {
+        if (!r.ok) {
+            std::cerr << "Error: Failed to read audio data.\n";
+            return 1;
+        }
+        levels[0].insert(levels[0].end(), r.bins.begin(), r.bins.end());
+        energy.insert(energy.end(), r.sumSquares.begin(), r.sumSquares.end());
+        chunkHashes.insert(chunkHashes.end(), r.chunkHashes.begin(), r.chunkHashes.end());
+        spectrogram.insert(spectrogram.end(), r.spectrogram.begin(), r.spectrogram.end());
+    }
+
+    // Upper levels: each bin combines two bins from the level below.
+    // RMS is recomputed from exact energies so it doesn't drift with rounding.
+    uint64_t binFrames = baseBinSize;
+    while (levels.back().size() > static_cast<size_t>(channels)) {
+        const std::vector<PeakBin>& below = levels.back();
+        const size_t belowBins = below.size() / channels;
+        const size_t bins = (belowBins + 1) / 2;
+        std::vector<PeakBin> level(bins * channels);
+        std::vector<double> levelEnergy(bins * channels);
+        for (size_t b = 0; b < bins; ++b) {
+            const size_t left = 2 * b;
+            const size_t right = std::min(2 * b + 1, belowBins - 1);
+            // Frames covered by this bin (the last bin of a level may be partial)
+            const uint64_t frames = std::min<uint64_t>(binFrames * 2, numFrames - b * binFrames * 2);
+            for (int c = 0; c < channels; ++c) {
+                const PeakBin& a = below[left * channels + c];
+                const PeakBin& z = below[right * channels + c];
+                const double e = energy[left * channels + c] + (right != left ? energy[right * channels + c] : 0.0);
+                level[b * channels + c] = { std::min(a.minValue, z.minValue), std::max(a.maxValue, z.maxValue),
+                                            static_cast<uint16_t>(std::lround(std::sqrt(e / frames))) };
+                levelEnergy[b * channels + c] = e;
+            }
+        }
+        levels.push_back(std::move(level));
+        energy = std::move(levelEnergy);
+        binFrames *= 2;
+    }
+
+    // Combine chunk hashes in order
+    const uint64_t contentHash = combineChunkHashes(chunkHashes, numFrames, header.sampleRate);
+
+    // Write the sidecar: header, one uint64 bin count per level, then each level, then the spectrogram
+    PeakFileHeader peakHeader{};
+    std::memcpy(peakHeader.magic, "MDPK", 4);
+    peakHeader.version = 1;
+    peakHeader.contentHash = contentHash;
+    peakHeader.sourceSize = std::filesystem::file_size(path);
+    peakHeader.sourceModified = modifiedTime(path);
+    peakHeader.sampleRate = header.sampleRate;
+    peakHeader.numChannels = channels;
+    peakHeader.numFrames = numFrames;
+    peakHeader.baseBinSize = baseBinSize;
+    peakHeader.numLevels = static_cast<uint32_t>(levels.size());
+    peakHeader.spectrogramFrames = static_cast<uint32_t>(spectrogram.size() / spectrogramBands);
+    peakHeader.spectrogramFftSize = fftSize;
+    peakHeader.spectrogramBands = spectrogramBands;
+
+    const std::string peakPath = path + ".peaks";
+    std::ofstream out(peakPath, std::ios::binary);
+    if (!out) {
+        std::cerr << "Error: Could not open " << peakPath << "\n";
+        return 1;
+    }
+    out.write(reinterpret_cast<const char*>(&peakHeader), sizeof(peakHeader));
+    for (const std::vector<PeakBin>& level : levels) {
+        const uint64_t count = level.size() / channels;
+        out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    }
+    for (const std::vector<PeakBin>& level : levels) {
+        out.write(reinterpret_cast<const char*>(level.data()), level.size() * sizeof(PeakBin));
+    }
+    out.write(reinterpret_cast<const char*>(spectrogram.data()), spectrogram.size());
+    out.close();
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    const double audioSeconds = static_cast<double>(numFrames) / header.sampleRate;
+    std::printf("Wrote %s: %u levels, %u spectrogram frames, %llu bytes, hash %016llx\n", peakPath.c_str(), peakHeader.numLevels,
+                peakHeader.spectrogramFrames, static_cast<unsigned long long>(std::filesystem::file_size(peakPath)),
+                static_cast<unsigned long long>(contentHash));
+    std::printf("Generated in %.4f s with %u thread(s) (%.0fx realtime)\n", seconds, numThreads, audioSeconds / seconds);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Freshness: is the sidecar still about this audio?
+// ---------------------------------------------------------------------------
+
+// Hashes the audio of a WAV the same way buildPeakFile does (one thread is
+// plenty here: this only runs when the metadata check fails)
+bool hashAudioFile(const std::string& path, uint64_t& contentHash) {
+    std::ifstream in(path, std::ios::binary);
+    WavHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(WavHeader));
+    if (!in || header.bitsPerSample != 16 || header.numChannels == 0 || header.blockAlign != header.numChannels * 2) return false;
+    const uint64_t numFrames = header.subchunk2Size / header.blockAlign;
+    std::vector<uint8_t> chunk(chunkFrames * header.blockAlign);
+    std::vector<uint64_t> chunkHashes;
+    for (uint64_t start = 0; start < numFrames; start += chunkFrames) {
+        const uint64_t bytes = std::min<uint64_t>(chunkFrames, numFrames - start) * header.blockAlign;
+        in.read(reinterpret_cast<char*>(chunk.data()), static_cast<std::streamsize>(bytes));
+        if (static_cast<uint64_t>(in.gcount()) != bytes) return false;
+        chunkHashes.push_back(hashBytes(chunk.data(), bytes, start));
+    }
+    contentHash = combineChunkHashes(chunkHashes, numFrames, header.sampleRate);
+    return true;
+}
+
+bool readPeakHeader(const std::string& peakPath, PeakFileHeader& h) {
+    std::ifstream in(peakPath, std::ios::binary);
+    in.read(reinterpret_cast<char*>(&h), sizeof(h));
+    return in && std::memcmp(h.magic, "MDPK", 4) == 0 && h.version == 1;
+}
+
+// Makes sure the sidecar matches the audio, rebuilding it if it doesn't
+bool ensureFresh(const std::string& path, const std::string& peakPath, const PeakFileHeader& h) {
+    // Cheap check first: file metadata only
+    std::error_code ec;
+    const uint64_t size = std::filesystem::file_size(path, ec);
+    if (ec) {
+        std::cerr << "Error: Could not open " << path << "\n";
+        return false;
+    }
+    const int64_t modified = modifiedTime(path);
+    if (size == h.sourceSize && modified == h.sourceModified) return true;
+
+    // The metadata changed, so compare the content itself
+    uint64_t contentHash = 0;
+    if (hashAudioFile(path, contentHash) && contentHash == h.contentHash) {
+        // Same audio (touched or copied): remember the new metadata so the
+        // next query takes the cheap path again
+        PeakFileHeader updated = h;
+        updated.sourceSize = size;
+        updated.sourceModified = modified;
+        std::fstream out(peakPath, std::ios::binary | std::ios::in | std::ios::out);
+        out.write(reinterpret_cast<const char*>(&updated), sizeof(updated));
+        return true;
+    }
+    std::cerr << "Note: " << path << " changed since its peak file was built; rebuilding it.\n";
+    return buildPeakFile(path, h.spectrogramFrames > 0) == 0;
+}
+
+// ---------------------------------------------------------------------------
+// Queries: read only the sidecar
+// ---------------------------------------------------------------------------
+// Opens the (fresh) sidecar for a WAV and reads its header and level sizes
+bool openPeakFile(const std::string& path, std::ifstream& in, PeakFileHeader& h, std::vector<uint64_t>& levelBins) {
+    const std::string peakPath = path + ".peaks";
+    if (!std::filesystem::exists(peakPath)) {
+        std::cerr << "Error: No peak file for " << path << " (run build first)\n";
+        return false;
+    }
+    if (!readPeakHeader(peakPath, h)) {
+        std::cerr << "Error: " << peakPath << " is not a valid peak file\n";
+        return false;
+    }
+    if (!ensureFresh(path, peakPath, h)) return false;
+
+    // Open it only now: ensureFresh may have rewritten it
+    in.open(peakPath, std::ios::binary);
+    in.read(reinterpret_cast<char*>(&h), sizeof(h));
+    levelBins.assign(h.numLevels, 0);
+    in.read(reinterpret_cast<char*>(levelBins.data()), h.numLevels * sizeof(uint64_t));
+    if (!in) {
+        std::cerr << "Error: Could not open " << peakPath << "\n";
+        return false;
+    }
+    return true;
+}
+
+int queryPeakFile(const std::string& path, double startSeconds, double endSeconds, int pixels) {
+    std::ifstream in;
+    PeakFileHeader h{};
+    std::vector<uint64_t> levelBins;
+    if (!openPeakFile(path, in, h, levelBins)) return 1;
+
+    // Clamp in double first: a huge time would overflow the cast
+    const double fileFrames = static_cast<double>(h.numFrames);
+    const uint64_t firstFrame = static_cast<uint64_t>(std::min(std::max(0.0, startSeconds) * h.sampleRate, fileFrames));
+    const uint64_t lastFrame = static_cast<uint64_t>(std::min(endSeconds * h.sampleRate, fileFrames));
+    if (lastFrame <= firstFrame || pixels <= 0) {
+        std::cerr << "Error: Empty query range\n";
+        return 1;
+    }
+    const double framesPerPixel = static_cast<double>(lastFrame - firstFrame) / pixels;
+
+    // Pick the coarsest level whose bins still fit inside one pixel
+    uint32_t level = 0;
+    while (level + 1 < h.numLevels && (static_cast<double>(h.baseBinSize) * (2u << level)) <= framesPerPixel) ++level;
+    const uint64_t binFrames = static_cast<uint64_t>(h.baseBinSize) << level;
+
+    // Seek straight to the bins we need
+    uint64_t offset = sizeof(PeakFileHeader) + h.numLevels * sizeof(uint64_t);
+    for (uint32_t l = 0; l < level; ++l) offset += levelBins[l] * h.numChannels * sizeof(PeakBin);
+    const uint64_t firstBin = firstFrame / binFrames;
+    const uint64_t endBin = std::min(levelBins[level], (lastFrame + binFrames - 1) / binFrames);
+    std::vector<PeakBin> bins((endBin - firstBin) * h.numChannels);
+    in.seekg(static_cast<std::streamoff>(offset + firstBin * h.numChannels * sizeof(PeakBin)));
+    in.read(reinterpret_cast<char*>(bins.data()), bins.size() * sizeof(PeakBin));
+
+    std::printf("Query %.2f-%.2f s into %d px: level %u (%llu frames/bin), %zu bins read\n", startSeconds, endSeconds, pixels,
+                level, static_cast<unsigned long long>(binFrames), bins.size());
+
+    // Fold the bins into pixels (channel 0 shown; the others work the same way)
+    for (int p = 0; p < pixels; ++p) {
+        const uint64_t pStart = firstFrame + static_cast<uint64_t>(p * framesPerPixel);
+        const uint64_t pEnd = firstFrame + static_cast<uint64_t>((p + 1) * framesPerPixel);
+        const uint64_t b0 = pStart / binFrames - firstBin;
+        const uint64_t b1 = std::max(b0 + 1, (pEnd + binFrames - 1) / binFrames - firstBin);
+        int lo = 32767, hi = -32768;
+        double energy = 0.0;
+        uint64_t count = 0;
+        for (uint64_t b = b0; b < b1 && b < endBin - firstBin; ++b) {
+            const PeakBin& bin = bins[b * h.numChannels];
+            lo = std::min<int>(lo, bin.minValue);
+            hi = std::max<int>(hi, bin.maxValue);
+            energy += static_cast<double>(bin.rms) * bin.rms;
+            ++count;
+        }
+        if (pixels <= 16 || p % (pixels / 16) == 0) {
+            std::printf("  px %4d: min %6d  max %6d  rms %7.1f\n", p, lo, hi, count ? std::sqrt(energy / count) : 0.0);
+        }
+    }
+    return 0;
+}
+
+// Spectrogram query: for each column, the loudest band over the frames it
+// covers. Like the peak query it reads only the part of the sidecar it needs.
+int querySpectrogram(const std::string& path, double startSeconds, double endSeconds, int columns) {
+    std::ifstream in;
+    PeakFileHeader h{};
+    std::vector<uint64_t> levelBins;
+    if (!openPeakFile(path, in, h, levelBins)) return 1;
+    if (h.spectrogramFrames == 0) {
+        std::cerr << "Error: " << path << ".peaks has no spectrogram (build it with --spectrogram)\n";
+        return 1;
+    }
+
+    const uint64_t fftFrames = h.spectrogramFftSize;
+    const double fileFrames = static_cast<double>(h.numFrames);
+    const uint64_t firstFrame = static_cast<uint64_t>(std::min(startSeconds * h.sampleRate, fileFrames)) / fftFrames;
+    const uint64_t endFrame = std::min<uint64_t>(h.spectrogramFrames,
+                                                 (static_cast<uint64_t>(std::min(endSeconds * h.sampleRate, fileFrames)) + fftFrames - 1) / fftFrames);
+    if (endFrame <= firstFrame) {
+        std::cerr << "Error: Empty query range\n";
+        return 1;
+    }
+
+    // The spectrogram comes after every level of the pyramid
+    uint64_t offset = sizeof(PeakFileHeader) + h.numLevels * sizeof(uint64_t);
+    for (uint32_t l = 0; l < h.numLevels; ++l) offset += levelBins[l] * h.numChannels * sizeof(PeakBin);
+    std::vector<uint8_t> frames((endFrame - firstFrame) * h.spectrogramBands);
+    in.seekg(static_cast<std::streamoff>(offset + firstFrame * h.spectrogramBands));
+    in.read(reinterpret_cast<char*>(frames.data()), static_cast<std::streamsize>(frames.size()));
+    if (!in) {
+        std::cerr << "Error: " << path << ".peaks is truncated\n";
+        return 1;
+    }
+
+    std::printf("Spectrogram %.2f-%.2f s into %d columns: %llu frames read\n", startSeconds, endSeconds, columns,
+                static_cast<unsigned long long>(endFrame - firstFrame));
+    const double framesPerColumn = static_cast<double>(endFrame - firstFrame) / columns;
+    const double binHz = static_cast<double>(h.sampleRate) / fftFrames;
+    for (int col = 0; col < columns; ++col) {
+        const uint64_t f0 = static_cast<uint64_t>(col * framesPerColumn);
+        const uint64_t f1 = std::max(f0 + 1, static_cast<uint64_t>((col + 1) * framesPerColumn));
+        int loudestBand = 0, loudest = -1;
+        for (uint64_t f = f0; f < f1 && f < endFrame - firstFrame; ++f) {
+            for (uint32_t b = 0; b < h.spectrogramBands; ++b) {
+                const int v = frames[f * h.spectrogramBands + b];
+                if (v > loudest) {
+                    loudest = v;
+                    loudestBand = static_cast<int>(b);
+                }
+            }
+        }
+        if (columns <= 16 || col % (columns / 16) == 0) {
+            // Band b kept the louder of FFT bins 2b and 2b + 1. Undo the
+            // -120..0 dBFS -> 0..255 mapping from analyzeSegment.
+            std::printf("  col %4d: loudest band %3d (~%6.0f Hz) at %6.1f dBFS\n", col, loudestBand,
+                        (2 * loudestBand + 0.5) * binHz, loudest * (120.0 / 255.0) - 120.0);
+        }
+    }
+    return 0;
+}
+
+// Parses "start end count" for both queries. Everything must be a plain
+// number, the range must run forwards and the count must be positive.
+bool parseQuery(char* argv[], double& startSeconds, double& endSeconds, int& count) {
+    char* stop = nullptr;
+    startSeconds = std::strtod(argv[0], &stop);
+    if (*argv[0] == '\0' || *stop != '\0' || !std::isfinite(startSeconds) || startSeconds < 0.0) return false;
+    endSeconds = std::strtod(argv[1], &stop);
+    if (*argv[1] == '\0' || *stop != '\0' || !std::isfinite(endSeconds) || endSeconds <= startSeconds) return false;
+    const long n = std::strtol(argv[2], &stop, 10);
+    if (*argv[2] == '\0' || *stop != '\0' || n <= 0 || n > 1000000) return false;
+    count = static_cast<int>(n);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 2 && std::string(argv[1]) == "build") {
+        bool withSpectrogram = false;
+        std::string path;
+        for (int i = 2; i < argc; ++i) {
+            if (std::string(argv[i]) == "--spectrogram") withSpectrogram = true;
+            else path = argv[i];
+        }
+        if (path.empty()) {
+            std::cerr << "Usage: peak_cache build [--spectrogram] file.wav\n";
+            return 1;
+        }
+        return buildPeakFile(path, withSpectrogram);
+    }
+
+    const char* usage = "Usage:\n  peak_cache build [--spectrogram] file.wav\n  peak_cache query file.wav start end pixels\n"
+                        "  peak_cache spectrogram file.wav start end columns\n";
+    if (argc == 6 && (std::string(argv[1]) == "query" || std::string(argv[1]) == "spectrogram")) {
+        double startSeconds = 0.0, endSeconds = 0.0;
+        int count = 0;
+        if (!parseQuery(argv + 3, startSeconds, endSeconds, count)) {
+            std::cerr << "Error: Bad query \"" << argv[3] << " " << argv[4] << " " << argv[5]
+                      << "\" (start and end in seconds with start < end, then a positive count)\n" << usage;
+            return 1;
+        }
+        if (std::string(argv[1]) == "query") return queryPeakFile(argv[2], startSeconds, endSeconds, count);
+        return querySpectrogram(argv[2], startSeconds, endSeconds, count);
+    }
+
+    if (argc > 1) {
+        std::cerr << usage;
+        return 1;
+    }
+
+    // Default demo
+    if (buildPeakFile("input.wav", true) != 0)
+        return 1;
+    if (queryPeakFile("input.wav", 0.0, 2.0, 16) != 0)
+        return 1;
+    return querySpectrogram("input.wav", 0.0, 2.0, 8);
+}
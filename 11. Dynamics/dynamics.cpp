@@ -0,0 +1,489 @@
+/*
+    MicroDSP - Day 11: Dynamics (Gate, Compressor, Lookahead Limiter)
+
+    What this program does:
+    - Reads a 16-bit PCM WAV file: input.wav
+    - Boosts it by +6 dB (enough that gain_processor.cpp would hard clip)
+    - Runs it through a noise gate, a compressor and a brickwall limiter
+    - Writes the result to: output_dynamics.wav
+    - Checks that the limiter holds its ceiling on its own (measured before
+      the final rounding clamp, so the clamp can't hide a limiter bug), that
+      the result is identical for different block sizes, and prints the
+      cost of each stage
+
+    The three processors:
+    - Noise gate: mutes the signal when it falls below a threshold
+      (with hysteresis and a hold time so it doesn't chatter).
+    - Compressor: turns the level down by "ratio" once it goes over a
+      threshold, following the level with attack/release smoothing.
+    - Lookahead limiter: guarantees the output NEVER goes over the ceiling.
+      It delays the audio by a few milliseconds (using a circular buffer
+      exactly like circular_buffers.cpp) so it can see peaks coming and
+      fade the gain down BEFORE they arrive, instead of clipping them.
+
+    Sliding-window maximum:
+    The limiter needs "the loudest sample in the last L samples" for every
+    sample. Re-scanning L samples each time costs O(L). A monotonic deque
+    keeps only samples that could still become the maximum (each one is
+    louder than everything after it), so the front is always the answer and
+    each sample is pushed and popped at most once: O(1) on average.
+
+    Block processing:
+    Each stage first computes a gain value for every sample in the block,
+    then multiplies the audio by that gain array in a separate simple loop.
+    The envelope followers are recursive (each sample depends on the last)
+    so they run sample by sample, but the level detection, dB conversion,
+    gain computer and gain application are plain array loops that the
+    compiler vectorizes (g++ -O3 -march=native). Everything is single
+    threaded float math with no randomness, so the output is deterministic.
+
+    Build:
+        g++ -std=c++17 -O3 -march=native dynamics.cpp -o dynamics
+
+    Author: Jesse Whiting (GhostWire Audio)
+    GitHub: ghostwireaudio
+*/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+// Force the compiler to pack the struct exactly as written
+// with no padding bytes added for alignment, which ensures
+// sizeof(WavHeader) == 44 bytes
+#pragma pack(push, 1)
+struct WavHeader {
+    // RIFF Chunk Descriptor
+    char     riff[4];        // "RIFF"
+    uint32_t chunkSize;      // 36 + Subchunk2Size
+    char     wave[4];        // "WAVE"
+
+    // fmt subchunk
+    char     fmt[4];         // "fmt "
+    uint32_t subchunk1Size;  // 16 for PCM
+    uint16_t audioFormat;    // 1 for PCM
+    uint16_t numChannels;    // 1 for mono
+    uint32_t sampleRate;     // e.g., 44100
+    uint32_t byteRate;       // sampleRate * numChannels * bitsPerSample/8
+    uint16_t blockAlign;     // numChannels * bitsPerSample/8
+    uint16_t bitsPerSample;  // 16
+
+    // data subchunk
+    char     data[4];        // "data"
+    uint32_t subchunk2Size;  // NumSamples * numChannels * bitsPerSample/8
+};
+#pragma pack(pop)
+
+const int maxBlockSize = 1024;
+
+// Turns a time constant in milliseconds into a one-pole smoothing coefficient
+float timeToCoeff(float ms, float sampleRate) {
+    if (ms <= 0.0f) return 0.0f;
+    return std::exp(-1.0f / (0.001f * ms * sampleRate));
+}
+
+// Computes the linked "detector" signal: the loudest channel at each sample.
+// Linking keeps the stereo image stable (both channels get the same gain).
+void detectPeak(const std::vector<float*>& channels, float* level, int n) {
+    std::fill(level, level + n, 0.0f);
+    for (const float* ch : channels) {
+        for (int i = 0; i < n; ++i) level[i] = std::max(level[i], std::fabs(ch[i]));
+    }
+}
+
+void applyGain(const std::vector<float*>& channels, const float* gain, int n) {
+    for (float* ch : channels) {
+        for (int i = 0; i < n; ++i) ch[i] *= gain[i];
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Noise gate
+// ---------------------------------------------------------------------------
+struct NoiseGate {
+    float openThresholdDb = -50.0f;  // Opens above this level
+    float closeThresholdDb = -56.0f; // Closes below this (hysteresis stops chattering)
+    float holdMs = 50.0f;            // Stays open this long after the level drops
+    float attackMs = 1.0f;           // Fade-in time when opening
+    float releaseMs = 80.0f;         // Fade-out time when closing
+    float floorDb = -80.0f;          // Gain when fully closed
+
+    // State
+    float envelope = 0.0f;
+    float gain = 0.0f;
+    bool open = false;
+    int holdCounter = 0;
+
+    // Derived
+    float openLevel = 0, closeLevel = 0, floorGain = 0, envCoeff = 0, attackCoeff = 0, releaseCoeff = 0;
+    int holdSamples = 0;
+    std::vector<float> level = std::vector<float>(maxBlockSize);
+    std::vector<float> gains = std::vector<float>(maxBlockSize);
+
+    void prepare(float sampleRate) {
+        openLevel = std::pow(10.0f, openThresholdDb / 20.0f);
+        closeLevel = std::pow(10.0f, closeThresholdDb / 20.0f);
+        floorGain = std::pow(10.0f, floorDb / 20.0f);
+        envCoeff = timeToCoeff(5.0f, sampleRate);
+        attackCoeff = timeToCoeff(attackMs, sampleRate);
+        releaseCoeff = timeToCoeff(releaseMs, sampleRate);
+        holdSamples = static_cast<int>(holdMs * 0.001f * sampleRate);
+        envelope = 0.0f;
+        gain = floorGain;
+        open = false;
+        holdCounter = 0;
+    }
+
+    void process(const std::vector<float*>& channels, int n) {
+        detectPeak(channels, level.data(), n);
+        for (int i = 0; i < n; ++i) {
+            // Peak envelope: jump up instantly, decay smoothly
+            envelope = std::max(level[i], envelope * envCoeff);
+
+            if (envelope >= openLevel) {
+                open = true;
+                holdCounter = holdSamples;
+            } else if (envelope < closeLevel) {
+                if (holdCounter > 0) --holdCounter;
+                else open = false;
+            }
+
+            const float target = open ? 1.0f : floorGain;
+            const float coeff = (target > gain) ? attackCoeff : releaseCoeff;
+            gain = target + coeff * (gain - target);
+            gains[i] = gain;
+        }
+        applyGain(channels, gains.data(), n);
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Compressor (feed-forward, soft knee)
+// ---------------------------------------------------------------------------
+struct Compressor {
+    float thresholdDb = -12.0f;
+    float ratio = 4.0f;
+    float kneeDb = 6.0f;
+    float attackMs = 5.0f;
+    float releaseMs = 120.0f;
+    float makeupDb = 3.0f;
+
+    // State: smoothed gain reduction in dB (<= 0)
+    float reductionDb = 0.0f;
+
+    float attackCoeff = 0, releaseCoeff = 0, makeup = 1;
+    std::vector<float> level = std::vector<float>(maxBlockSize);
+    std::vector<float> target = std::vector<float>(maxBlockSize);
+    std::vector<float> gains = std::vector<float>(maxBlockSize);
+
+    void prepare(float sampleRate) {
+        attackCoeff = timeToCoeff(attackMs, sampleRate);
+        releaseCoeff = timeToCoeff(releaseMs, sampleRate);
+        makeup = std::pow(10.0f, makeupDb / 20.0f);
+        reductionDb = 0.0f;
+    }
+
+    void process(const std::vector<float*>& channels, int n) {
+        detectPeak(channels, level.data(), n);
+
+        // Gain computer (vectorizable): how many dB to turn down for each sample
+        const float slope = 1.0f / ratio - 1.0f;
+        const float halfKnee = 0.5f * kneeDb;
+        for (int i = 0; i < n; ++i) {
+            const float db = 20.0f * std::log10(level[i] + 1e-9f);
+            const float over = db - thresholdDb;
+            // Below the knee: 0. Above the knee: slope * over. Inside: a smooth quadratic blend.
+            const float inKnee = slope * (over + halfKnee) * (over + halfKnee) / (2.0f * kneeDb);
+            float g = (over <= -halfKnee) ? 0.0f : inKnee;
+            g = (over >= halfKnee) ? slope * over : g;
+            target[i] = g;
+        }
+
+        // Envelope follower on the gain reduction (serial)
+        for (int i = 0; i < n; ++i) {
+            // More reduction needed -> attack; less -> release
+            const float coeff = (target[i] < reductionDb) ? attackCoeff : releaseCoeff;
+            reductionDb = target[i] + coeff * (reductionDb - target[i]);
+            gains[i] = reductionDb;
+        }
+
+        // Back to linear gain (vectorizable)
+        for (int i = 0; i < n; ++i) gains[i] = std::pow(10.0f, gains[i] * 0.05f) * makeup;
+        applyGain(channels, gains.data(), n);
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Brickwall lookahead limiter
+// ---------------------------------------------------------------------------
+struct LookaheadLimiter {
+    float ceilingDb = -1.0f;
+    float lookaheadMs = 5.0f;
+    float releaseMs = 60.0f;
+
+    // Derived
+    int lookahead = 0;     // L, in samples
+    float ceiling = 1.0f;
+    float releaseCoeff = 0.0f;
+
+    // Lookahead delay: one circular buffer per channel (see circular_buffers.cpp)
+    std::vector<std::vector<float>> delayBuffers;
+    int writeIndex = 0;
+
+    // Monotonic deque for the sliding-window maximum, stored in a fixed
+    // ring buffer so the audio thread never allocates
+    std::vector<int64_t> dequeIndex;
+    std::vector<float> dequeValue;
+    int dequeHead = 0, dequeSize = 0;
+    int64_t sampleCounter = 0;
+
+    // Moving average over the last L + 1 held gains
+    std::vector<float> averageBuffer;
+    int averageIndex = 0;
+    double averageSum = 0.0;
+    float releasedGain = 1.0f;
+
+    // Loudest output sample BEFORE the safety clamp, for the self-check
+    float peakBeforeClamp = 0.0f;
+
+    std::vector<float> level = std::vector<float>(maxBlockSize);
+    std::vector<float> gains = std::vector<float>(maxBlockSize);
+
+    void prepare(float sampleRate, int numChannels) {
+        lookahead = std::max(1, static_cast<int>(lookaheadMs * 0.001f * sampleRate));
+        ceiling = std::pow(10.0f, ceilingDb / 20.0f);
+        releaseCoeff = timeToCoeff(releaseMs, sampleRate);
+
+        delayBuffers.assign(numChannels, std::vector<float>(lookahead, 0.0f));
+        writeIndex = 0;
+        dequeIndex.assign(lookahead + 1, 0);
+        dequeValue.assign(lookahead + 1, 0.0f);
+        dequeHead = 0;
+        dequeSize = 0;
+        sampleCounter = 0;
+        averageBuffer.assign(lookahead + 1, 1.0f);
+        averageIndex = 0;
+        averageSum = lookahead + 1.0;
+        releasedGain = 1.0f;
+        peakBeforeClamp = 0.0f;
+    }
+
+    int latency() const { return lookahead; }
+
+    // Sliding maximum of |x| over the window [n - L, n]
+    float pushAndGetMax(float value) {
+        const int capacity = lookahead + 1;
+        // Drop the front once it slides out of the window (done first, so
+        // the deque never holds more than L + 1 entries)
+        if (dequeSize > 0 && dequeIndex[dequeHead] < sampleCounter - lookahead) {
+            dequeHead = (dequeHead + 1) % capacity;
+            --dequeSize;
+        }
+        // Drop samples from the back that can never be the max again
+        while (dequeSize > 0 && dequeValue[(dequeHead + dequeSize - 1) % capacity] <= value) --dequeSize;
+        const int slot = (dequeHead + dequeSize) % capacity;
+        dequeIndex[slot] = sampleCounter;
+        dequeValue[slot] = value;
+        ++dequeSize;
+        ++sampleCounter;
+        return dequeValue[dequeHead];
+    }
+
+    void process(const std::vector<float*>& channels, int n) {
+        detectPeak(channels, level.data(), n);
+
+        for (int i = 0; i < n; ++i) {
+            // 1) Gain needed so the loudest sample in the lookahead window hits the ceiling
+            const float peak = pushAndGetMax(level[i]);
+            const float needed = (peak > ceiling) ? ceiling / peak : 1.0f;
+
+            // 2) Release: recover slowly, but never above what is needed
+            releasedGain = std::min(needed, 1.0f + releaseCoeff * (releasedGain - 1.0f));
+
+            // 3) Average over L + 1 samples. Every held value covering a peak is
+            //    <= that peak's needed gain, so the average is too: brickwall.
+            averageSum += releasedGain - averageBuffer[averageIndex];
+            averageBuffer[averageIndex] = releasedGain;
+            if (++averageIndex > lookahead) averageIndex = 0;
+            gains[i] = static_cast<float>(averageSum / (lookahead + 1));
+        }
+
+        // Delay the audio by L samples so the gain lines up with the peak it was computed for
+        for (size_t c = 0; c < channels.size(); ++c) {
+            float* ch = channels[c];
+            std::vector<float>& buffer = delayBuffers[c];
+            int w = writeIndex;
+            for (int i = 0; i < n; ++i) {
+                const float delayed = buffer[w];
+                buffer[w] = ch[i];
+                ch[i] = delayed;
+                if (++w >= lookahead) w = 0;
+            }
+        }
+        writeIndex = static_cast<int>((writeIndex + n) % lookahead);
+
+        applyGain(channels, gains.data(), n);
+
+        // Safety net for float rounding in the running sum: never exceed the
+        // ceiling. The peak is taken first, so a real overshoot still shows up.
+        for (float* ch : channels) {
+            for (int i = 0; i < n; ++i) {
+                peakBeforeClamp = std::max(peakBeforeClamp, std::fabs(ch[i]));
+                ch[i] = std::clamp(ch[i], -ceiling, ceiling);
+            }
+        }
+    }
+};
+
+// ---------------------------------------------------------------------------
+// The full chain, rendered offline
+// ---------------------------------------------------------------------------
+struct Chain {
+    NoiseGate gate;
+    Compressor compressor;
+    LookaheadLimiter limiter;
+    double stageSeconds[3] = { 0.0, 0.0, 0.0 };
+
+    void prepare(float sampleRate, int numChannels) {
+        gate.prepare(sampleRate);
+        compressor.prepare(sampleRate);
+        limiter.prepare(sampleRate, numChannels);
+    }
+
+    void process(const std::vector<float*>& channels, int n) {
+        auto t0 = std::chrono::steady_clock::now();
+        gate.process(channels, n);
+        auto t1 = std::chrono::steady_clock::now();
+        compressor.process(channels, n);
+        auto t2 = std::chrono::steady_clock::now();
+        limiter.process(channels, n);
+        auto t3 = std::chrono::steady_clock::now();
+        stageSeconds[0] += std::chrono::duration<double>(t1 - t0).count();
+        stageSeconds[1] += std::chrono::duration<double>(t2 - t1).count();
+        stageSeconds[2] += std::chrono::duration<double>(t3 - t2).count();
+    }
+};
+
+// planar[c][frame], values in [-1, 1). Returns the processed, latency-compensated audio.
+std::vector<std::vector<float>> render(Chain& chain, const std::vector<std::vector<float>>& planar, float sampleRate, int blockSize) {
+    const int numChannels = static_cast<int>(planar.size());
+    const size_t numFrames = planar[0].size();
+    chain.prepare(sampleRate, numChannels);
+    const size_t latency = chain.limiter.latency();
+
+    // Pad with "latency" frames of silence so the delayed tail comes out
+    std::vector<std::vector<float>> work(numChannels);
+    for (int c = 0; c < numChannels; ++c) {
+        work[c] = planar[c];
+        work[c].resize(numFrames + latency, 0.0f);
+    }
+
+    std::vector<float*> pointers(numChannels);
+    for (size_t start = 0; start < numFrames + latency; start += blockSize) {
+        const int n = static_cast<int>(std::min<size_t>(blockSize, numFrames + latency - start));
+        for (int c = 0; c < numChannels; ++c) pointers[c] = work[c].data() + start;
+        chain.process(pointers, n);
+    }
+
+    // Remove the lookahead delay so the output lines up with the input
+    for (int c = 0; c < numChannels; ++c) work[c].erase(work[c].begin(), work[c].begin() + latency);
+    return work;
+}
+
+int main() {
+    const char* inputPath = "input.wav";
+    const char* outputPath = "output_dynamics.wav";
+
+    const float inputGainDb = 6.0f; // Drive the chain hard so the limiter has work to do
+
+    std::ifstream in(inputPath, std::ios::binary);
+    if (!in) {
+        std::cerr << "Error: Could not open input file.\n";
+        return 1;
+    }
+
+    WavHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(WavHeader));
+    if (!in || header.bitsPerSample != 16) {
+        std::cerr << "Error: Failed to read a 16-bit WAV header.\n";
+        return 1;
+    }
+
+    const int numChannels = header.numChannels;
+    const size_t numFrames = header.subchunk2Size / header.blockAlign;
+    std::vector<int16_t> input(numFrames * numChannels);
+    in.read(reinterpret_cast<char*>(input.data()), input.size() * sizeof(int16_t));
+    if (!in) {
+        std::cerr << "Error: Failed to read audio data.\n";
+        return 1;
+    }
+    in.close();
+
+    // De-interleave into float channels, applying the input boost
+    const float inputGain = std::pow(10.0f, inputGainDb / 20.0f);
+    std::vector<std::vector<float>> planar(numChannels, std::vector<float>(numFrames));
+    for (size_t i = 0; i < numFrames; ++i) {
+        for (int c = 0; c < numChannels; ++c) planar[c][i] = input[i * numChannels + c] / 32768.0f * inputGain;
+    }
+
+    Chain chain;
+    const std::vector<std::vector<float>> processed = render(chain, planar, static_cast<float>(header.sampleRate), maxBlockSize);
+
+    // Write output
+    std::vector<int16_t> output(numFrames * numChannels);
+    float outputPeak = 0.0f;
+    for (size_t i = 0; i < numFrames; ++i) {
+        for (int c = 0; c < numChannels; ++c) {
+            const float v = processed[c][i];
+            outputPeak = std::max(outputPeak, std::fabs(v));
+            output[i * numChannels + c] = static_cast<int16_t>(std::clamp(v * 32768.0f, -32768.0f, 32767.0f));
+        }
+    }
+
+    std::ofstream out(outputPath, std::ios::binary);
+    if (!out) {
+        std::cerr << "Error: Could not open output file.\n";
+        return 1;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(WavHeader));
+    out.write(reinterpret_cast<const char*>(output.data()), output.size() * sizeof(int16_t));
+    out.close();
+
+    // The limiter must hold the ceiling by itself. Only float rounding is
+    // left for the clamp to catch (allowed up to 10 parts per million, far
+    // below one 16-bit step).
+    const float limiterPeak = chain.limiter.peakBeforeClamp;
+    const bool underCeiling = limiterPeak <= chain.limiter.ceiling * (1.0f + 1e-5f);
+    std::printf("Wrote %s\n", outputPath);
+    std::printf("Output peak: %.2f dBFS, limiter peak before clamp: %.2f dBFS (ceiling %.2f dBFS) -> %s\n",
+                20.0 * std::log10(outputPeak + 1e-12), 20.0 * std::log10(limiterPeak + 1e-12),
+                chain.limiter.ceilingDb, underCeiling ? "PASS" : "FAIL");
+
+    // Determinism: a different block size must give exactly the same samples
+    Chain other;
+    const bool identical = render(other, planar, static_cast<float>(header.sampleRate), 37) == processed;
+    std::printf("Block-size determinism check: %s\n", identical ? "PASS" : "FAIL");
+
+    // Cost per stage, measured over repeated renders
+    Chain bench;
+    int runs = 0;
+    double total = 0.0;
+    while (total < 0.1) {
+        const auto t0 = std::chrono::steady_clock::now();
+        render(bench, planar, static_cast<float>(header.sampleRate), maxBlockSize);
+        total += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        ++runs;
+    }
+    const double samples = static_cast<double>(numFrames) * runs;
+    const char* names[3] = { "gate", "compressor", "limiter" };
+    for (int s = 0; s < 3; ++s) {
+        std::printf("%-11s %7.2f ns/frame\n", names[s], bench.stageSeconds[s] * 1e9 / samples);
+    }
+
+    return (underCeiling && identical) ? 0 : 1;
+}
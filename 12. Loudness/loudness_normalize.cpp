@@ -0,0 +1,454 @@
+/*
+    MicroDSP - Day 12: Loudness Measurement and Normalization (EBU R128 / BS.1770)
+
+    What this program does:
+    - Measures a 16-bit PCM WAV file the way broadcasters do:
+        * Integrated loudness (whole programme, gated), in LUFS
+        * Maximum momentary (400 ms) and short-term (3 s) loudness
+        * True peak (4x oversampled), in dBTP
+    - Computes the gain that brings the file to a target loudness
+      (default -23 LUFS), backing off if that would push the true peak
+      above a ceiling (default -1 dBTP)
+    - Applies that gain with the same multiply-and-clamp loop as
+      gain_processor.cpp and writes: output_normalized.wav
+
+    How loudness is measured (ITU-R BS.1770):
+    1) "K-weighting": two biquad filters roughly model how our ears hear
+       (a high shelf that boosts the top end, and a high pass that ignores
+       rumble).
+    2) The filtered signal's mean square is measured in 400 ms blocks that
+       overlap by 75% (a new block every 100 ms).
+    3) Gating: blocks quieter than -70 LUFS are thrown away (silence), then
+       blocks more than 10 LU below the average of what's left are thrown
+       away too. The average of the surviving blocks is the integrated loudness.
+
+    Going multi-core without changing the answer:
+    Every 400 ms gating block is made of four 100 ms "sub-blocks", so each
+    thread only has to measure the energy of its own sub-blocks. Joining the
+    threads' results is just putting the sub-block lists end to end, so the
+    gating blocks that span two segments come out exactly as they would in
+    one serial pass. The only thing a thread can't know is the filter state
+    at the start of its segment, so each thread first runs the filters over
+    one second of audio BEFORE its segment ("pre-roll") and discards it. The
+    K-weighting filters forget their past much faster than that, so the only
+    difference left is double-precision rounding noise (around 1e-12 LU).
+    The program verifies this by comparing against a single-threaded pass.
+
+    Usage:
+        loudness_normalize [input.wav] [targetLUFS] [ceilingDbTP] [--verify]
+    With no arguments it normalizes input.wav to -23 LUFS and verifies the
+    parallel measurement against a serial one.
+
+    Build:
+        g++ -std=c++17 -O3 -march=native -pthread loudness_normalize.cpp -o loudness_normalize
+
+    Author: Jesse Whiting (GhostWire Audio)
+    GitHub: ghostwireaudio
+*/
+
+#define _USE_MATH_DEFINES
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+
+// Force the compiler to pack the struct exactly as written
+// with no padding bytes added for alignment, which ensures
+// sizeof(WavHeader) == 44 bytes
+#pragma pack(push, 1)
+struct WavHeader {
+    // RIFF Chunk Descriptor
+    char     riff[4];        // "RIFF"
+    uint32_t chunkSize;      // 36 + Subchunk2Size
+    char     wave[4];        // "WAVE"
+
+    // fmt subchunk
+    char     fmt[4];         // "fmt "
+    uint32_t subchunk1Size;  // 16 for PCM
+    uint16_t audioFormat;    // 1 for PCM
+    uint16_t numChannels;    // 1 for mono
+    uint32_t sampleRate;     // e.g., 44100
+    uint32_t byteRate;       // sampleRate * numChannels * bitsPerSample/8
+    uint16_t blockAlign;     // numChannels * bitsPerSample/8
+    uint16_t bitsPerSample;  // 16
+
+    // data subchunk
+    char     data[4];        // "data"
+    uint32_t subchunk2Size;  // NumSamples * numChannels * bitsPerSample/8
+};
+#pragma pack(pop)
+
+// ---------------------------------------------------------------------------
+// K-weighting filters
+// ---------------------------------------------------------------------------
+struct Biquad {
+    double b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+    double z1 = 0, z2 = 0; // Transposed direct form II state
+
+    inline double process(double x) {
+        const double y = b0 * x + z1;
+        z1 = b1 * x - a1 * y + z2;
+        z2 = b2 * x - a2 * y;
+        return y;
+    }
+};
+
+// The BS.1770 filters are specified at 48 kHz; these formulas re-derive
+// them for any sample rate (same approach as libebur128)
+void designKWeighting(double sampleRate, Biquad& shelf, Biquad& highPass) {
+    {
+        const double f0 = 1681.974450955533;
+        const double G = 3.999843853973347;
+        const double Q = 0.7071752369554196;
+        const double K = std::tan(M_PI * f0 / sampleRate);
+        const double Vh = std::pow(10.0, G / 20.0);
+        const double Vb = std::pow(Vh, 0.4996667741545416);
+        const double a0 = 1.0 + K / Q + K * K;
+        shelf.b0 = (Vh + Vb * K / Q + K * K) / a0;
+        shelf.b1 = 2.0 * (K * K - Vh) / a0;
+        shelf.b2 = (Vh - Vb * K / Q + K * K) / a0;
+        shelf.a1 = 2.0 * (K * K - 1.0) / a0;
+        shelf.a2 = (1.0 - K / Q + K * K) / a0;
+    }
+    {
+        const double f0 = 38.13547087602444;
+        const double Q = 0.5003270373238773;
+        const double K = std::tan(M_PI * f0 / sampleRate);
+        const double a0 = 1.0 + K / Q + K * K;
+        highPass.b0 = 1.0;
+        highPass.b1 = -2.0;
+        highPass.b2 = 1.0;
+        highPass.a1 = 2.0 * (K * K - 1.0) / a0;
+        highPass.a2 = (1.0 - K / Q + K * K) / a0;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// True-peak meter: 4x oversampling with a 48-tap polyphase interpolator
+// ---------------------------------------------------------------------------
+const int truePeakPhases = 4;
+const int truePeakTapsPerPhase = 12;
+
+struct TruePeakMeter {
+    float coeffs[truePeakPhases][truePeakTapsPerPhase];
+    float history[truePeakTapsPerPhase] = {};
+
+    TruePeakMeter() {
+        // Kaiser-windowed sinc low-pass at the original Nyquist, split into 4 phases
+        const int totalTaps = truePeakPhases * truePeakTapsPerPhase;
+        auto besselI0 = [](double x) {
+            double sum = 1.0, term = 1.0;
+            for (int k = 1; k < 50; ++k) {
+                term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                sum += term;
+            }
+            return sum;
+        };
+        const double beta = 7.0;
+        for (int i = 0; i < totalTaps; ++i) {
+            const double t = (i - (totalTaps - 1) / 2.0) / truePeakPhases;
+            const double sinc = (std::fabs(t) < 1e-12) ? 1.0 : std::sin(M_PI * t) / (M_PI * t);
+            const double r = 2.0 * i / (totalTaps - 1) - 1.0;
+            const double window = besselI0(beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / besselI0(beta);
+            coeffs[i % truePeakPhases][i / truePeakPhases] = static_cast<float>(sinc * window);
+        }
+    }
+
+    // Pushes one sample and returns the largest of its 4 interpolated values
+    inline float process(float x) {
+        // Shift the newest sample in (12 floats, cheaper than a ring buffer here)
+        for (int k = truePeakTapsPerPhase - 1; k > 0; --k) history[k] = history[k - 1];
+        history[0] = x;
+        float largest = 0.0f;
+        for (int p = 0; p < truePeakPhases; ++p) {
+            float y = 0.0f;
+            for (int k = 0; k < truePeakTapsPerPhase; ++k) y += coeffs[p][k] * history[k];
+            largest = std::max(largest, std::fabs(y));
+        }
+        return largest;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Segment analysis (one per thread)
+// ---------------------------------------------------------------------------
+struct SegmentStats {
+    std::vector<double> subBlockEnergy; // [subBlock][channel]: sum of squares of K-weighted samples
+    float truePeak = 0.0f;
+    float samplePeak = 0.0f;
+    bool ok = true;
+};
+
+// Measures the sub-blocks [firstSubBlock, endSubBlock) and the peaks of every
+// frame up to endFrame. The last segment passes the end of the file, so the
+// trailing partial sub-block is still peak-scanned but adds no energy.
+void analyzeSegment(const std::string& path, const WavHeader& header, uint64_t subBlockFrames,
+                    uint64_t firstSubBlock, uint64_t endSubBlock, uint64_t endFrame, SegmentStats& stats) {
+    const int channels = header.numChannels;
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        stats.ok = false;
+        return;
+    }
+
+    const uint64_t startFrame = firstSubBlock * subBlockFrames;
+    const uint64_t numSubBlocks = endSubBlock - firstSubBlock;
+    const uint64_t preRoll = std::min<uint64_t>(startFrame, header.sampleRate); // One second (or less at the very start)
+    in.seekg(static_cast<std::streamoff>(sizeof(WavHeader) + (startFrame - preRoll) * header.blockAlign));
+
+    std::vector<Biquad> shelves(channels), highPasses(channels);
+    for (int c = 0; c < channels; ++c) designKWeighting(header.sampleRate, shelves[c], highPasses[c]);
+    std::vector<TruePeakMeter> meters(channels);
+
+    stats.subBlockEnergy.assign(numSubBlocks * channels, 0.0);
+
+    const uint64_t blockFrames = 16384;
+    std::vector<int16_t> block(blockFrames * channels);
+    uint64_t frame = startFrame - preRoll;
+    while (frame < endFrame) {
+        const uint64_t frames = std::min(blockFrames, endFrame - frame);
+        in.read(reinterpret_cast<char*>(block.data()), static_cast<std::streamsize>(frames * header.blockAlign));
+        if (static_cast<uint64_t>(in.gcount()) != frames * header.blockAlign) {
+            stats.ok = false;
+            return;
+        }
+
+        for (int c = 0; c < channels; ++c) {
+            Biquad& shelf = shelves[c];
+            Biquad& highPass = highPasses[c];
+            TruePeakMeter& meter = meters[c];
+            for (uint64_t i = 0; i < frames; ++i) {
+                const uint64_t f = frame + i;
+                const float x = block[i * channels + c] / 32768.0f;
+                const double k = highPass.process(shelf.process(x));
+                const float interpolated = meter.process(x);
+                // The pre-roll only warms up the filters; its energy and
+                // peaks belong to the previous segment
+                if (f >= startFrame) {
+                    const uint64_t sub = (f - startFrame) / subBlockFrames;
+                    if (sub < numSubBlocks) stats.subBlockEnergy[sub * channels + c] += k * k;
+                    stats.truePeak = std::max(stats.truePeak, interpolated);
+                    stats.samplePeak = std::max(stats.samplePeak, std::fabs(x));
+                }
+            }
+        }
+        frame += frames;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Merging and gating
+// ---------------------------------------------------------------------------
+struct LoudnessResult {
+    double integrated = -INFINITY;
+    double maxMomentary = -INFINITY;
+    double maxShortTerm = -INFINITY;
+    double truePeakDb = -INFINITY;
+    double samplePeakDb = -INFINITY;
+};
+
+// Channel weights from BS.1770: 1.0 for front channels, 1.41 for surrounds, LFE ignored
+double channelWeight(int channel, int numChannels) {
+    if (numChannels == 6) {
+        if (channel == 3) return 0.0;                  // LFE
+        if (channel == 4 || channel == 5) return 1.41; // Ls, Rs
+    }
+    return 1.0;
+}
+
+// Loudness of a run of "count" sub-blocks starting at "first"
+double blockLoudness(const std::vector<double>& energy, int channels, uint64_t first, uint64_t count, uint64_t subBlockFrames) {
+    double weighted = 0.0;
+    for (int c = 0; c < channels; ++c) {
+        double sum = 0.0;
+        for (uint64_t s = first; s < first + count; ++s) sum += energy[s * channels + c];
+        weighted += channelWeight(c, channels) * sum / static_cast<double>(count * subBlockFrames);
+    }
+    return -0.691 + 10.0 * std::log10(weighted + 1e-30);
+}
+
+bool measure(const std::string& path, const WavHeader& header, unsigned numThreads, LoudnessResult& result) {
+    const int channels = header.numChannels;
+    const uint64_t numFrames = header.subchunk2Size / header.blockAlign;
+    const uint64_t subBlockFrames = header.sampleRate / 10; // 100 ms
+    const uint64_t numSubBlocks = numFrames / subBlockFrames;  // A trailing partial sub-block can't complete a gating block (but its peaks still count)
+    if (numSubBlocks < 4) return false;
+
+    numThreads = static_cast<unsigned>(std::max<uint64_t>(1, std::min<uint64_t>(numThreads, numSubBlocks / 4)));
+    std::vector<SegmentStats> segments(numThreads);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < numThreads; ++t) {
+        const uint64_t first = numSubBlocks * t / numThreads;
+        const uint64_t end = numSubBlocks * (t + 1) / numThreads;
+        const uint64_t endFrame = (t + 1 == numThreads) ? numFrames : end * subBlockFrames;
+        threads.emplace_back(analyzeSegment, std::cref(path), std::cref(header), subBlockFrames, first, end, endFrame, std::ref(segments[t]));
+    }
+    for (std::thread& t : threads) t.join();
+
+    // Merge: concatenate sub-block energies in order, take the max of the peaks
+    std::vector<double> energy;
+    energy.reserve(numSubBlocks * channels);
+    float truePeak = 0.0f, samplePeak = 0.0f;
+    for (const SegmentStats& s : segments) {
+        if (!s.ok) return false;
+        energy.insert(energy.end(), s.subBlockEnergy.begin(), s.subBlockEnergy.end());
+        truePeak = std::max(truePeak, s.truePeak);
+        samplePeak = std::max(samplePeak, s.samplePeak);
+    }
+
+    // Momentary (400 ms) and short-term (3 s) maxima, both stepping every 100 ms
+    std::vector<double> gatingBlocks;
+    for (uint64_t s = 0; s + 4 <= numSubBlocks; ++s) {
+        const double l = blockLoudness(energy, channels, s, 4, subBlockFrames);
+        gatingBlocks.push_back(l);
+        result.maxMomentary = std::max(result.maxMomentary, l);
+    }
+    for (uint64_t s = 0; s + 30 <= numSubBlocks; ++s) {
+        result.maxShortTerm = std::max(result.maxShortTerm, blockLoudness(energy, channels, s, 30, subBlockFrames));
+    }
+
+    // Integrated: absolute gate at -70 LUFS, then relative gate 10 LU below the mean.
+    // Averaging happens on energies, so convert each surviving block back from LUFS.
+    auto meanLoudness = [&](double gate) {
+        double sum = 0.0;
+        uint64_t count = 0;
+        for (double l : gatingBlocks) {
+            if (l > gate) {
+                sum += std::pow(10.0, (l + 0.691) / 10.0);
+                ++count;
+            }
+        }
+        return count ? -0.691 + 10.0 * std::log10(sum / count) : -INFINITY;
+    };
+    const double ungated = meanLoudness(-70.0);
+    result.integrated = std::isfinite(ungated) ? meanLoudness(std::max(-70.0, ungated - 10.0)) : -INFINITY;
+    // The interpolator never lands exactly on the original samples, so make
+    // sure the true peak is never reported below the sample peak
+    result.truePeakDb = 20.0 * std::log10(std::max(truePeak, samplePeak) + 1e-12);
+    result.samplePeakDb = 20.0 * std::log10(samplePeak + 1e-12);
+    return true;
+}
+
+// Parses a whole argument as a number; "abc" or "-14x" is an error, not 0
+bool parseNumber(const std::string& text, double& value) {
+    char* stop = nullptr;
+    value = std::strtod(text.c_str(), &stop);
+    return !text.empty() && *stop == '\0' && std::isfinite(value);
+}
+
+int main(int argc, char* argv[]) {
+    std::string inputPath = "input.wav";
+    const char* outputPath = "output_normalized.wav";
+    double targetLufs = -23.0;      // EBU R128 broadcast target
+    double ceilingDbTP = -1.0;      // Maximum allowed true peak
+    bool verify = (argc == 1);      // The default demo always verifies
+
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--verify") verify = true;
+        else positional.push_back(argv[i]);
+    }
+    if (positional.size() > 0) inputPath = positional[0];
+    if ((positional.size() > 1 && !parseNumber(positional[1], targetLufs)) ||
+        (positional.size() > 2 && !parseNumber(positional[2], ceilingDbTP))) {
+        std::cerr << "Error: targetLUFS and ceilingDbTP must be numbers\n"
+                  << "Usage: loudness_normalize [input.wav] [targetLUFS] [ceilingDbTP] [--verify]\n";
+        return 1;
+    }
+
+    std::ifstream in(inputPath, std::ios::binary);
+    if (!in) {
+        std::cerr << "Error: Could not open input file.\n";
+        return 1;
+    }
+    WavHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(WavHeader));
+    if (!in || header.bitsPerSample != 16 || header.numChannels == 0 || header.blockAlign != header.numChannels * 2) {
+        std::cerr << "Error: Failed to read a 16-bit WAV header.\n";
+        return 1;
+    }
+
+    // Pass 1: measure (in parallel)
+    const auto t0 = std::chrono::steady_clock::now();
+    LoudnessResult loudness;
+    if (!measure(inputPath, header, std::thread::hardware_concurrency(), loudness)) {
+        std::cerr << "Error: Could not measure " << inputPath << " (too short or unreadable)\n";
+        return 1;
+    }
+    const double measureSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    const double audioSeconds = static_cast<double>(header.subchunk2Size / header.blockAlign) / header.sampleRate;
+
+    std::printf("Integrated:      %7.2f LUFS\n", loudness.integrated);
+    std::printf("Max momentary:   %7.2f LUFS\n", loudness.maxMomentary);
+    std::printf("Max short-term:  %7.2f LUFS\n", loudness.maxShortTerm);
+    std::printf("True peak:       %7.2f dBTP\n", loudness.truePeakDb);
+    std::printf("Sample peak:     %7.2f dBFS\n", loudness.samplePeakDb);
+    std::printf("Measured %.1f s of audio in %.4f s (%.0fx realtime)\n", audioSeconds, measureSeconds, audioSeconds / measureSeconds);
+
+    if (verify) {
+        LoudnessResult serial;
+        measure(inputPath, header, 1, serial);
+        // -inf == -inf counts as a match (e.g. no short-term value for files under 3 s)
+        auto close = [](double a, double b) { return a == b || std::fabs(a - b) < 1e-6; };
+        const bool same = close(serial.integrated, loudness.integrated) && close(serial.maxMomentary, loudness.maxMomentary) &&
+                          close(serial.maxShortTerm, loudness.maxShortTerm) && close(serial.truePeakDb, loudness.truePeakDb);
+        std::printf("Parallel vs serial measurement: %s (difference %.2e LU)\n", same ? "match" : "DIFFERENT",
+                    std::fabs(serial.integrated - loudness.integrated));
+        if (!same) return 1;
+    }
+
+    if (!std::isfinite(loudness.integrated)) {
+        std::cerr << "File is silent; nothing to normalize.\n";
+        return 1;
+    }
+
+    // Work out the gain, then back off if the true peak would go over the ceiling
+    double gainDb = targetLufs - loudness.integrated;
+    if (loudness.truePeakDb + gainDb > ceilingDbTP) {
+        gainDb = ceilingDbTP - loudness.truePeakDb;
+        std::printf("Gain limited by true-peak ceiling: result will be %.2f LUFS\n", loudness.integrated + gainDb);
+    }
+    const double gain = std::pow(10.0, gainDb / 20.0);
+    std::printf("Applying %+.2f dB (x%.4f)\n", gainDb, gain);
+
+    // Pass 2: apply the gain exactly like gain_processor.cpp, a block at a time
+    std::ofstream out(outputPath, std::ios::binary);
+    if (!out) {
+        std::cerr << "Error: Could not open output file.\n";
+        return 1;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(WavHeader));
+
+    // Stop at the end of the data chunk: anything after it (LIST, id3...) is
+    // metadata, not samples
+    std::vector<int16_t> block(16384);
+    uint64_t remaining = header.subchunk2Size / sizeof(int16_t);
+    while (remaining > 0) {
+        const size_t want = static_cast<size_t>(std::min<uint64_t>(block.size(), remaining));
+        in.read(reinterpret_cast<char*>(block.data()), want * sizeof(int16_t));
+        const size_t n = static_cast<size_t>(in.gcount()) / sizeof(int16_t);
+        if (n == 0)
+            break;
+        remaining -= n;
+        for (size_t i = 0; i < n; ++i) {
+            double processed = block[i] * gain;
+            if (processed > 32767)
+                processed = 32767;
+            if (processed < -32768)
+                processed = -32768;
+            block[i] = static_cast<int16_t>(processed);
+        }
+        out.write(reinterpret_cast<const char*>(block.data()), n * sizeof(int16_t));
+    }
+    out.close();
+
+    std::cout << "Wrote " << outputPath << "\n";
+    return 0;
+}
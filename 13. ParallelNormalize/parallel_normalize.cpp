@@ -0,0 +1,310 @@
+/*
+    MicroDSP - Day 13: Parallel Two-Pass Normalization
+
+    What this program does:
+    - Pass 1 (analysis): splits a 16-bit PCM WAV file into one segment per
+      CPU core. Every thread measures its own segment's peak, sum of squares
+      and a histogram of sample magnitudes.
+    - Merge: the per-segment numbers are combined into whole-file numbers.
+    - Works out one gain for the whole file:
+        * peak mode:       loudest sample lands on the target (e.g. -1 dBFS)
+        * rms mode:        average level lands on the target (e.g. -18 dBFS RMS)
+        * percentile mode: the 99.99th-percentile sample lands on the target,
+                           so a single stray click can't dictate the gain
+    - Pass 2 (apply): every thread applies the gain to its own segment with
+      the same multiply-and-clamp as gain_processor.cpp and writes straight
+      into its own region of the output file.
+
+    Mergeable statistics:
+    The trick that makes pass 1 parallel is choosing statistics that can be
+    combined exactly, in any order:
+        peak         -> max of the segment peaks
+        sum of squares -> sum of the segment sums (integers, so no rounding)
+        histogram    -> add the histograms bin by bin
+    RMS is then sqrt(totalSumOfSquares / totalSamples). Because everything
+    is integer math, the result is identical for any number of threads.
+
+    Disjoint writes:
+    The output is exactly as big as the input, so before pass 2 we create the
+    output file at its final size. Each thread then opens its own handle,
+    seeks to its segment's offset and writes. No two threads ever touch the
+    same bytes, so no locking is needed.
+
+    Usage:
+        parallel_normalize [--mode peak|rms|percentile] [--target dB] [input.wav] [output.wav]
+
+    Build:
+        g++ -std=c++17 -O3 -march=native -pthread parallel_normalize.cpp -o parallel_normalize
+
+    Author: Jesse Whiting (GhostWire Audio)
+    GitHub: ghostwireaudio
+*/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <filesystem>
+#include <cstdio>
+
+// Force the compiler to pack the struct exactly as written
+// with no padding bytes added for alignment, which ensures
+// sizeof(WavHeader) == 44 bytes
+#pragma pack(push, 1)
+struct WavHeader {
+    // RIFF Chunk Descriptor
+    char     riff[4];        // "RIFF"
+    uint32_t chunkSize;      // 36 + Subchunk2Size
+    char     wave[4];        // "WAVE"
+
+    // fmt subchunk
+    char     fmt[4];         // "fmt "
+    uint32_t subchunk1Size;  // 16 for PCM
+    uint16_t audioFormat;    // 1 for PCM
+    uint16_t numChannels;    // 1 for mono
+    uint32_t sampleRate;     // e.g., 44100
+    uint32_t byteRate;       // sampleRate * numChannels * bitsPerSample/8
+    uint16_t blockAlign;     // numChannels * bitsPerSample/8
+    uint16_t bitsPerSample;  // 16
+
+    // data subchunk
+    char     data[4];        // "data"
+    uint32_t subchunk2Size;  // NumSamples * numChannels * bitsPerSample/8
+};
+#pragma pack(pop)
+
+const size_t blockSamples = 1 << 19;                     // 1 MiB of 16-bit samples per read
+const int histogramShift = 6;                            // Magnitude steps of 64
+const int histogramBins = (32768 >> histogramShift) + 1; // Covers 0..32768 (|-32768| included)
+
+// Statistics for one segment. Every field can be merged exactly.
+struct SegmentStats {
+    int32_t peak = 0;              // Largest |sample|
+    uint64_t sumSquares = 0;       // Exact: each square fits in 31 bits
+    uint64_t count = 0;
+    std::vector<uint64_t> histogram = std::vector<uint64_t>(histogramBins, 0);
+    bool ok = true;
+
+    void merge(const SegmentStats& other) {
+        peak = std::max(peak, other.peak);
+        sumSquares += other.sumSquares;
+        count += other.count;
+        for (int b = 0; b < histogramBins; ++b) histogram[b] += other.histogram[b];
+        ok = ok && other.ok;
+    }
+};
+
+// Pass 1 worker: samples [first, end) of the data chunk
+void analyzeSegment(const std::string& path, uint64_t first, uint64_t end, SegmentStats& stats) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        stats.ok = false;
+        return;
+    }
+    in.seekg(static_cast<std::streamoff>(sizeof(WavHeader) + first * sizeof(int16_t)));
+
+    std::vector<int16_t> block(blockSamples);
+    for (uint64_t pos = first; pos < end;) {
+        const size_t n = static_cast<size_t>(std::min<uint64_t>(blockSamples, end - pos));
+        in.read(reinterpret_cast<char*>(block.data()), n * sizeof(int16_t));
+        if (static_cast<size_t>(in.gcount()) != n * sizeof(int16_t)) {
+            stats.ok = false;
+            return;
+        }
+
+        // Peak and energy: a branch-free loop over the block
+        int32_t peak = stats.peak;
+        uint64_t energy = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const int32_t v = block[i];
+            const int32_t mag = v < 0 ? -v : v;
+            peak = std::max(peak, mag);
+            energy += static_cast<uint64_t>(v * v);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            const int32_t v = block[i];
+            ++stats.histogram[(v < 0 ? -v : v) >> histogramShift];
+        }
+        stats.peak = peak;
+        stats.sumSquares += energy;
+        stats.count += n;
+        pos += n;
+    }
+}
+
+// Pass 2 worker: applies the gain to samples [first, end) and writes them in place
+void applySegment(const std::string& inputPath, const std::string& outputPath, uint64_t first, uint64_t end, double gain, bool& ok) {
+    std::ifstream in(inputPath, std::ios::binary);
+    std::fstream out(outputPath, std::ios::binary | std::ios::in | std::ios::out);
+    if (!in || !out) {
+        ok = false;
+        return;
+    }
+    const std::streamoff offset = static_cast<std::streamoff>(sizeof(WavHeader) + first * sizeof(int16_t));
+    in.seekg(offset);
+    out.seekp(offset);
+
+    std::vector<int16_t> block(blockSamples);
+    for (uint64_t pos = first; pos < end;) {
+        const size_t n = static_cast<size_t>(std::min<uint64_t>(blockSamples, end - pos));
+        in.read(reinterpret_cast<char*>(block.data()), n * sizeof(int16_t));
+        if (static_cast<size_t>(in.gcount()) != n * sizeof(int16_t)) {
+            ok = false;
+            return;
+        }
+
+        // Same math as gain_processor.cpp: multiply, clamp, truncate
+        for (size_t i = 0; i < n; ++i) {
+            double processed = block[i] * gain;
+            processed = std::min(processed, 32767.0);
+            processed = std::max(processed, -32768.0);
+            block[i] = static_cast<int16_t>(processed);
+        }
+
+        out.write(reinterpret_cast<const char*>(block.data()), n * sizeof(int16_t));
+        pos += n;
+    }
+    ok = static_cast<bool>(out);
+}
+
+// Splits [0, total) into "parts" nearly equal ranges and runs fn on each in its own thread
+template <typename Fn>
+void runSegments(uint64_t total, unsigned parts, Fn fn) {
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < parts; ++t) {
+        const uint64_t first = total * t / parts;
+        const uint64_t end = total * (t + 1) / parts;
+        threads.emplace_back(fn, t, first, end);
+    }
+    for (std::thread& t : threads) t.join();
+}
+
+int main(int argc, char* argv[]) {
+    std::string mode = "peak";
+    double targetDb = -1.0;
+    bool targetGiven = false;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--mode" && i + 1 < argc) mode = argv[++i];
+        else if (arg == "--target" && i + 1 < argc) {
+            // The whole value must be a number: "abc" or "-1dB" is an error
+            const std::string value = argv[++i];
+            size_t used = 0;
+            try {
+                targetDb = std::stod(value, &used);
+            } catch (const std::exception&) {
+                used = 0;
+            }
+            if (used == 0 || used != value.size() || !std::isfinite(targetDb)) {
+                std::cerr << "Error: --target needs a number in dB, got \"" << value << "\"\n"
+                          << "Usage: parallel_normalize [--mode peak|rms|percentile] [--target dB] [input.wav] [output.wav]\n";
+                return 1;
+            }
+            targetGiven = true;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (!targetGiven && mode == "rms") targetDb = -18.0;
+    const std::string inputPath = paths.size() > 0 ? paths[0] : "input.wav";
+    const std::string outputPath = paths.size() > 1 ? paths[1] : "output_normalized.wav";
+
+    std::ifstream in(inputPath, std::ios::binary);
+    if (!in) {
+        std::cerr << "Error: Could not open input file.\n";
+        return 1;
+    }
+    WavHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(WavHeader));
+    if (!in || header.bitsPerSample != 16) {
+        std::cerr << "Error: Failed to read a 16-bit WAV header.\n";
+        return 1;
+    }
+    in.close();
+
+    const uint64_t numSamples = header.subchunk2Size / sizeof(int16_t);
+    const double megabytes = header.subchunk2Size / (1024.0 * 1024.0);
+    // Don't bother splitting tiny files into more segments than there are blocks
+    const unsigned numThreads = static_cast<unsigned>(
+        std::max<uint64_t>(1, std::min<uint64_t>(std::thread::hardware_concurrency(), (numSamples + blockSamples - 1) / blockSamples)));
+
+    // Pass 1: parallel analysis
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<SegmentStats> segments(numThreads);
+    runSegments(numSamples, numThreads, [&](unsigned t, uint64_t first, uint64_t end) {
+        analyzeSegment(inputPath, first, end, segments[t]);
+    });
+    SegmentStats total;
+    for (const SegmentStats& s : segments) total.merge(s);
+    if (!total.ok || total.count == 0) {
+        std::cerr << "Error: Failed to read audio data.\n";
+        return 1;
+    }
+    const double analyzeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    const double peakDb = 20.0 * std::log10(total.peak / 32768.0 + 1e-12);
+    const double rms = std::sqrt(static_cast<double>(total.sumSquares) / total.count);
+    const double rmsDb = 20.0 * std::log10(rms / 32768.0 + 1e-12);
+
+    // 99.99th percentile from the histogram: walk down from the top until
+    // 0.01% of the samples are above us
+    const uint64_t allowedAbove = total.count / 10000;
+    uint64_t above = 0;
+    int percentileBin = histogramBins - 1;
+    while (percentileBin > 0 && above + total.histogram[percentileBin] <= allowedAbove) {
+        above += total.histogram[percentileBin];
+        --percentileBin;
+    }
+    // Use the top edge of that bin, but never report more than the true peak
+    const int32_t percentileLevel = std::min((percentileBin + 1) << histogramShift, total.peak);
+    const double percentileDb = 20.0 * std::log10(percentileLevel / 32768.0);
+
+    std::printf("Peak %.2f dBFS, RMS %.2f dBFS, 99.99%% %.2f dBFS\n", peakDb, rmsDb, percentileDb);
+
+    if (total.peak == 0) {
+        std::cerr << "File is silent; nothing to normalize.\n";
+        return 1;
+    }
+
+    double gainDb;
+    if (mode == "rms") gainDb = targetDb - rmsDb;
+    else if (mode == "percentile") gainDb = targetDb - percentileDb;
+    else gainDb = targetDb - peakDb;
+    const double gain = std::pow(10.0, gainDb / 20.0);
+    std::printf("Mode %s, target %.2f dB -> gain %+.2f dB\n", mode.c_str(), targetDb, gainDb);
+
+    // Create the output at its final size, header first
+    {
+        std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "Error: Could not open output file.\n";
+            return 1;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(WavHeader));
+    }
+    std::filesystem::resize_file(outputPath, sizeof(WavHeader) + numSamples * sizeof(int16_t));
+
+    // Pass 2: parallel apply into disjoint regions
+    t0 = std::chrono::steady_clock::now();
+    std::vector<char> segmentOk(numThreads, 0);
+    runSegments(numSamples, numThreads, [&](unsigned t, uint64_t first, uint64_t end) {
+        bool ok = true;
+        applySegment(inputPath, outputPath, first, end, gain, ok);
+        segmentOk[t] = ok;
+    });
+    const double applySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    if (std::find(segmentOk.begin(), segmentOk.end(), 0) != segmentOk.end()) {
+        std::cerr << "Error: Failed to write output.\n";
+        return 1;
+    }
+
+    std::printf("Analysis: %.1f MB/s, apply: %.1f MB/s (%u thread(s))\n", megabytes / analyzeSeconds, megabytes / applySeconds, numThreads);
+    std::cout << "Wrote " << outputPath << "\n";
+    return 0;
+}
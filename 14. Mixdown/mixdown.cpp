@@ -0,0 +1,373 @@
+/*
+    MicroDSP - Day 14: Mixdown / Summing Engine
+
+    What this program does:
+    - Opens any number of 16-bit PCM WAV files ("stems") at once
+    - Gives every stem its own gain (dB) and pan (-1 = left, +1 = right)
+    - Adds them all together on a stereo float "bus", one block at a time
+    - Writes the master to: output_mix.wav
+
+    Usage:
+        mixdown [stem.wav[:gainDb[:pan]] ...]
+    e.g.
+        mixdown drums.wav:-3 bass.wav:-6:0 gtr_l.wav:-9:-0.7 gtr_r.wav:-9:0.7
+    With no arguments it mixes a few copies of input.wav as a demo.
+
+    How it stays fast with hundreds of inputs:
+    - Block mixing: the bus is only 4096 frames long (32 KB of floats),
+      so it stays in the CPU cache while every stem is added into it. The
+      add loop is a plain multiply-add over arrays, which the compiler
+      vectorizes (g++ -O3 -march=native).
+    - Prefetching readers: every stem has TWO block buffers. While the
+      mixer is adding block k from one buffer, a pool of 4 I/O threads
+      (numIoThreads) is already reading block k+1 into the other. With N
+      stems, up to N read requests wait in the prefetch queue, but only 4
+      reads are in flight at any moment, so the disk sees a queue depth
+      of 4.
+
+    Cost and memory (N = number of stems, B = block frames = 4096):
+    - CPU: each output frame costs one multiply-add per stem per channel,
+      so mixing time grows linearly with N. The I/O threads read 4 files at a
+      time, so on a fast disk wall time also grows roughly linearly.
+    - Memory per stem: 2 buffers x B frames x channels x 2 bytes
+      (16 KB mono, 32 KB stereo) plus one open file handle and its stream
+      buffer (a few KB). 500 stereo stems need well under 32 MB.
+    - Open files: one per stem, so very large sessions may need a higher
+      "ulimit -n" (the default is often 1024).
+
+    Build:
+        g++ -std=c++17 -O3 -march=native -pthread mixdown.cpp -o mixdown
+
+    Author: Jesse Whiting (GhostWire Audio)
+    GitHub: ghostwireaudio
+*/
+
+#define _USE_MATH_DEFINES
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <deque>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdio>
+
+// Force the compiler to pack the struct exactly as written
+// with no padding bytes added for alignment, which ensures
+// sizeof(WavHeader) == 44 bytes
+#pragma pack(push, 1)
+struct WavHeader {
+    // RIFF Chunk Descriptor
+    char     riff[4];        // "RIFF"
+    uint32_t chunkSize;      // 36 + Subchunk2Size
+    char     wave[4];        // "WAVE"
+
+    // fmt subchunk
+    char     fmt[4];         // "fmt "
+    uint32_t subchunk1Size;  // 16 for PCM
+    uint16_t audioFormat;    // 1 for PCM
+    uint16_t numChannels;    // 1 for mono
+    uint32_t sampleRate;     // e.g., 44100
+    uint32_t byteRate;       // sampleRate * numChannels * bitsPerSample/8
+    uint16_t blockAlign;     // numChannels * bitsPerSample/8
+    uint16_t bitsPerSample;  // 16
+
+    // data subchunk
+    char     data[4];        // "data"
+    uint32_t subchunk2Size;  // NumSamples * numChannels * bitsPerSample/8
+};
+#pragma pack(pop)
+
+const uint64_t blockFrames = 4096;
+const int numIoThreads = 4;
+
+// ---------------------------------------------------------------------------
+// A stem with two prefetch buffers
+// ---------------------------------------------------------------------------
+enum SlotState { Empty = 0, Filling = 1, Ready = 2 };
+
+struct Stem {
+    std::string path;
+    float gainDb = 0.0f;
+    float pan = 0.0f;
+    float gainLeft = 1.0f, gainRight = 1.0f;
+
+    std::ifstream file;
+    std::mutex fileMutex; // Two reads for the same stem may be in flight at once
+    WavHeader header{};
+    uint64_t numFrames = 0;
+
+    std::vector<int16_t> slots[2];
+    uint64_t slotFrames[2] = { 0, 0 };
+    std::atomic<int> slotState[2];
+    bool readError = false;
+
+    Stem() {
+        slotState[0] = Empty;
+        slotState[1] = Empty;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// I/O thread pool: fills stem buffers in the background
+// ---------------------------------------------------------------------------
+struct ReadRequest {
+    Stem* stem;
+    int slot;
+    uint64_t block;
+};
+
+class Prefetcher {
+public:
+    explicit Prefetcher(int numThreads) {
+        for (int t = 0; t < numThreads; ++t) threads.emplace_back([this] { run(); });
+    }
+
+    ~Prefetcher() {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopping = true;
+        }
+        queueReady.notify_all();
+        for (std::thread& t : threads) t.join();
+    }
+
+    void request(Stem* stem, int slot, uint64_t block) {
+        stem->slotState[slot] = Filling;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            queue.push_back({ stem, slot, block });
+        }
+        queueReady.notify_one();
+    }
+
+    // Blocks the mixer until the buffer is filled
+    void waitFor(Stem* stem, int slot) {
+        if (stem->slotState[slot] == Ready) return;
+        std::unique_lock<std::mutex> lock(doneMutex);
+        doneSignal.wait(lock, [&] { return stem->slotState[slot] == Ready; });
+    }
+
+private:
+    void run() {
+        while (true) {
+            ReadRequest req;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueReady.wait(lock, [&] { return stopping || !queue.empty(); });
+                if (queue.empty()) return;
+                req = queue.front();
+                queue.pop_front();
+            }
+
+            Stem& s = *req.stem;
+            const uint64_t first = req.block * blockFrames;
+            const uint64_t frames = std::min(blockFrames, s.numFrames - first);
+            {
+                std::lock_guard<std::mutex> lock(s.fileMutex);
+                s.file.seekg(static_cast<std::streamoff>(sizeof(WavHeader) + first * s.header.blockAlign));
+                s.file.read(reinterpret_cast<char*>(s.slots[req.slot].data()), static_cast<std::streamsize>(frames * s.header.blockAlign));
+                const uint64_t got = static_cast<uint64_t>(s.file.gcount()) / s.header.blockAlign;
+                if (got != frames) {
+                    // Treat a short file as silence rather than stopping the whole mix
+                    s.readError = true;
+                    std::fill(s.slots[req.slot].begin() + got * s.header.numChannels, s.slots[req.slot].end(), 0);
+                    s.file.clear();
+                }
+                s.slotFrames[req.slot] = frames;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(doneMutex);
+                s.slotState[req.slot] = Ready;
+            }
+            doneSignal.notify_all();
+        }
+    }
+
+    std::vector<std::thread> threads;
+    std::deque<ReadRequest> queue;
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    std::mutex doneMutex;
+    std::condition_variable doneSignal;
+    bool stopping = false;
+};
+
+// Adds one stem's block onto the stereo bus
+void mixInto(const Stem& stem, const int16_t* samples, uint64_t frames, float* busLeft, float* busRight) {
+    const float scale = 1.0f / 32768.0f;
+    const float gl = stem.gainLeft * scale;
+    const float gr = stem.gainRight * scale;
+    if (stem.header.numChannels == 1) {
+        for (uint64_t i = 0; i < frames; ++i) {
+            const float x = samples[i];
+            busLeft[i] += gl * x;
+            busRight[i] += gr * x;
+        }
+    } else {
+        // Stereo (or more): first two channels, pan acts as a balance control
+        const int ch = stem.header.numChannels;
+        for (uint64_t i = 0; i < frames; ++i) {
+            busLeft[i] += gl * samples[i * ch];
+            busRight[i] += gr * samples[i * ch + 1];
+        }
+    }
+}
+
+// Parses a whole string as a float. "abc", "-6dB" or an empty field is an error.
+bool parseFloat(const std::string& text, float& value) {
+    try {
+        size_t used = 0;
+        value = std::stof(text, &used);
+        return used == text.size() && std::isfinite(value);
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const char* outputPath = "output_mix.wav";
+
+    // Parse "path[:gainDb[:pan]]" arguments
+    std::vector<std::string> specs;
+    for (int i = 1; i < argc; ++i) specs.push_back(argv[i]);
+    if (specs.empty()) {
+        specs = { "input.wav:-6:-0.8", "input.wav:-6:0.8", "input.wav:-9:0", "input.wav:-12:-0.3", "input.wav:-12:0.3" };
+    }
+
+    std::vector<std::unique_ptr<Stem>> stems;
+    for (const std::string& spec : specs) {
+        auto stem = std::make_unique<Stem>();
+        const size_t c1 = spec.find(':');
+        stem->path = spec.substr(0, c1);
+        if (c1 != std::string::npos) {
+            const size_t c2 = spec.find(':', c1 + 1);
+            bool ok = parseFloat(spec.substr(c1 + 1, c2 - c1 - 1), stem->gainDb);
+            if (ok && c2 != std::string::npos) {
+                ok = parseFloat(spec.substr(c2 + 1), stem->pan);
+                stem->pan = std::clamp(stem->pan, -1.0f, 1.0f);
+            }
+            if (!ok) {
+                std::cerr << "Error: Bad stem \"" << spec << "\": gain and pan must be numbers\n"
+                          << "Usage: mixdown [stem.wav[:gainDb[:pan]] ...]\n";
+                return 1;
+            }
+        }
+
+        stem->file.open(stem->path, std::ios::binary);
+        if (!stem->file) {
+            std::cerr << "Error: Could not open " << stem->path << "\n";
+            return 1;
+        }
+        stem->file.read(reinterpret_cast<char*>(&stem->header), sizeof(WavHeader));
+        if (!stem->file || stem->header.bitsPerSample != 16) {
+            std::cerr << "Error: " << stem->path << " is not a 16-bit PCM WAV file\n";
+            return 1;
+        }
+        stem->numFrames = stem->header.subchunk2Size / stem->header.blockAlign;
+
+        // Constant-power pan law. Mono stems sit at -3 dB per side in the centre;
+        // stereo stems are normalized so the centre position leaves them untouched.
+        const float angle = static_cast<float>((stem->pan + 1.0f) * M_PI / 4.0);
+        const float gain = std::pow(10.0f, stem->gainDb / 20.0f);
+        const float stereoNorm = (stem->header.numChannels == 1) ? 1.0f : static_cast<float>(M_SQRT2);
+        stem->gainLeft = gain * std::cos(angle) * stereoNorm;
+        stem->gainRight = gain * std::sin(angle) * stereoNorm;
+
+        stem->slots[0].assign(blockFrames * stem->header.numChannels, 0);
+        stem->slots[1].assign(blockFrames * stem->header.numChannels, 0);
+        stems.push_back(std::move(stem));
+    }
+
+    // Every stem must share one sample rate (convert first with Day 8's resampler)
+    const uint32_t sampleRate = stems[0]->header.sampleRate;
+    uint64_t totalFrames = 0;
+    size_t bufferBytes = 0;
+    for (const auto& s : stems) {
+        if (s->header.sampleRate != sampleRate) {
+            std::cerr << "Error: " << s->path << " is " << s->header.sampleRate << " Hz, expected " << sampleRate << " Hz\n";
+            return 1;
+        }
+        totalFrames = std::max(totalFrames, s->numFrames);
+        bufferBytes += 2 * s->slots[0].size() * sizeof(int16_t);
+    }
+
+    std::ofstream out(outputPath, std::ios::binary);
+    if (!out) {
+        std::cerr << "Error: Could not open output file.\n";
+        return 1;
+    }
+    WavHeader outHeader = stems[0]->header;
+    outHeader.numChannels = 2;
+    outHeader.blockAlign = 4;
+    outHeader.byteRate = sampleRate * 4;
+    outHeader.subchunk2Size = static_cast<uint32_t>(totalFrames * 4);
+    outHeader.chunkSize = 36 + outHeader.subchunk2Size;
+    out.write(reinterpret_cast<const char*>(&outHeader), sizeof(WavHeader));
+
+    const auto t0 = std::chrono::steady_clock::now();
+    uint64_t clipped = 0;
+    {
+        Prefetcher prefetcher(numIoThreads);
+
+        // Prime both buffers of every stem
+        for (auto& s : stems) {
+            const uint64_t blocks = (s->numFrames + blockFrames - 1) / blockFrames;
+            for (uint64_t b = 0; b < std::min<uint64_t>(2, blocks); ++b) prefetcher.request(s.get(), static_cast<int>(b), b);
+        }
+
+        std::vector<float> busLeft(blockFrames), busRight(blockFrames);
+        std::vector<int16_t> outBlock(blockFrames * 2);
+        const uint64_t numBlocks = (totalFrames + blockFrames - 1) / blockFrames;
+
+        for (uint64_t b = 0; b < numBlocks; ++b) {
+            const int slot = static_cast<int>(b % 2);
+            const uint64_t frames = std::min(blockFrames, totalFrames - b * blockFrames);
+            std::fill(busLeft.begin(), busLeft.end(), 0.0f);
+            std::fill(busRight.begin(), busRight.end(), 0.0f);
+
+            for (auto& s : stems) {
+                const uint64_t stemBlocks = (s->numFrames + blockFrames - 1) / blockFrames;
+                if (b >= stemBlocks) continue; // This stem already ended
+
+                prefetcher.waitFor(s.get(), slot);
+                mixInto(*s, s->slots[slot].data(), s->slotFrames[slot], busLeft.data(), busRight.data());
+
+                // Buffer is free again: start reading the block after next into it
+                s->slotState[slot] = Empty;
+                if (b + 2 < stemBlocks) prefetcher.request(s.get(), slot, b + 2);
+            }
+
+            // Bus -> 16-bit stereo, clamped like every other project
+            for (uint64_t i = 0; i < frames; ++i) {
+                const float l = busLeft[i] * 32768.0f;
+                const float r = busRight[i] * 32768.0f;
+                clipped += (l > 32767.0f || l < -32768.0f) + (r > 32767.0f || r < -32768.0f);
+                outBlock[2 * i] = static_cast<int16_t>(std::clamp(l, -32768.0f, 32767.0f));
+                outBlock[2 * i + 1] = static_cast<int16_t>(std::clamp(r, -32768.0f, 32767.0f));
+            }
+            out.write(reinterpret_cast<const char*>(outBlock.data()), static_cast<std::streamsize>(frames * 4));
+        }
+    }
+    out.close();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    for (const auto& s : stems) {
+        if (s->readError) std::cerr << "Warning: " << s->path << " was shorter than its header said (padded with silence)\n";
+    }
+
+    const double audioSeconds = static_cast<double>(totalFrames) / sampleRate;
+    std::printf("Mixed %zu stems, %.1f s, in %.3f s (%.0fx realtime)\n", stems.size(), audioSeconds, seconds, audioSeconds / seconds);
+    std::printf("Stem buffers: %.1f KB total (%.1f KB per stem)\n", bufferBytes / 1024.0, bufferBytes / 1024.0 / stems.size());
+    if (clipped > 0) std::printf("Warning: %llu samples clipped; lower the stem gains\n", static_cast<unsigned long long>(clipped));
+    std::cout << "Wrote " << outputPath << "\n";
+    return 0;
+}
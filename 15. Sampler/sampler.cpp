@@ -0,0 +1,587 @@
+/*
+    MicroDSP - Day 15: Polyphonic Disk-Streaming Sampler
+
+    What this program does:
+    - Loads a WAV file as a "sample" (default: input.wav)
+    - Plays thousands of notes from it at different pitches, gains and pans
+    - Renders everything offline as fast as possible into: output_sampler.wav
+    - Reports voice usage, voice steals, disk stalls and speed vs realtime
+
+    Usage:
+        sampler [sample.wav] [maxVoices] [notesPerSecond] [seconds]
+    e.g.
+        sampler input.wav 2048 1000 20
+
+    How a disk-streaming sampler works:
+    - Real sample libraries are far too big to keep in RAM, so only the
+      start of each sample (the "attack", here 16384 frames) is loaded up
+      front. When a note starts it can play instantly from memory.
+    - The rest of the sample is streamed from disk in chunks of 4096
+      frames. Each voice owns two chunk buffers: while it plays one chunk,
+      a background "streamer" thread reads the next chunk into the other.
+      The attack portion gives the streamer time to fetch the first chunks.
+    - If a voice reaches a chunk that has not arrived yet, that is an
+      "underrun". A live sampler would output a glitch; this offline
+      renderer waits for the data and counts it as a stall instead.
+
+    Voice pool:
+    - All voices and their chunk buffers are allocated once at startup, so
+      the render loop never calls new/delete.
+    - When every voice is busy and a new note arrives, the OLDEST voice is
+      "stolen" (cut off) and reused for the new note.
+    - Every voice has a generation number. Stealing a voice bumps it, so
+      chunks still in flight for the old note are ignored when they land.
+
+    Pitch:
+    - A note plays the sample at a speed ratio of 2^(semitones / 12).
+      The playback position is fractional, so each output sample is a
+      linear interpolation between the two nearest source frames.
+    - The position is kept in 32.32 fixed point: the top 32 bits are the
+      frame number and the bottom 32 bits the fraction. Integer adds never
+      drift, and no float-to-int conversion is needed to find the frame.
+
+    Threads:
+    - Voices are independent, so every render block the voice pool is split
+      into one slice per CPU core. Each thread renders its slice into its
+      own bus and the buses are summed at the end of the block.
+
+    Memory per voice: 2 chunks x 4096 frames x channels x 2 bytes
+    (16 KB for a mono sample), so 2048 voices use 32 MB of stream buffers.
+
+    Build:
+        g++ -std=c++17 -O3 -march=native -pthread sampler.cpp -o sampler
+
+    Author: Jesse Whiting (GhostWire Audio)
+    GitHub: ghostwireaudio
+*/
+
+#define _USE_MATH_DEFINES
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <cstdio>
+
+// Force the compiler to pack the struct exactly as written
+// with no padding bytes added for alignment, which ensures
+// sizeof(WavHeader) == 44 bytes
+#pragma pack(push, 1)
+struct WavHeader {
+    // RIFF Chunk Descriptor
+    char     riff[4];        // "RIFF"
+    uint32_t chunkSize;      // 36 + Subchunk2Size
+    char     wave[4];        // "WAVE"
+
+    // fmt subchunk
+    char     fmt[4];         // "fmt "
+    uint32_t subchunk1Size;  // 16 for PCM
+    uint16_t audioFormat;    // 1 for PCM
+    uint16_t numChannels;    // 1 for mono
+    uint32_t sampleRate;     // e.g., 44100
+    uint32_t byteRate;       // sampleRate * numChannels * bitsPerSample/8
+    uint16_t blockAlign;     // numChannels * bitsPerSample/8
+    uint16_t bitsPerSample;  // 16
+
+    // data subchunk
+    char     data[4];        // "data"
+    uint32_t subchunk2Size;  // NumSamples * numChannels * bitsPerSample/8
+};
+#pragma pack(pop)
+
+const uint64_t preloadFrames = 16384;
+const uint64_t chunkFrames = 4096;
+const int renderBlock = 1024;
+
+// ---------------------------------------------------------------------------
+// The sample: header, preloaded attack, and its own file handle for streaming
+// ---------------------------------------------------------------------------
+struct Sample {
+    WavHeader header{};
+    uint64_t numFrames = 0;
+    int channels = 1;
+    std::vector<int16_t> attack; // First preloadFrames frames, interleaved
+    std::ifstream stream;        // Only the streamer thread touches this
+};
+
+// ---------------------------------------------------------------------------
+// One playing note
+// ---------------------------------------------------------------------------
+struct Voice {
+    bool active = false;
+    uint32_t generation = 0;
+    uint64_t startFrame = 0; // When the note began (used to find the oldest)
+    int startOffset = 0;     // Sample offset inside the current render block
+
+    uint64_t position = 0;   // Read position in 32.32 fixed point (frame . fraction)
+    uint64_t step = 0;       // Playback speed (pitch), same format
+    float gainLeft = 0.0f, gainRight = 0.0f;
+
+    // Two streaming chunk buffers. chunkIndex[s] is which chunk the buffer
+    // is meant to hold; chunkReady[s] says whether it has arrived (atomic so
+    // the render thread can check it without taking the streamer's lock).
+    std::vector<int16_t> chunks[2];
+    int64_t chunkIndex[2] = { -1, -1 };
+    std::atomic<bool> chunkReady[2];
+    int64_t highestRequested = -1;
+
+    // The block of frames the voice is reading from right now (the attack or
+    // one chunk). Most samples fall inside it, which skips all chunk bookkeeping.
+    const int16_t* region = nullptr;
+    uint64_t regionStart = 0, regionEnd = 0;
+
+    Voice() {
+        chunkReady[0] = false;
+        chunkReady[1] = false;
+    }
+};
+
+struct StreamRequest {
+    Voice* voice;
+    uint32_t generation;
+    int slot;
+    int64_t chunk;
+};
+
+// ---------------------------------------------------------------------------
+// Background streamer: reads chunks for voices in FIFO order
+// ---------------------------------------------------------------------------
+class Streamer {
+public:
+    Streamer(Sample& s, size_t capacity) : sample(s), ring(capacity) {
+        worker = std::thread([this] { run(); });
+    }
+
+    ~Streamer() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        worker.join();
+    }
+
+    // Called by the render thread. The ring is preallocated; if it is full
+    // we have to wait for the streamer to catch up (counted as a stall).
+    void request(Voice& v, int slot, int64_t chunk) {
+        std::unique_lock<std::mutex> lock(mutex);
+        v.chunkIndex[slot] = chunk;
+        v.chunkReady[slot] = false;
+        if (count == ring.size()) {
+            ++stalls;
+            done.wait(lock, [&] { return count < ring.size(); });
+        }
+        ring[(head + count) % ring.size()] = { &v, v.generation, slot, chunk };
+        ++count;
+        wake.notify_one();
+    }
+
+    // Returns once the chunk for this slot is ready
+    void waitFor(Voice& v, int slot) {
+        if (v.chunkReady[slot]) return;
+        std::unique_lock<std::mutex> lock(mutex);
+        if (v.chunkReady[slot]) return;
+        ++underruns;
+        done.wait(lock, [&] { return v.chunkReady[slot].load(); });
+    }
+
+    // Invalidate everything still in flight for this voice
+    void retire(Voice& v) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++v.generation;
+        v.chunkIndex[0] = v.chunkIndex[1] = -1;
+        v.chunkReady[0] = v.chunkReady[1] = false;
+        v.highestRequested = -1;
+        v.region = nullptr;
+        v.regionStart = v.regionEnd = 0;
+    }
+
+    uint64_t underruns = 0;
+    uint64_t stalls = 0;
+    uint64_t bytesRead = 0;
+
+private:
+    void run() {
+        while (true) {
+            StreamRequest req;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || count > 0; });
+                if (count == 0) return;
+                req = ring[head];
+                head = (head + 1) % ring.size();
+                --count;
+                done.notify_all(); // A ring slot just freed up
+                if (req.generation != req.voice->generation) continue; // Stolen voice, skip the read
+            }
+
+            // Read outside the lock so the render thread keeps going
+            const uint64_t first = preloadFrames + static_cast<uint64_t>(req.chunk) * chunkFrames;
+            const uint64_t frames = std::min(chunkFrames, sample.numFrames - first);
+            int16_t* dst = req.voice->chunks[req.slot].data();
+            sample.stream.seekg(static_cast<std::streamoff>(sizeof(WavHeader) + first * sample.header.blockAlign));
+            sample.stream.read(reinterpret_cast<char*>(dst), static_cast<std::streamsize>(frames * sample.header.blockAlign));
+            const uint64_t got = static_cast<uint64_t>(sample.stream.gcount());
+            sample.stream.clear();
+            std::fill(dst + got / sizeof(int16_t), dst + chunkFrames * sample.channels, 0);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                bytesRead += got;
+                // Only mark it ready if the voice still belongs to the same note
+                if (req.generation == req.voice->generation && req.voice->chunkIndex[req.slot] == req.chunk) {
+                    req.voice->chunkReady[req.slot] = true;
+                }
+            }
+            done.notify_all();
+        }
+    }
+
+    Sample& sample;
+    std::vector<StreamRequest> ring;
+    size_t head = 0, count = 0;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    bool stopping = false;
+    std::thread worker;
+};
+
+// Returns one frame (first channel, or the channel asked for) from wherever it lives
+inline float frameAt(const Sample& s, Voice& v, Streamer& streamer, uint64_t frame, int ch) {
+    if (frame >= s.numFrames) return 0.0f;
+    if (frame < preloadFrames) return s.attack[frame * s.channels + ch];
+
+    const int64_t chunk = static_cast<int64_t>((frame - preloadFrames) / chunkFrames);
+    const int slot = static_cast<int>(chunk % 2);
+    streamer.waitFor(v, slot);
+    const uint64_t local = (frame - preloadFrames) % chunkFrames;
+    return v.chunks[slot][local * s.channels + ch];
+}
+
+// Renders one voice into the stereo bus for this block.
+// Returns false when the note has finished.
+bool renderVoice(const Sample& s, Voice& v, Streamer& streamer, float* busLeft, float* busRight, int frames) {
+    const float scale = 1.0f / 32768.0f;
+    const int ch = s.channels;
+    const int chRight = (ch > 1) ? 1 : 0;
+    const int64_t lastChunk = (s.numFrames > preloadFrames) ? static_cast<int64_t>((s.numFrames - 1 - preloadFrames) / chunkFrames) : -1;
+
+    const float fracScale = 1.0f / 4294967296.0f;
+    const float gl = v.gainLeft * scale;
+    const float gr = v.gainRight * scale;
+
+    int i = v.startOffset;
+    while (i < frames) {
+        const uint64_t idx = v.position >> 32;
+        if (idx + 1 >= s.numFrames) return false;
+
+        if (idx >= v.regionStart && idx + 1 < v.regionEnd) {
+            // Fast path: work out how many output samples keep both frames
+            // inside the current region, then run a tight loop over them
+            const uint64_t limit = (v.regionEnd - 1) << 32;
+            const uint64_t room = (limit - v.position - 1) / v.step + 1;
+            const int span = static_cast<int>(std::min<uint64_t>(frames - i, room));
+            const int16_t* base = v.region - v.regionStart * ch;
+            for (int k = 0; k < span; ++k, ++i) {
+                // Each position is computed directly (not accumulated), so the
+                // iterations are independent and the CPU can overlap them
+                const uint64_t pos = v.position + k * v.step;
+                const float frac = static_cast<float>(pos & 0xFFFFFFFFu) * fracScale;
+                const int16_t* p = base + (pos >> 32) * ch;
+
+                // Linear interpolation between the two neighbouring frames
+                busLeft[i] += gl * (p[0] + frac * (p[ch] - p[0]));
+                busRight[i] += gr * (p[chRight] + frac * (p[ch + chRight] - p[chRight]));
+            }
+            v.position += span * v.step;
+            continue;
+        }
+
+        // Slow path: entered a new region (or straddling two of them)
+        if (idx < preloadFrames) {
+            v.region = s.attack.data();
+            v.regionStart = 0;
+            v.regionEnd = std::min(preloadFrames, s.numFrames);
+        } else {
+            // Entering chunk c means chunk c-1 is finished, so its buffer
+            // can be refilled with chunk c+1 while we play this one.
+            const int64_t chunk = static_cast<int64_t>((idx - preloadFrames) / chunkFrames);
+            if (chunk + 1 > v.highestRequested && chunk + 1 <= lastChunk) {
+                v.highestRequested = chunk + 1;
+                streamer.request(v, static_cast<int>((chunk + 1) % 2), chunk + 1);
+            }
+            const int slot = static_cast<int>(chunk % 2);
+            streamer.waitFor(v, slot);
+            v.region = v.chunks[slot].data();
+            v.regionStart = preloadFrames + static_cast<uint64_t>(chunk) * chunkFrames;
+            v.regionEnd = std::min(v.regionStart + chunkFrames, s.numFrames);
+        }
+        if (idx + 1 < v.regionEnd) continue; // Fast path can take it from here
+
+        const float frac = static_cast<float>(v.position & 0xFFFFFFFFu) * fracScale;
+        const float l0 = frameAt(s, v, streamer, idx, 0);
+        const float l1 = frameAt(s, v, streamer, idx + 1, 0);
+        const float r0 = frameAt(s, v, streamer, idx, chRight);
+        const float r1 = frameAt(s, v, streamer, idx + 1, chRight);
+        busLeft[i] += gl * (l0 + frac * (l1 - l0));
+        busRight[i] += gr * (r0 + frac * (r1 - r0));
+        v.position += v.step;
+        ++i;
+    }
+    v.startOffset = 0;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Render crew: splits the voice pool across threads for every block
+// ---------------------------------------------------------------------------
+// Voices never touch each other, so each thread renders its own slice of the
+// pool into its own bus. The main thread is crew member 0; run() returns once
+// every member has finished the current block.
+class RenderCrew {
+public:
+    RenderCrew(int members, std::function<void(int)> job) : work(std::move(job)) {
+        for (int t = 1; t < members; ++t) threads.emplace_back([this, t] { loop(t); });
+    }
+
+    ~RenderCrew() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        start.notify_all();
+        for (std::thread& t : threads) t.join();
+    }
+
+    void run() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++round;
+            pending = static_cast<int>(threads.size());
+        }
+        start.notify_all();
+        work(0);
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [&] { return pending == 0; });
+    }
+
+private:
+    void loop(int member) {
+        uint64_t seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                start.wait(lock, [&] { return stopping || round != seen; });
+                if (stopping) return;
+                seen = round;
+            }
+            work(member);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                --pending;
+            }
+            finished.notify_one();
+        }
+    }
+
+    std::function<void(int)> work;
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable start, finished;
+    uint64_t round = 0;
+    int pending = 0;
+    bool stopping = false;
+};
+
+// Tiny deterministic random number generator so every run plays the same notes
+uint32_t xorshift32(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+struct NoteEvent {
+    uint64_t frame;
+    float semitones;
+    float gain;
+    float pan;
+};
+
+int main(int argc, char* argv[]) {
+    const char* samplePath = (argc > 1) ? argv[1] : "input.wav";
+    const int maxVoices = (argc > 2) ? std::max(1, std::atoi(argv[2])) : 2048;
+    const double notesPerSecond = (argc > 3) ? std::atof(argv[3]) : 1000.0;
+    const double seconds = (argc > 4) ? std::atof(argv[4]) : 20.0;
+    const char* outputPath = "output_sampler.wav";
+
+    // Load the sample header and its attack portion
+    Sample sample;
+    sample.stream.open(samplePath, std::ios::binary);
+    if (!sample.stream) {
+        std::cerr << "Error: Could not open " << samplePath << "\n";
+        return 1;
+    }
+    sample.stream.read(reinterpret_cast<char*>(&sample.header), sizeof(WavHeader));
+    if (!sample.stream || sample.header.bitsPerSample != 16) {
+        std::cerr << "Error: " << samplePath << " is not a 16-bit PCM WAV file\n";
+        return 1;
+    }
+    sample.channels = sample.header.numChannels;
+    sample.numFrames = sample.header.subchunk2Size / sample.header.blockAlign;
+    if (sample.numFrames < 2) {
+        std::cerr << "Error: Sample is too short\n";
+        return 1;
+    }
+    const uint64_t attackFrames = std::min(preloadFrames, sample.numFrames);
+    sample.attack.assign(preloadFrames * sample.channels, 0);
+    sample.stream.read(reinterpret_cast<char*>(sample.attack.data()), static_cast<std::streamsize>(attackFrames * sample.header.blockAlign));
+
+    // Preallocate the voice pool
+    std::vector<Voice> voices(maxVoices);
+    for (Voice& v : voices) {
+        v.chunks[0].assign(chunkFrames * sample.channels, 0);
+        v.chunks[1].assign(chunkFrames * sample.channels, 0);
+    }
+
+    // Deterministic note list: random times, pitches (+-12 semitones), gains and pans
+    const uint32_t sampleRate = sample.header.sampleRate;
+    const uint64_t totalFrames = static_cast<uint64_t>(seconds * sampleRate);
+    const uint64_t numNotes = static_cast<uint64_t>(notesPerSecond * seconds);
+    std::vector<NoteEvent> notes(numNotes);
+    uint32_t rng = 0x1234567u;
+    for (NoteEvent& n : notes) {
+        n.frame = xorshift32(rng) % std::max<uint64_t>(1, totalFrames);
+        n.semitones = static_cast<float>(xorshift32(rng) % 2401) / 100.0f - 12.0f;
+        n.gain = 0.25f + 0.75f * static_cast<float>(xorshift32(rng) % 1000) / 1000.0f;
+        n.pan = static_cast<float>(xorshift32(rng) % 2001) / 1000.0f - 1.0f;
+    }
+    std::sort(notes.begin(), notes.end(), [](const NoteEvent& a, const NoteEvent& b) { return a.frame < b.frame; });
+
+    std::ofstream out(outputPath, std::ios::binary);
+    if (!out) {
+        std::cerr << "Error: Could not open output file.\n";
+        return 1;
+    }
+    WavHeader outHeader = sample.header;
+    outHeader.numChannels = 2;
+    outHeader.blockAlign = 4;
+    outHeader.byteRate = sampleRate * 4;
+    outHeader.subchunk2Size = static_cast<uint32_t>(totalFrames * 4);
+    outHeader.chunkSize = 36 + outHeader.subchunk2Size;
+    out.write(reinterpret_cast<const char*>(&outHeader), sizeof(WavHeader));
+
+    // Keep the sum of many voices in range
+    const float masterGain = 1.0f / std::sqrt(static_cast<float>(maxVoices));
+
+    uint64_t steals = 0, peakVoices = 0, clipped = 0, underruns = 0, stalls = 0, bytesRead = 0;
+    const auto t0 = std::chrono::steady_clock::now();
+    {
+        Streamer streamer(sample, static_cast<size_t>(maxVoices) * 2);
+        std::vector<int16_t> outBlock(renderBlock * 2);
+        size_t nextNote = 0;
+
+        // One bus and one slice of the voice pool per render thread
+        const int numThreads = static_cast<int>(std::clamp<unsigned>(std::thread::hardware_concurrency(), 1u, static_cast<unsigned>(maxVoices)));
+        std::vector<std::vector<float>> busLeft(numThreads, std::vector<float>(renderBlock));
+        std::vector<std::vector<float>> busRight(numThreads, std::vector<float>(renderBlock));
+        std::vector<uint64_t> activeCount(numThreads);
+        int frames = 0;
+
+        RenderCrew crew(numThreads, [&](int t) {
+            std::fill(busLeft[t].begin(), busLeft[t].end(), 0.0f);
+            std::fill(busRight[t].begin(), busRight[t].end(), 0.0f);
+            activeCount[t] = 0;
+            const size_t first = voices.size() * t / numThreads;
+            const size_t last = voices.size() * (t + 1) / numThreads;
+            for (size_t i = first; i < last; ++i) {
+                Voice& v = voices[i];
+                if (!v.active) continue;
+                ++activeCount[t];
+                if (!renderVoice(sample, v, streamer, busLeft[t].data(), busRight[t].data(), frames)) {
+                    v.active = false;
+                }
+            }
+        });
+
+        for (uint64_t blockStart = 0; blockStart < totalFrames; blockStart += renderBlock) {
+            frames = static_cast<int>(std::min<uint64_t>(renderBlock, totalFrames - blockStart));
+
+            // Start every note that falls inside this block
+            while (nextNote < notes.size() && notes[nextNote].frame < blockStart + frames) {
+                const NoteEvent& n = notes[nextNote++];
+
+                // Free voice, or steal the oldest one
+                Voice* target = nullptr;
+                for (Voice& v : voices) {
+                    if (!v.active) { target = &v; break; }
+                    if (!target || v.startFrame < target->startFrame) target = &v;
+                }
+                if (target->active) ++steals;
+                streamer.retire(*target);
+
+                Voice& v = *target;
+                v.active = true;
+                v.startFrame = n.frame;
+                v.startOffset = static_cast<int>(n.frame - blockStart);
+                v.position = 0;
+                v.step = static_cast<uint64_t>(std::llround(std::pow(2.0, n.semitones / 12.0) * 4294967296.0));
+                const float angle = static_cast<float>((n.pan + 1.0f) * M_PI / 4.0);
+                v.gainLeft = n.gain * std::cos(angle);
+                v.gainRight = n.gain * std::sin(angle);
+
+                // Start fetching the first two streamed chunks right away
+                for (int64_t c = 0; c < 2 && preloadFrames + c * chunkFrames < sample.numFrames; ++c) {
+                    v.highestRequested = c;
+                    streamer.request(v, static_cast<int>(c), c);
+                }
+            }
+
+            crew.run();
+
+            // Sum the thread buses in a fixed order so the result is repeatable
+            uint64_t active = 0;
+            for (int t = 0; t < numThreads; ++t) active += activeCount[t];
+            peakVoices = std::max(peakVoices, active);
+            for (int t = 1; t < numThreads; ++t) {
+                for (int i = 0; i < frames; ++i) {
+                    busLeft[0][i] += busLeft[t][i];
+                    busRight[0][i] += busRight[t][i];
+                }
+            }
+
+            for (int i = 0; i < frames; ++i) {
+                const float l = busLeft[0][i] * masterGain * 32768.0f;
+                const float r = busRight[0][i] * masterGain * 32768.0f;
+                clipped += (l > 32767.0f || l < -32768.0f) + (r > 32767.0f || r < -32768.0f);
+                outBlock[2 * i] = static_cast<int16_t>(std::clamp(l, -32768.0f, 32767.0f));
+                outBlock[2 * i + 1] = static_cast<int16_t>(std::clamp(r, -32768.0f, 32767.0f));
+            }
+            out.write(reinterpret_cast<const char*>(outBlock.data()), frames * 4);
+        }
+        underruns = streamer.underruns;
+        stalls = streamer.stalls;
+        bytesRead = streamer.bytesRead;
+    }
+    out.close();
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    const double voiceBufferMB = static_cast<double>(maxVoices) * 2 * chunkFrames * sample.channels * sizeof(int16_t) / (1024.0 * 1024.0);
+    std::printf("Rendered %.1f s with %llu notes in %.2f s (%.1fx realtime)\n", seconds, static_cast<unsigned long long>(numNotes), elapsed, seconds / elapsed);
+    std::printf("Voice pool: %d voices, peak %llu active, %llu stolen\n", maxVoices, static_cast<unsigned long long>(peakVoices), static_cast<unsigned long long>(steals));
+    std::printf("Streaming: %.1f MB read, %llu underruns (waited for disk), %llu request-queue stalls\n",
+        bytesRead / (1024.0 * 1024.0), static_cast<unsigned long long>(underruns), static_cast<unsigned long long>(stalls));
+    std::printf("Memory: %.1f KB preloaded attack, %.1f MB voice stream buffers\n",
+        sample.attack.size() * sizeof(int16_t) / 1024.0, voiceBufferMB);
+    if (clipped > 0) std::printf("Warning: %llu samples clipped\n", static_cast<unsigned long long>(clipped));
+    std::cout << "Wrote " << outputPath << "\n";
+    return 0;
+}
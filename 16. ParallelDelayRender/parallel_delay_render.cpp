@@ -0,0 +1,300 @@
+/*
+    MicroDSP - Day 16: Parallel Delay Rendering
+
+    What this program does:
+    - Reads a 16-bit PCM WAV file (default: input.wav)
+    - Renders the Day 4 delay over it TWICE:
+        1) serially, on one thread       -> output_delay_serial.wav
+        2) in parallel, on every core    -> output_delay_parallel.wav
+    - Checks that both files are bit-for-bit identical and prints the speedup
+
+    Usage:
+        parallel_delay_render [input.wav] [threads]
+
+    Why a delay can be split across cores:
+    - The Day 4 delay has no feedback:
+          y[n] = dry * x[n] + wet * x[n - D]
+      so output sample n only depends on the input from n - D to n. We call
+      D the processor's "memory length".
+    - That means we can cut a long file into segments and give each one to
+      a different thread. A segment that starts at sample s first feeds the
+      D samples before s through a freshly reset processor ("pre-roll") and
+      throws that output away. After the pre-roll the processor holds
+      exactly the same history the serial render would have at s, so
+      every output sample after it is identical.
+    - The pre-roll costs D extra samples per segment, so segments are kept
+      much longer than D (at least 8 x D, and 1M frames by default).
+
+    Any processor that can name a finite memory length works this way:
+    a gain has memory 0, a delay has memory D, and a chain of processors
+    has the sum of its parts. Processors WITH feedback (Day 5's feedback
+    delay, filters) have infinite memory and must render serially.
+
+    Streaming:
+    - Nothing is loaded whole. Every thread opens its own input and output
+      streams, reads its segment in blocks, and writes into its own region
+      of the pre-sized output file, so threads never share a file position.
+
+    Build:
+        g++ -std=c++17 -O3 -march=native -pthread parallel_delay_render.cpp -o parallel_delay_render
+
+    Author: Jesse Whiting (GhostWire Audio)
+    GitHub: ghostwireaudio
+*/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <filesystem>
+#include <cstdio>
+
+// Force the compiler to pack the struct exactly as written
+// with no padding bytes added for alignment, which ensures
+// sizeof(WavHeader) == 44 bytes
+#pragma pack(push, 1)
+struct WavHeader {
+    // RIFF Chunk Descriptor
+    char     riff[4];        // "RIFF"
+    uint32_t chunkSize;      // 36 + Subchunk2Size
+    char     wave[4];        // "WAVE"
+
+    // fmt subchunk
+    char     fmt[4];         // "fmt "
+    uint32_t subchunk1Size;  // 16 for PCM
+    uint16_t audioFormat;    // 1 for PCM
+    uint16_t numChannels;    // 1 for mono
+    uint32_t sampleRate;     // e.g., 44100
+    uint32_t byteRate;       // sampleRate * numChannels * bitsPerSample/8
+    uint16_t blockAlign;     // numChannels * bitsPerSample/8
+    uint16_t bitsPerSample;  // 16
+
+    // data subchunk
+    char     data[4];        // "data"
+    uint32_t subchunk2Size;  // NumSamples * numChannels * bitsPerSample/8
+};
+#pragma pack(pop)
+
+const uint64_t blockFrames = 4096;
+const uint64_t minSegmentFrames = 1 << 20;
+
+// ---------------------------------------------------------------------------
+// Processor interface
+// ---------------------------------------------------------------------------
+class Processor {
+public:
+    virtual ~Processor() = default;
+
+    // Called once before rendering, and again for every new segment
+    virtual void reset(int channels) = 0;
+
+    // Processes interleaved 16-bit frames, keeping state between calls
+    virtual void process(const int16_t* in, int16_t* out, uint64_t frames) = 0;
+
+    // How many past input frames the output depends on
+    virtual uint64_t memoryLength() const = 0;
+
+    // Each thread needs its own copy with its own state
+    virtual std::unique_ptr<Processor> clone() const = 0;
+};
+
+// The Day 4 delay (no feedback), rewritten with a circular buffer (Day 5)
+// so it can run block by block instead of needing the whole file in memory
+class FeedforwardDelay : public Processor {
+public:
+    FeedforwardDelay(uint64_t delayFrames, float dry, float wet)
+        : delay(delayFrames), dry(dry), wet(wet) {}
+
+    void reset(int numChannels) override {
+        channels = numChannels;
+        history.assign(std::max<uint64_t>(delay, 1) * channels, 0);
+        writeIndex = 0;
+    }
+
+    void process(const int16_t* in, int16_t* out, uint64_t frames) override {
+        for (uint64_t n = 0; n < frames; ++n) {
+            for (int c = 0; c < channels; ++c) {
+                const float x = static_cast<float>(in[n * channels + c]);
+
+                // The oldest entry in the ring is exactly D frames ago
+                // (zero until the ring has filled, like Day 4's n < D case)
+                const float d = (delay > 0) ? static_cast<float>(history[writeIndex * channels + c]) : x;
+                if (delay > 0) history[writeIndex * channels + c] = in[n * channels + c];
+
+                float mix = dry * x + wet * d;
+                mix = std::clamp(mix, -32768.0f, 32767.0f);
+                out[n * channels + c] = static_cast<int16_t>(mix);
+            }
+            if (delay > 0 && ++writeIndex == delay) writeIndex = 0;
+        }
+    }
+
+    uint64_t memoryLength() const override { return delay; }
+
+    std::unique_ptr<Processor> clone() const override {
+        return std::make_unique<FeedforwardDelay>(delay, dry, wet);
+    }
+
+private:
+    uint64_t delay;
+    float dry, wet;
+    int channels = 1;
+    std::vector<int16_t> history;
+    uint64_t writeIndex = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Renders frames [start, end) of the input into the same frames of the output
+// ---------------------------------------------------------------------------
+bool renderRange(const char* inputPath, const char* outputPath, const WavHeader& header,
+                 Processor& proc, uint64_t start, uint64_t end) {
+    std::ifstream in(inputPath, std::ios::binary);
+    std::fstream out(outputPath, std::ios::binary | std::ios::in | std::ios::out);
+    if (!in || !out) return false;
+
+    const int channels = header.numChannels;
+    std::vector<int16_t> inBlock(blockFrames * channels);
+    std::vector<int16_t> outBlock(blockFrames * channels);
+    proc.reset(channels);
+
+    // Pre-roll: rebuild the history the serial render would have at 'start'
+    const uint64_t preRollStart = start - std::min(start, proc.memoryLength());
+    in.seekg(static_cast<std::streamoff>(sizeof(WavHeader) + preRollStart * header.blockAlign));
+    for (uint64_t pos = preRollStart; pos < start; ) {
+        const uint64_t frames = std::min(blockFrames, start - pos);
+        in.read(reinterpret_cast<char*>(inBlock.data()), static_cast<std::streamsize>(frames * header.blockAlign));
+        if (!in) return false;
+        proc.process(inBlock.data(), outBlock.data(), frames); // Output discarded
+        pos += frames;
+    }
+
+    // The real segment, written into its own region of the output file
+    out.seekp(static_cast<std::streamoff>(sizeof(WavHeader) + start * header.blockAlign));
+    for (uint64_t pos = start; pos < end; ) {
+        const uint64_t frames = std::min(blockFrames, end - pos);
+        in.read(reinterpret_cast<char*>(inBlock.data()), static_cast<std::streamsize>(frames * header.blockAlign));
+        if (!in) return false;
+        proc.process(inBlock.data(), outBlock.data(), frames);
+        out.write(reinterpret_cast<const char*>(outBlock.data()), static_cast<std::streamsize>(frames * header.blockAlign));
+        pos += frames;
+    }
+    return static_cast<bool>(out);
+}
+
+// Creates the output file at its final size so threads can write anywhere in it
+bool createOutput(const char* outputPath, const WavHeader& header) {
+    std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(WavHeader));
+    out.close();
+    std::error_code ec;
+    std::filesystem::resize_file(outputPath, sizeof(WavHeader) + static_cast<uint64_t>(header.subchunk2Size), ec);
+    return !ec;
+}
+
+// Splits the file into segments and lets threads claim them one at a time
+bool renderParallel(const char* inputPath, const char* outputPath, const WavHeader& header,
+                    const Processor& proto, uint64_t numFrames, int numThreads) {
+    const uint64_t segmentFrames = std::max(minSegmentFrames, proto.memoryLength() * 8);
+    const uint64_t numSegments = (numFrames + segmentFrames - 1) / segmentFrames;
+
+    std::atomic<uint64_t> nextSegment{ 0 };
+    std::atomic<bool> ok{ true };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&] {
+            std::unique_ptr<Processor> proc = proto.clone();
+            for (uint64_t s = nextSegment++; s < numSegments; s = nextSegment++) {
+                const uint64_t start = s * segmentFrames;
+                const uint64_t end = std::min(numFrames, start + segmentFrames);
+                if (!renderRange(inputPath, outputPath, header, *proc, start, end)) ok = false;
+            }
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    return ok;
+}
+
+// Streams both files and compares them byte by byte
+bool filesIdentical(const char* a, const char* b) {
+    std::ifstream fa(a, std::ios::binary), fb(b, std::ios::binary);
+    if (!fa || !fb) return false;
+    std::vector<char> ba(1 << 16), bb(1 << 16);
+    while (true) {
+        fa.read(ba.data(), static_cast<std::streamsize>(ba.size()));
+        fb.read(bb.data(), static_cast<std::streamsize>(bb.size()));
+        if (fa.gcount() != fb.gcount()) return false;
+        if (!std::equal(ba.begin(), ba.begin() + fa.gcount(), bb.begin())) return false;
+        if (fa.gcount() == 0) return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const char* inputPath = (argc > 1) ? argv[1] : "input.wav";
+    const int numThreads = (argc > 2) ? std::max(1, std::atoi(argv[2])) : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    const char* serialPath = "output_delay_serial.wav";
+    const char* parallelPath = "output_delay_parallel.wav";
+
+    // Delay parameters (same as Day 4)
+    const float delayMs = 250.0f;
+    const float dry = 0.8f;
+    const float wet = 0.5f;
+
+    std::ifstream in(inputPath, std::ios::binary);
+    if (!in) {
+        std::cerr << "Error: Could not open input file.\n";
+        return 1;
+    }
+    WavHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(WavHeader));
+    if (!in || header.bitsPerSample != 16) {
+        std::cerr << "Error: Expected a 16-bit PCM WAV file.\n";
+        return 1;
+    }
+    in.close();
+    const uint64_t numFrames = header.subchunk2Size / header.blockAlign;
+
+    const uint64_t delayFrames = static_cast<uint64_t>((delayMs / 1000.0f) * header.sampleRate);
+    FeedforwardDelay delay(delayFrames, dry, wet);
+
+    // 1) Serial reference: one "segment" covering the whole file
+    if (!createOutput(serialPath, header)) {
+        std::cerr << "Error: Could not create " << serialPath << "\n";
+        return 1;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    std::unique_ptr<Processor> serialProc = delay.clone();
+    if (!renderRange(inputPath, serialPath, header, *serialProc, 0, numFrames)) {
+        std::cerr << "Error: Serial render failed.\n";
+        return 1;
+    }
+    const double serialSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    // 2) Parallel render with pre-rolled segments
+    if (!createOutput(parallelPath, header)) {
+        std::cerr << "Error: Could not create " << parallelPath << "\n";
+        return 1;
+    }
+    t0 = std::chrono::steady_clock::now();
+    if (!renderParallel(inputPath, parallelPath, header, delay, numFrames, numThreads)) {
+        std::cerr << "Error: Parallel render failed.\n";
+        return 1;
+    }
+    const double parallelSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    const uint64_t segmentFrames = std::max(minSegmentFrames, delay.memoryLength() * 8);
+    std::printf("Delay memory: %llu frames, segment length: %llu frames, %llu segments\n",
+        static_cast<unsigned long long>(delay.memoryLength()), static_cast<unsigned long long>(segmentFrames),
+        static_cast<unsigned long long>((numFrames + segmentFrames - 1) / segmentFrames));
+    std::printf("Serial:   %.3f s\n", serialSeconds);
+    std::printf("Parallel: %.3f s on %d threads (%.2fx)\n", parallelSeconds, numThreads, serialSeconds / parallelSeconds);
+
+    const bool identical = filesIdentical(serialPath, parallelPath);
+    std::cout << "Bit-identical to serial render: " << (identical ? "PASS" : "FAIL") << "\n";
+    return identical ? 0 : 1;
+}
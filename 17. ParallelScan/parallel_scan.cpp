@@ -0,0 +1,393 @@
+/*
+    MicroDSP - Day 17: Parallel Scan for Recursive Filters
+
+    What this program does:
+    - Reads a 16-bit PCM WAV file (default: input.wav)
+    - Runs two FEEDBACK processors over it, both serially and split across
+      threads with a "segmented scan":
+        1) a one-pole low-pass filter      -> output_scan_onepole.wav
+        2) the Day 5 delay with feedback   -> output_scan_feedback.wav
+    - Compares the parallel result against the serial one and prints how
+      the render time scales with the number of threads
+
+    Usage:
+        parallel_scan [input.wav]
+
+    Why feedback is harder than Day 16:
+    - Day 16 split the file into segments and gave every segment a short
+      "pre-roll". That only works when the output forgets the past after
+      D samples. With feedback, every output depends on ALL earlier input:
+          one-pole:  y[n] = (1 - a) * x[n] + a * y[n - 1]
+          feedback:  w[n] = x[n] + fb * w[n - D]
+                     y[n] = dry * x[n] + wet * w[n - D]
+      so there is no point where a pre-roll could start.
+
+    The trick: these filters are LINEAR.
+    - The output of a linear filter is (the response to the input, starting
+      from silence) + (the response to whatever state it started with).
+      The second part is the "zero-input" or state-transition response,
+      and for these filters it has a simple closed form:
+          one-pole: a state y decays to a^L * y after L samples
+          feedback: the delay line value s[j] comes back around as
+                    fb^(k / D + 1) * s[k % D] at offset k into the segment
+    - So the render runs in three passes:
+        Pass 1 (parallel): every thread runs its segment starting from a
+                 silent state and keeps only the state it ends with.
+        Pass 2 (serial, tiny): walk the segments in order. The true state
+                 at the end of segment i is its silent-start end state
+                 plus the true state at its start, pushed L samples
+                 forward with the zero-input response. This is the "scan".
+        Pass 3 (parallel): every thread runs its segment again, now
+                 starting from its true state, and writes the output.
+    - Each sample is processed twice, so T threads give up to a T/2
+      speedup. Nothing needs to be kept in memory between passes except
+      one state per segment, so it works on files of any length.
+    - The boundary states are computed in a different order than in the
+      serial render, so results can differ by rounding. The filters run in
+      double precision, which keeps that far below one 16-bit step.
+
+    Build:
+        g++ -std=c++17 -O3 -march=native -pthread parallel_scan.cpp -o parallel_scan
+
+    Author: Jesse Whiting (GhostWire Audio)
+    GitHub: ghostwireaudio
+*/
+
+#define _USE_MATH_DEFINES
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <filesystem>
+#include <cstdio>
+
+// Force the compiler to pack the struct exactly as written
+// with no padding bytes added for alignment, which ensures
+// sizeof(WavHeader) == 44 bytes
+#pragma pack(push, 1)
+struct WavHeader {
+    // RIFF Chunk Descriptor
+    char     riff[4];        // "RIFF"
+    uint32_t chunkSize;      // 36 + Subchunk2Size
+    char     wave[4];        // "WAVE"
+
+    // fmt subchunk
+    char     fmt[4];         // "fmt "
+    uint32_t subchunk1Size;  // 16 for PCM
+    uint16_t audioFormat;    // 1 for PCM
+    uint16_t numChannels;    // 1 for mono
+    uint32_t sampleRate;     // e.g., 44100
+    uint32_t byteRate;       // sampleRate * numChannels * bitsPerSample/8
+    uint16_t blockAlign;     // numChannels * bitsPerSample/8
+    uint16_t bitsPerSample;  // 16
+
+    // data subchunk
+    char     data[4];        // "data"
+    uint32_t subchunk2Size;  // NumSamples * numChannels * bitsPerSample/8
+};
+#pragma pack(pop)
+
+const uint64_t blockFrames = 4096;
+
+using State = std::vector<double>;
+
+inline int16_t toInt16(double v) {
+    return static_cast<int16_t>(std::clamp(v, -32768.0, 32767.0));
+}
+
+// ---------------------------------------------------------------------------
+// One-pole low-pass: y[n] = (1 - a) * x[n] + a * y[n - 1]
+// State: the last output of every channel
+// ---------------------------------------------------------------------------
+class OnePoleLowpass {
+public:
+    OnePoleLowpass(double cutoffHz, double sampleRate, int channels)
+        : a(std::exp(-2.0 * M_PI * cutoffHz / sampleRate)), channels(channels), y(channels, 0.0) {}
+
+    State zeroState() const { return State(channels, 0.0); }
+    State getState() const { return y; }
+    void setState(const State& s) { y = s; }
+
+    // 'out' may be nullptr when only the final state is wanted (pass 1)
+    void process(const int16_t* in, int16_t* out, uint64_t frames) {
+        for (uint64_t n = 0; n < frames; ++n) {
+            for (int c = 0; c < channels; ++c) {
+                y[c] = (1.0 - a) * in[n * channels + c] + a * y[c];
+                if (out) out[n * channels + c] = toInt16(y[c]);
+            }
+        }
+    }
+
+    // Where a starting state ends up after 'frames' samples of silence
+    State propagate(const State& s, uint64_t frames) const {
+        const double decay = std::pow(a, static_cast<double>(frames));
+        State r(channels);
+        for (int c = 0; c < channels; ++c) r[c] = decay * s[c];
+        return r;
+    }
+
+private:
+    double a;
+    int channels;
+    State y;
+};
+
+// ---------------------------------------------------------------------------
+// Feedback delay (Day 5 with a feedback path):
+//     w[n] = x[n] + fb * w[n - D]
+//     y[n] = dry * x[n] + wet * w[n - D]
+// State: the last D values of w for every channel, oldest first
+// ---------------------------------------------------------------------------
+class FeedbackDelay {
+public:
+    FeedbackDelay(uint64_t delayFrames, double feedback, double dry, double wet, int channels)
+        : delay(std::max<uint64_t>(delayFrames, 1)), fb(feedback), dry(dry), wet(wet), channels(channels),
+          ring(delay * channels, 0.0) {}
+
+    State zeroState() const { return State(delay * channels, 0.0); }
+
+    // The ring buffer is stored rotated; states are always handed out oldest first
+    State getState() const {
+        State s(delay * channels);
+        for (uint64_t j = 0; j < delay; ++j) {
+            const uint64_t r = (index + j) % delay;
+            for (int c = 0; c < channels; ++c) s[j * channels + c] = ring[r * channels + c];
+        }
+        return s;
+    }
+
+    void setState(const State& s) {
+        ring = s;
+        index = 0;
+    }
+
+    void process(const int16_t* in, int16_t* out, uint64_t frames) {
+        for (uint64_t n = 0; n < frames; ++n) {
+            for (int c = 0; c < channels; ++c) {
+                const double x = in[n * channels + c];
+                const double old = ring[index * channels + c]; // w[n - D]
+                ring[index * channels + c] = x + fb * old;
+                if (out) out[n * channels + c] = toInt16(dry * x + wet * old);
+            }
+            if (++index == delay) index = 0;
+        }
+    }
+
+    // With no input, w at offset k into the segment is fb^(k / D + 1) * s[k % D].
+    // The new state is w at offsets frames - D ... frames - 1.
+    State propagate(const State& s, uint64_t frames) const {
+        State r(delay * channels);
+        for (uint64_t j = 0; j < delay; ++j) {
+            const int64_t k = static_cast<int64_t>(frames) - static_cast<int64_t>(delay) + static_cast<int64_t>(j);
+            for (int c = 0; c < channels; ++c) {
+                if (k < 0) {
+                    // Still inside the old state (segment shorter than D)
+                    r[j * channels + c] = s[(frames + j) * channels + c];
+                } else {
+                    const double gain = std::pow(fb, static_cast<double>(k / static_cast<int64_t>(delay) + 1));
+                    r[j * channels + c] = gain * s[(k % delay) * channels + c];
+                }
+            }
+        }
+        return r;
+    }
+
+private:
+    uint64_t delay;
+    double fb, dry, wet;
+    int channels;
+    State ring;
+    uint64_t index = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Streams frames [start, end) through a filter, writing output if asked to
+// ---------------------------------------------------------------------------
+template <typename Filter>
+bool runSegment(const char* inputPath, const char* outputPath, const WavHeader& header,
+                Filter& filter, uint64_t start, uint64_t end, bool writeOutput) {
+    std::ifstream in(inputPath, std::ios::binary);
+    std::fstream out;
+    if (writeOutput) out.open(outputPath, std::ios::binary | std::ios::in | std::ios::out);
+    if (!in || (writeOutput && !out)) return false;
+
+    std::vector<int16_t> inBlock(blockFrames * header.numChannels);
+    std::vector<int16_t> outBlock(blockFrames * header.numChannels);
+    in.seekg(static_cast<std::streamoff>(sizeof(WavHeader) + start * header.blockAlign));
+    if (writeOutput) out.seekp(static_cast<std::streamoff>(sizeof(WavHeader) + start * header.blockAlign));
+
+    for (uint64_t pos = start; pos < end; ) {
+        const uint64_t frames = std::min(blockFrames, end - pos);
+        in.read(reinterpret_cast<char*>(inBlock.data()), static_cast<std::streamsize>(frames * header.blockAlign));
+        if (!in) return false;
+        filter.process(inBlock.data(), writeOutput ? outBlock.data() : nullptr, frames);
+        if (writeOutput) out.write(reinterpret_cast<const char*>(outBlock.data()), static_cast<std::streamsize>(frames * header.blockAlign));
+        pos += frames;
+    }
+    return !writeOutput || static_cast<bool>(out);
+}
+
+// Creates the output file at its final size so threads can write anywhere in it
+bool createOutput(const char* outputPath, const WavHeader& header) {
+    std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(WavHeader));
+    out.close();
+    std::error_code ec;
+    std::filesystem::resize_file(outputPath, sizeof(WavHeader) + static_cast<uint64_t>(header.subchunk2Size), ec);
+    return !ec;
+}
+
+// The three-pass segmented scan described at the top of the file
+template <typename Filter>
+bool renderScan(const char* inputPath, const char* outputPath, const WavHeader& header,
+                const Filter& proto, uint64_t numFrames, int numThreads) {
+    const uint64_t segments = std::max<uint64_t>(1, std::min<uint64_t>(numThreads, numFrames));
+    std::vector<uint64_t> bounds(segments + 1);
+    for (uint64_t s = 0; s <= segments; ++s) bounds[s] = numFrames * s / segments;
+
+    std::vector<State> endState(segments);
+    std::atomic<bool> ok{ true };
+
+    // Pass 1: every segment from silence, keeping only where it ends up.
+    // The last segment's end state is never needed, so it is skipped.
+    {
+        std::vector<std::thread> threads;
+        for (uint64_t s = 0; s + 1 < segments; ++s) {
+            threads.emplace_back([&, s] {
+                Filter f = proto;
+                f.setState(proto.zeroState());
+                if (!runSegment(inputPath, outputPath, header, f, bounds[s], bounds[s + 1], false)) ok = false;
+                endState[s] = f.getState();
+            });
+        }
+        for (std::thread& t : threads) t.join();
+    }
+    if (!ok) return false;
+
+    // Pass 2: the scan. trueStart[s + 1] = endState[s] + trueStart[s] pushed forward.
+    std::vector<State> trueStart(segments, proto.zeroState());
+    for (uint64_t s = 0; s + 1 < segments; ++s) {
+        const State carried = proto.propagate(trueStart[s], bounds[s + 1] - bounds[s]);
+        trueStart[s + 1] = endState[s];
+        for (size_t i = 0; i < carried.size(); ++i) trueStart[s + 1][i] += carried[i];
+    }
+
+    // Pass 3: every segment again from its true state, writing its own region
+    {
+        std::vector<std::thread> threads;
+        for (uint64_t s = 0; s < segments; ++s) {
+            threads.emplace_back([&, s] {
+                Filter f = proto;
+                f.setState(trueStart[s]);
+                if (!runSegment(inputPath, outputPath, header, f, bounds[s], bounds[s + 1], true)) ok = false;
+            });
+        }
+        for (std::thread& t : threads) t.join();
+    }
+    return ok;
+}
+
+// Largest sample difference between two WAV files of the same size
+bool compareOutputs(const char* a, const char* b, int& maxDiff, uint64_t& differing) {
+    std::ifstream fa(a, std::ios::binary), fb(b, std::ios::binary);
+    if (!fa || !fb) return false;
+    fa.seekg(sizeof(WavHeader));
+    fb.seekg(sizeof(WavHeader));
+    std::vector<int16_t> ba(1 << 15), bb(1 << 15);
+    maxDiff = 0;
+    differing = 0;
+    while (true) {
+        fa.read(reinterpret_cast<char*>(ba.data()), static_cast<std::streamsize>(ba.size() * sizeof(int16_t)));
+        fb.read(reinterpret_cast<char*>(bb.data()), static_cast<std::streamsize>(bb.size() * sizeof(int16_t)));
+        const size_t n = static_cast<size_t>(std::min(fa.gcount(), fb.gcount())) / sizeof(int16_t);
+        if (n == 0) return fa.gcount() == fb.gcount();
+        for (size_t i = 0; i < n; ++i) {
+            const int d = std::abs(static_cast<int>(ba[i]) - static_cast<int>(bb[i]));
+            maxDiff = std::max(maxDiff, d);
+            differing += (d != 0);
+        }
+    }
+}
+
+// Serial reference, then the scan at 1, 2, 4, ... threads
+template <typename Filter>
+bool benchmark(const std::string& name, const char* inputPath, const WavHeader& header,
+               const Filter& proto, uint64_t numFrames, int maxThreads) {
+    const std::string serialPath = "output_serial_" + name + ".wav";
+    const std::string scanPath = "output_scan_" + name + ".wav";
+
+    if (!createOutput(serialPath.c_str(), header)) return false;
+    auto t0 = std::chrono::steady_clock::now();
+    Filter serial = proto;
+    if (!runSegment(inputPath, serialPath.c_str(), header, serial, 0, numFrames, true)) return false;
+    const double serialSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::printf("\n%s\n", name.c_str());
+    std::printf("  threads   seconds   speedup   max diff (LSB)   samples differing\n");
+    std::printf("  serial   %8.3f\n", serialSeconds);
+
+    std::vector<int> counts;
+    for (int t = 1; t < maxThreads; t *= 2) counts.push_back(t);
+    counts.push_back(maxThreads);
+
+    for (int t : counts) {
+        if (!createOutput(scanPath.c_str(), header)) return false;
+        t0 = std::chrono::steady_clock::now();
+        if (!renderScan(inputPath, scanPath.c_str(), header, proto, numFrames, t)) return false;
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        int maxDiff = 0;
+        uint64_t differing = 0;
+        if (!compareOutputs(serialPath.c_str(), scanPath.c_str(), maxDiff, differing)) return false;
+        std::printf("  %6d   %8.3f   %6.2fx   %14d   %17llu\n", t, seconds, serialSeconds / seconds, maxDiff,
+            static_cast<unsigned long long>(differing));
+    }
+    std::filesystem::remove(serialPath);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    const char* inputPath = (argc > 1) ? argv[1] : "input.wav";
+    const int maxThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    // Filter parameters
+    const double cutoffHz = 1000.0;
+    const float delayMs = 250.0f;
+    const double feedback = 0.5;
+    const double dry = 0.8;
+    const double wet = 0.5;
+
+    std::ifstream in(inputPath, std::ios::binary);
+    if (!in) {
+        std::cerr << "Error: Could not open input file.\n";
+        return 1;
+    }
+    WavHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(WavHeader));
+    if (!in || header.bitsPerSample != 16) {
+        std::cerr << "Error: Expected a 16-bit PCM WAV file.\n";
+        return 1;
+    }
+    in.close();
+    const uint64_t numFrames = header.subchunk2Size / header.blockAlign;
+    const uint64_t delayFrames = static_cast<uint64_t>((delayMs / 1000.0f) * header.sampleRate);
+
+    std::printf("%llu frames, %d channel(s), up to %d threads\n",
+        static_cast<unsigned long long>(numFrames), header.numChannels, maxThreads);
+
+    const OnePoleLowpass onePole(cutoffHz, header.sampleRate, header.numChannels);
+    const FeedbackDelay feedbackDelay(delayFrames, feedback, dry, wet, header.numChannels);
+    if (!benchmark("onepole", inputPath, header, onePole, numFrames, maxThreads) ||
+        !benchmark("feedback", inputPath, header, feedbackDelay, numFrames, maxThreads)) {
+        std::cerr << "Error: Render failed.\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,373 @@
+/*
+    MicroDSP - Day 18: Identity Fast Paths
+
+    What this program does:
+    - Reads a 16-bit PCM WAV file (default: input.wav)
+    - Renders three jobs through a small render engine:
+        1) the Day 3 bypass fade (dry for 1 s, then a 10 ms fade to gain 2.0)
+        2) the Day 2 gain at exactly 1.0
+        3) the Day 2 gain at 0.5
+    - Each job is rendered twice: the plain way (decode, process and
+      re-encode every sample) and with the identity fast path. Both outputs
+      must be byte-for-byte identical.
+    - Prints how many bytes were copied vs computed, and the time taken
+
+    Usage:
+        identity_fast_path [input.wav]
+
+    The idea:
+    - Many processors leave parts of a file exactly as they were. The first
+      second of Day 3 is fully dry: (1 - 0) * x + 0 * wet == x, bit for bit.
+      A gain of 1.0 leaves the whole file alone.
+    - Decoding those samples to double, multiplying, clamping and encoding
+      them again is wasted work. Instead every processor can report its
+      "identity ranges": frame ranges where output == input exactly.
+    - The engine copies those byte ranges straight from the input file to
+      the output file and only runs process() on everything else.
+
+    How the copy is done:
+    - On Linux, copy_file_range() asks the kernel to copy between two files
+      directly. The data never comes up into our program, and on network
+      filesystems the server may do the copy itself.
+    - Filesystems like Btrfs and XFS can "reflink" (share the disk blocks
+      instead of copying them), but only for block-aligned offsets (usually
+      4096 bytes). Our audio starts right after the 44-byte header, so most
+      copies will be plain in-kernel copies. That is still much cheaper
+      than processing the samples.
+    - Everywhere else (or if the kernel refuses), a simple buffered
+      read/write loop is used. That skips the processing but still moves
+      the bytes through our program.
+
+    Build:
+        g++ -std=c++17 -O3 -march=native identity_fast_path.cpp -o identity_fast_path
+
+    Author: Jesse Whiting (GhostWire Audio)
+    GitHub: ghostwireaudio
+*/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <cstdio>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Force the compiler to pack the struct exactly as written
+// with no padding bytes added for alignment, which ensures
+// sizeof(WavHeader) == 44 bytes
+#pragma pack(push, 1)
+struct WavHeader {
+    // RIFF Chunk Descriptor
+    char     riff[4];        // "RIFF"
+    uint32_t chunkSize;      // 36 + Subchunk2Size
+    char     wave[4];        // "WAVE"
+
+    // fmt subchunk
+    char     fmt[4];         // "fmt "
+    uint32_t subchunk1Size;  // 16 for PCM
+    uint16_t audioFormat;    // 1 for PCM
+    uint16_t numChannels;    // 1 for mono
+    uint32_t sampleRate;     // e.g., 44100
+    uint32_t byteRate;       // sampleRate * numChannels * bitsPerSample/8
+    uint16_t blockAlign;     // numChannels * bitsPerSample/8
+    uint16_t bitsPerSample;  // 16
+
+    // data subchunk
+    char     data[4];        // "data"
+    uint32_t subchunk2Size;  // NumSamples * numChannels * bitsPerSample/8
+};
+#pragma pack(pop)
+
+const uint64_t blockFrames = 4096;
+
+// A range of frames [start, end)
+struct FrameRange {
+    uint64_t start;
+    uint64_t end;
+};
+
+// ---------------------------------------------------------------------------
+// Processor interface
+// ---------------------------------------------------------------------------
+class Processor {
+public:
+    virtual ~Processor() = default;
+
+    // Processes interleaved frames; firstFrame is where 'in' starts in the file
+    virtual void process(const int16_t* in, int16_t* out, uint64_t frames, uint64_t firstFrame, int channels) = 0;
+
+    // Frame ranges (sorted, not overlapping) where the output is exactly the
+    // input. Returning nothing is always safe; it just means no fast path.
+    virtual std::vector<FrameRange> identityRanges(uint64_t numFrames) const = 0;
+};
+
+// Day 2: multiply every sample by a gain
+class Gain : public Processor {
+public:
+    explicit Gain(double g) : gain(g) {}
+
+    void process(const int16_t* in, int16_t* out, uint64_t frames, uint64_t, int channels) override {
+        for (uint64_t i = 0; i < frames * channels; ++i) {
+            const double processed = std::clamp(in[i] * gain, -32768.0, 32767.0);
+            out[i] = static_cast<int16_t>(processed);
+        }
+    }
+
+    std::vector<FrameRange> identityRanges(uint64_t numFrames) const override {
+        if (gain == 1.0) return { { 0, numFrames } };
+        return {};
+    }
+
+private:
+    double gain;
+};
+
+// Day 3: dry until fadeStart, then a linear fade to (input * gain)
+class BypassFade : public Processor {
+public:
+    BypassFade(double gain, uint64_t fadeStart, uint64_t fadeFrames)
+        : gain(gain), fadeStart(fadeStart), fadeFrames(std::max<uint64_t>(fadeFrames, 1)) {}
+
+    void process(const int16_t* in, int16_t* out, uint64_t frames, uint64_t firstFrame, int channels) override {
+        for (uint64_t n = 0; n < frames; ++n) {
+            const uint64_t index = firstFrame + n;
+            double mix = 0.0;
+            if (index >= fadeStart + fadeFrames) {
+                mix = 1.0;
+            } else if (index >= fadeStart) {
+                mix = static_cast<double>(index - fadeStart) / static_cast<double>(fadeFrames);
+            }
+            for (int c = 0; c < channels; ++c) {
+                const double dry = in[n * channels + c];
+                const double wet = dry * gain;
+                const double mixed = std::clamp((1.0 - mix) * dry + mix * wet, -32768.0, 32767.0);
+                out[n * channels + c] = static_cast<int16_t>(mixed);
+            }
+        }
+    }
+
+    // Everything before the fade starts is untouched
+    std::vector<FrameRange> identityRanges(uint64_t numFrames) const override {
+        if (fadeStart == 0) return {};
+        return { { 0, std::min(fadeStart, numFrames) } };
+    }
+
+private:
+    double gain;
+    uint64_t fadeStart, fadeFrames;
+};
+
+// ---------------------------------------------------------------------------
+// Byte copier: copy_file_range on Linux, buffered copy everywhere else
+// ---------------------------------------------------------------------------
+class RangeCopier {
+public:
+    RangeCopier(const char* inputPath, const char* outputPath) {
+        in.open(inputPath, std::ios::binary);
+#ifdef __linux__
+        inFd = ::open(inputPath, O_RDONLY);
+        outFd = ::open(outputPath, O_WRONLY);
+#endif
+        (void)outputPath;
+    }
+
+    ~RangeCopier() {
+#ifdef __linux__
+        if (inFd >= 0) ::close(inFd);
+        if (outFd >= 0) ::close(outFd);
+#endif
+    }
+
+    // Copies 'length' bytes at 'offset' from the input to the same offset in the output
+    bool copy(std::fstream& out, uint64_t offset, uint64_t length) {
+#ifdef __linux__
+        if (inFd >= 0 && outFd >= 0) {
+            out.flush(); // Anything the stream still holds must land first
+            loff_t inOff = static_cast<loff_t>(offset);
+            loff_t outOff = static_cast<loff_t>(offset);
+            while (length > 0) {
+                const ssize_t n = ::copy_file_range(inFd, &inOff, outFd, &outOff, length, 0);
+                if (n <= 0) break; // Not supported here (or cross-device): fall back below
+                length -= static_cast<uint64_t>(n);
+                kernelBytes += static_cast<uint64_t>(n);
+            }
+            offset = static_cast<uint64_t>(inOff);
+            if (length == 0) return true;
+        }
+#endif
+        // Portable fallback: plain read/write, still no decode or processing
+        std::vector<char> buffer(1 << 16);
+        in.seekg(static_cast<std::streamoff>(offset));
+        out.seekp(static_cast<std::streamoff>(offset));
+        while (length > 0) {
+            const uint64_t chunk = std::min<uint64_t>(length, buffer.size());
+            in.read(buffer.data(), static_cast<std::streamsize>(chunk));
+            if (!in) return false;
+            out.write(buffer.data(), static_cast<std::streamsize>(chunk));
+            length -= chunk;
+            bufferedBytes += chunk;
+        }
+        return static_cast<bool>(out);
+    }
+
+    uint64_t kernelBytes = 0;
+    uint64_t bufferedBytes = 0;
+
+private:
+    std::ifstream in;
+#ifdef __linux__
+    int inFd = -1;
+    int outFd = -1;
+#endif
+};
+
+struct RenderStats {
+    uint64_t copiedBytes = 0;
+    uint64_t computedBytes = 0;
+    uint64_t kernelBytes = 0;
+    double seconds = 0.0;
+};
+
+// Runs process() over frames [start, end), streaming block by block
+bool computeRange(std::ifstream& in, std::fstream& out, const WavHeader& header, Processor& proc,
+                  uint64_t start, uint64_t end) {
+    std::vector<int16_t> inBlock(blockFrames * header.numChannels);
+    std::vector<int16_t> outBlock(blockFrames * header.numChannels);
+    in.seekg(static_cast<std::streamoff>(sizeof(WavHeader) + start * header.blockAlign));
+    out.seekp(static_cast<std::streamoff>(sizeof(WavHeader) + start * header.blockAlign));
+    for (uint64_t pos = start; pos < end; ) {
+        const uint64_t frames = std::min(blockFrames, end - pos);
+        in.read(reinterpret_cast<char*>(inBlock.data()), static_cast<std::streamsize>(frames * header.blockAlign));
+        if (!in) return false;
+        proc.process(inBlock.data(), outBlock.data(), frames, pos, header.numChannels);
+        out.write(reinterpret_cast<const char*>(outBlock.data()), static_cast<std::streamsize>(frames * header.blockAlign));
+        pos += frames;
+    }
+    return static_cast<bool>(out);
+}
+
+// Renders a whole file. With useFastPath, identity ranges are copied instead of processed.
+bool render(const char* inputPath, const char* outputPath, const WavHeader& header, Processor& proc,
+            bool useFastPath, RenderStats& stats) {
+    const auto t0 = std::chrono::steady_clock::now();
+    const uint64_t numFrames = header.subchunk2Size / header.blockAlign;
+
+    // Create the output at full size, header first
+    {
+        std::ofstream create(outputPath, std::ios::binary | std::ios::trunc);
+        if (!create) return false;
+        create.write(reinterpret_cast<const char*>(&header), sizeof(WavHeader));
+    }
+    std::error_code ec;
+    std::filesystem::resize_file(outputPath, sizeof(WavHeader) + static_cast<uint64_t>(header.subchunk2Size), ec);
+    if (ec) return false;
+
+    std::ifstream in(inputPath, std::ios::binary);
+    std::fstream out(outputPath, std::ios::binary | std::ios::in | std::ios::out);
+    if (!in || !out) return false;
+    RangeCopier copier(inputPath, outputPath);
+
+    std::vector<FrameRange> identity;
+    if (useFastPath) identity = proc.identityRanges(numFrames);
+
+    // Walk the file: compute the gaps between identity ranges, copy the ranges
+    uint64_t pos = 0;
+    for (const FrameRange& r : identity) {
+        const uint64_t start = std::clamp(r.start, pos, numFrames);
+        const uint64_t end = std::clamp(r.end, start, numFrames);
+        if (start > pos) {
+            if (!computeRange(in, out, header, proc, pos, start)) return false;
+            stats.computedBytes += (start - pos) * header.blockAlign;
+        }
+        if (end > start) {
+            if (!copier.copy(out, sizeof(WavHeader) + start * header.blockAlign, (end - start) * header.blockAlign)) return false;
+            stats.copiedBytes += (end - start) * header.blockAlign;
+        }
+        pos = std::max(pos, end);
+    }
+    if (pos < numFrames) {
+        if (!computeRange(in, out, header, proc, pos, numFrames)) return false;
+        stats.computedBytes += (numFrames - pos) * header.blockAlign;
+    }
+    out.close();
+
+    stats.kernelBytes = copier.kernelBytes;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return true;
+}
+
+// Streams both files and compares them byte by byte
+bool filesIdentical(const std::string& a, const std::string& b) {
+    std::ifstream fa(a, std::ios::binary), fb(b, std::ios::binary);
+    if (!fa || !fb) return false;
+    std::vector<char> ba(1 << 16), bb(1 << 16);
+    while (true) {
+        fa.read(ba.data(), static_cast<std::streamsize>(ba.size()));
+        fb.read(bb.data(), static_cast<std::streamsize>(bb.size()));
+        if (fa.gcount() != fb.gcount()) return false;
+        if (!std::equal(ba.begin(), ba.begin() + fa.gcount(), bb.begin())) return false;
+        if (fa.gcount() == 0) return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const char* inputPath = (argc > 1) ? argv[1] : "input.wav";
+
+    std::ifstream in(inputPath, std::ios::binary);
+    if (!in) {
+        std::cerr << "Error: Could not open input file.\n";
+        return 1;
+    }
+    WavHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(WavHeader));
+    if (!in || header.bitsPerSample != 16) {
+        std::cerr << "Error: Expected a 16-bit PCM WAV file.\n";
+        return 1;
+    }
+    in.close();
+
+    // Day 3 settings, but timed from the file's real sample rate
+    const double fadeMs = 10.0;
+    const double bypassUntilSeconds = 1.0;
+    const uint64_t fadeStart = static_cast<uint64_t>(header.sampleRate * bypassUntilSeconds);
+    const uint64_t fadeFrames = static_cast<uint64_t>(header.sampleRate * (fadeMs / 1000.0));
+
+    struct Job {
+        std::string name;
+        std::unique_ptr<Processor> proc;
+    };
+    std::vector<Job> jobs;
+    jobs.push_back({ "bypass", std::make_unique<BypassFade>(2.0, fadeStart, fadeFrames) });
+    jobs.push_back({ "gain_unity", std::make_unique<Gain>(1.0) });
+    jobs.push_back({ "gain_half", std::make_unique<Gain>(0.5) });
+
+    bool allMatch = true;
+    std::printf("%-12s %10s %10s %12s %12s %14s   %s\n", "job", "plain (s)", "fast (s)", "copied (KB)", "computed (KB)", "kernel copy (KB)", "match");
+    for (Job& job : jobs) {
+        const std::string plainPath = "output_" + job.name + "_plain.wav";
+        const std::string fastPath = "output_" + job.name + ".wav";
+
+        RenderStats plain, fast;
+        if (!render(inputPath, plainPath.c_str(), header, *job.proc, false, plain) ||
+            !render(inputPath, fastPath.c_str(), header, *job.proc, true, fast)) {
+            std::cerr << "Error: Render failed for " << job.name << "\n";
+            return 1;
+        }
+
+        const bool match = filesIdentical(plainPath, fastPath);
+        allMatch = allMatch && match;
+        std::filesystem::remove(plainPath);
+        std::printf("%-12s %10.4f %10.4f %12.1f %12.1f %14.1f   %s\n", job.name.c_str(), plain.seconds, fast.seconds,
+            fast.copiedBytes / 1024.0, fast.computedBytes / 1024.0, fast.kernelBytes / 1024.0, match ? "PASS" : "FAIL");
+    }
+    return allMatch ? 0 : 1;
+}
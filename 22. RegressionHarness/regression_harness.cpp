@@ -0,0 +1,353 @@
+/*
+    MicroDSP - Day 22: Regression Harness
+
+    What this program does:
+    - Builds the six original programs from their own source files and runs
+      them, unchanged, on the same generated input every time:
+        hello_sine           Day 1   440 Hz sine generator
+        gain                 Day 2   gain of 0.5
+        bypass_fade          Day 3   dry for 1 s, 10 ms fade to gain 2.0
+        intentional_click    Day 3   hard switch to gain 2.0 at 1 s
+        delay_array          Day 4   array-indexing delay, 250 ms
+        delay_circular       Day 5   circular-buffer delay, 250 ms
+      Each program runs in its own folder under harness_work/: the input is
+      written there under the name the program expects (hello_sine.wav or
+      input.wav), and the file it writes is read back.
+    - Compares each output to a stored "golden" WAV in golden/
+    - Times each program in nanoseconds per output sample and compares that
+      against a stored baseline (baseline.txt)
+    - Exits with 1 if any program fails to build, any output changed, or
+      any program got slower than the allowed threshold, so it can gate
+      optimization work on the programs themselves
+
+    Usage (from this folder):
+        regression_harness [--update] [--tolerance LSB] [--threshold PERCENT] [--root DIR]
+    --update       rewrite the golden files and the timing baseline
+    --tolerance    largest allowed sample difference (default 0 = exact)
+    --threshold    allowed slowdown vs the baseline (default 20 %)
+    --root         the repository folder holding the Day folders (default ..)
+    The compiler is $CXX, or g++ if that isn't set. The programs are run
+    through the shell (cd folder && ./program), so this needs a POSIX shell.
+
+    Golden outputs vs timing baseline:
+    - The golden WAVs are part of the project: the output of a program must
+      not change when it gets faster. If an optimization legitimately
+      changes rounding (e.g. summing in a different order), run with
+      --tolerance 1, or --update once you have checked the new output.
+    - Timings depend on the machine, so baseline.txt is written on the first
+      run on each computer and is NOT meant to be shared: it is listed in
+      .gitignore, along with harness_work/. Re-run with --update after a
+      deliberate change in performance.
+    - Each program is timed several times and the fastest run is kept, which
+      filters out most noise from other programs running at the same time.
+      The time covers the whole run (start-up and file I/O too), because
+      that is what a user of the program waits for.
+    - The programs are built with -ffp-contract=off. It stops the compiler
+      from fusing a * b + c into one FMA instruction on CPUs that have it.
+      Fused results round differently, which would make the golden files
+      depend on the CPU they were made on.
+
+    Build:
+        g++ -std=c++17 -O3 -march=native regression_harness.cpp -o regression_harness
+
+    Author: Jesse Whiting (GhostWire Audio)
+    GitHub: ghostwireaudio
+*/
+
+#define _USE_MATH_DEFINES
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <map>
+#include <cstdint>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <cstdio>
+
+namespace fs = std::filesystem;
+
+// Force the compiler to pack the struct exactly as written
+// with no padding bytes added for alignment, which ensures
+// sizeof(WavHeader) == 44 bytes
+#pragma pack(push, 1)
+struct WavHeader {
+    // RIFF Chunk Descriptor
+    char     riff[4];        // "RIFF"
+    uint32_t chunkSize;      // 36 + Subchunk2Size
+    char     wave[4];        // "WAVE"
+
+    // fmt subchunk
+    char     fmt[4];         // "fmt "
+    uint32_t subchunk1Size;  // 16 for PCM
+    uint16_t audioFormat;    // 1 for PCM
+    uint16_t numChannels;    // 1 for mono
+    uint32_t sampleRate;     // e.g., 44100
+    uint32_t byteRate;       // sampleRate * numChannels * bitsPerSample/8
+    uint16_t blockAlign;     // numChannels * bitsPerSample/8
+    uint16_t bitsPerSample;  // 16
+
+    // data subchunk
+    char     data[4];        // "data"
+    uint32_t subchunk2Size;  // NumSamples * numChannels * bitsPerSample/8
+};
+#pragma pack(pop)
+
+const uint32_t sampleRate = 44100;
+const double goldenSeconds = 1.5; // Long enough to pass the 1 s bypass switch
+const double timingSeconds = 60.0;
+const int timingRuns = 9;
+const char* goldenDir = "golden";
+const char* baselinePath = "baseline.txt";
+const char* workDir = "harness_work";   // Built programs and their files
+
+// ---------------------------------------------------------------------------
+// The programs under test. Each one is built from its own source file and
+// run unchanged: it reads its usual input file name from the folder it runs
+// in and writes its usual output file name there.
+// ---------------------------------------------------------------------------
+struct Program {
+    std::string name;
+    std::string source;     // Relative to the repository root
+    std::string inputName;  // Empty = takes no input (Day 1)
+    std::string outputName;
+};
+
+const std::vector<Program> programs = {
+    { "hello_sine", "1. HelloSine/hello_sine.cpp", "", "hello_sine.wav" },
+    { "gain", "2. WAVPlayerWGain/gain_processor.cpp", "hello_sine.wav", "gain_output.wav" },
+    { "bypass_fade", "3. BypassSwitch/bypass_gain_processor.cpp", "hello_sine.wav", "output_bypass.wav" },
+    { "intentional_click", "3. BypassSwitch/intentional_click.cpp", "hello_sine.wav", "output_clicky.wav" },
+    { "delay_array", "4. SimpleDelay(ArrayIndexing)/simple_delay_array.cpp", "input.wav", "output_delay.wav" },
+    { "delay_circular", "5. CircularBuffers/circular_buffers.cpp", "input.wav", "output_delay.wav" },
+};
+
+// The same flags for every program, so the goldens don't depend on the CPU
+const char* buildFlags = "-std=c++17 -O3 -march=native -ffp-contract=off";
+
+std::string quoted(const fs::path& path) {
+    return "\"" + path.string() + "\"";
+}
+
+fs::path programDir(const Program& p) {
+    return fs::path(workDir) / p.name;
+}
+
+// Compiles one program into its own folder under the work directory
+bool buildProgram(const Program& p, const fs::path& root, const std::string& compiler) {
+    std::error_code ec;
+    fs::create_directories(programDir(p), ec);
+    const std::string command = compiler + " " + buildFlags + " " + quoted(root / p.source) + " -o " + quoted(programDir(p) / p.name);
+    return std::system(command.c_str()) == 0;
+}
+
+// ---------------------------------------------------------------------------
+// Deterministic test signal: a sine, a quiet noise floor, and a loud burst
+// near the end so the gain-of-2 programs have to clamp
+// ---------------------------------------------------------------------------
+std::vector<int16_t> makeInput(size_t numSamples) {
+    std::vector<int16_t> x(numSamples);
+    uint32_t rng = 0x2545F491u;
+    for (size_t n = 0; n < numSamples; ++n) {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        const double noise = (static_cast<double>(rng & 0xFFFF) / 65535.0 - 0.5) * 400.0;
+        const double t = static_cast<double>(n) / sampleRate;
+        const double level = (t > 1.2 && t < 1.3) ? 30000.0 : 12000.0;
+        x[n] = static_cast<int16_t>(std::clamp(level * std::sin(2.0 * M_PI * 330.0 * t) + noise, -32768.0, 32767.0));
+    }
+    return x;
+}
+
+bool writeWav(const fs::path& path, const std::vector<int16_t>& samples) {
+    WavHeader h{};
+    std::copy_n("RIFF", 4, h.riff);
+    std::copy_n("WAVE", 4, h.wave);
+    std::copy_n("fmt ", 4, h.fmt);
+    std::copy_n("data", 4, h.data);
+    h.subchunk1Size = 16;
+    h.audioFormat = 1;
+    h.numChannels = 1;
+    h.sampleRate = sampleRate;
+    h.bitsPerSample = 16;
+    h.blockAlign = 2;
+    h.byteRate = sampleRate * 2;
+    h.subchunk2Size = static_cast<uint32_t>(samples.size() * sizeof(int16_t));
+    h.chunkSize = 36 + h.subchunk2Size;
+
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&h), sizeof(WavHeader));
+    out.write(reinterpret_cast<const char*>(samples.data()), static_cast<std::streamsize>(h.subchunk2Size));
+    return static_cast<bool>(out);
+}
+
+bool readWav(const fs::path& path, std::vector<int16_t>& samples) {
+    std::ifstream in(path, std::ios::binary);
+    WavHeader h{};
+    in.read(reinterpret_cast<char*>(&h), sizeof(WavHeader));
+    if (!in || h.bitsPerSample != 16) return false;
+    samples.resize(h.subchunk2Size / sizeof(int16_t));
+    in.read(reinterpret_cast<char*>(samples.data()), static_cast<std::streamsize>(h.subchunk2Size));
+    return static_cast<bool>(in);
+}
+
+// Runs a built program on `in` (written as its input file) and reads back
+// what it wrote. `seconds` is the wall time of the run.
+bool runProgram(const Program& p, const std::vector<int16_t>& in, std::vector<int16_t>& out, double& seconds) {
+    const fs::path dir = programDir(p);
+    if (!p.inputName.empty() && !writeWav(dir / p.inputName, in)) return false;
+    std::error_code ec;
+    fs::remove(dir / p.outputName, ec);
+    const std::string command = "cd " + quoted(dir) + " && ./" + p.name + " > /dev/null";
+    const auto t0 = std::chrono::steady_clock::now();
+    const int status = std::system(command.c_str());
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return status == 0 && readWav(dir / p.outputName, out);
+}
+
+// Best-of-N time for one program, in nanoseconds per output sample. This is
+// the whole program (start-up and file I/O included), as a user runs it.
+double timeProgram(const Program& p, const std::vector<int16_t>& in) {
+    std::vector<int16_t> out;
+    double best = 1e30;
+    for (int run = 0; run < timingRuns; ++run) {
+        double seconds = 0.0;
+        if (!runProgram(p, in, out, seconds) || out.empty()) return -1.0;
+        best = std::min(best, seconds);
+    }
+    return best * 1e9 / static_cast<double>(out.size());
+}
+
+std::map<std::string, double> loadBaseline() {
+    std::map<std::string, double> baseline;
+    std::ifstream in(baselinePath);
+    std::string name;
+    double ns;
+    while (in >> name >> ns) baseline[name] = ns;
+    return baseline;
+}
+
+int main(int argc, char* argv[]) {
+    bool update = false;
+    int tolerance = 0;
+    double thresholdPercent = 20.0;
+    fs::path root = "..";
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--update") update = true;
+        else if (arg == "--tolerance" && i + 1 < argc) tolerance = std::atoi(argv[++i]);
+        else if (arg == "--threshold" && i + 1 < argc) thresholdPercent = std::atof(argv[++i]);
+        else if (arg == "--root" && i + 1 < argc) root = argv[++i];
+        else {
+            std::cerr << "Usage: regression_harness [--update] [--tolerance LSB] [--threshold PERCENT] [--root DIR]\n";
+            return 1;
+        }
+    }
+    const char* cxx = std::getenv("CXX");
+    const std::string compiler = (cxx && *cxx) ? cxx : "g++";
+
+    // Build every program from its current source first
+    std::printf("Building %zu programs with %s %s\n", programs.size(), compiler.c_str(), buildFlags);
+    std::vector<bool> built;
+    for (const Program& p : programs) {
+        built.push_back(buildProgram(p, root, compiler));
+        if (!built.back()) std::fprintf(stderr, "Error: could not build %s\n", (root / p.source).string().c_str());
+    }
+    std::printf("\n");
+
+    const std::vector<int16_t> goldenInput = makeInput(static_cast<size_t>(goldenSeconds * sampleRate));
+    const std::vector<int16_t> timingInput = makeInput(static_cast<size_t>(timingSeconds * sampleRate));
+    std::map<std::string, double> baseline = loadBaseline();
+    const bool newBaseline = update || baseline.empty();
+
+    std::error_code ec;
+    fs::create_directories(goldenDir, ec);
+
+    int failures = 0;
+    std::printf("%-18s %-22s %10s %10s %8s   %s\n", "program", "golden", "ns/sample", "baseline", "change", "speed");
+    for (size_t i = 0; i < programs.size(); ++i) {
+        const Program& p = programs[i];
+        const std::string& name = p.name;
+        if (!built[i]) {
+            std::printf("%-18s %-22s\n", name.c_str(), "BUILD FAILED");
+            ++failures;
+            continue;
+        }
+
+        // 1) Output check
+        std::vector<int16_t> out;
+        double seconds = 0.0;
+        const bool ran = runProgram(p, goldenInput, out, seconds);
+        const fs::path goldenPath = fs::path(goldenDir) / (name + ".wav");
+
+        std::string goldenResult;
+        std::vector<int16_t> golden;
+        if (!ran) {
+            goldenResult = "RUN FAILED";
+            ++failures;
+        } else if (update) {
+            goldenResult = writeWav(goldenPath, out) ? "updated" : "WRITE FAILED";
+        } else if (!readWav(goldenPath, golden)) {
+            goldenResult = "MISSING";
+            ++failures;
+        } else if (golden.size() != out.size()) {
+            goldenResult = "FAIL (length)";
+            ++failures;
+        } else {
+            int maxDiff = 0;
+            for (size_t n = 0; n < out.size(); ++n) maxDiff = std::max(maxDiff, std::abs(out[n] - golden[n]));
+            if (maxDiff <= tolerance) {
+                goldenResult = (maxDiff == 0) ? "PASS (exact)" : "PASS (" + std::to_string(maxDiff) + " LSB)";
+            } else {
+                goldenResult = "FAIL (" + std::to_string(maxDiff) + " LSB)";
+                ++failures;
+            }
+        }
+        if (!ran) {
+            std::printf("%-18s %-22s\n", name.c_str(), goldenResult.c_str());
+            continue;
+        }
+
+        // 2) Speed check
+        const double ns = timeProgram(p, timingInput);
+        if (ns < 0.0) {
+            std::printf("%-18s %-22s %10s\n", name.c_str(), goldenResult.c_str(), "RUN FAILED");
+            ++failures;
+            continue;
+        }
+        std::string speedResult = "recorded";
+        double change = 0.0;
+        const auto it = baseline.find(name);
+        if (!newBaseline && it != baseline.end()) {
+            change = 100.0 * (ns - it->second) / it->second;
+            if (change > thresholdPercent) {
+                speedResult = "SLOWER";
+                ++failures;
+            } else {
+                speedResult = "ok";
+            }
+        }
+        const double shownBaseline = (!newBaseline && it != baseline.end()) ? it->second : ns;
+        if (newBaseline || it == baseline.end()) baseline[name] = ns;
+
+        std::printf("%-18s %-22s %10.3f %10.3f %+7.1f%%   %s\n", name.c_str(), goldenResult.c_str(), ns, shownBaseline, change,
+            speedResult.c_str());
+    }
+
+    // Save the baseline when it was (re)created or gained new programs
+    if (newBaseline || baseline.size() != loadBaseline().size()) {
+        std::ofstream out(baselinePath);
+        for (const auto& [name, ns] : baseline) out << name << ' ' << ns << '\n';
+    }
+
+    if (failures > 0) {
+        std::printf("\n%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("\nAll checks passed (tolerance %d LSB, slowdown threshold %.0f%%)\n", tolerance, thresholdPercent);
+    return 0;
+}
@@ -0,0 +1,1554 @@
+/*
+    MicroDSP - Day 23: FLAC Encoder / Decoder
+
+    What this program does:
+    - Reads and writes FLAC files natively (no libFLAC needed)
+    - Encoder: fixed and LPC prediction, Rice-coded residuals and stereo
+      decorrelation, with frames encoded in parallel on all cores
+    - Decoder: every FLAC subframe type and stereo mode, CRC-checked, with
+      frames decoded in parallel on all cores
+    - WAV and FLAC sit behind the same BlockReader / BlockWriter interface,
+      so a processing loop doesn't care which format it is talking to
+    - FLAC is lossless and usually about half the size of the WAV, so every
+      batch job that reads or writes it moves about half the bytes
+
+    Usage:
+        flac in.wav out.flac            encode
+        flac in.flac out.wav            decode
+        flac in.flac out.flac --gain 0.5
+            (any combination works; the format comes from the extension,
+             and --gain shows a processing job running on the blocks)
+    With no arguments it encodes input.wav to output.flac, decodes that to
+    output_decoded.wav, and checks that every sample survived. Then it cuts
+    output.flac in half and scribbles over its middle, and checks that both
+    damaged copies are rejected with an error.
+
+    How FLAC squeezes audio (without losing anything):
+    - The audio is cut into frames of 4096 samples. Every frame stands on
+      its own: its own header, its own predictor, its own CRC.
+    - Prediction: audio is smooth, so the next sample can be guessed from
+      the last few. "Fixed" predictors are simple polynomials, e.g. order 2
+      guesses x[n-1] + (x[n-1] - x[n-2]). "LPC" predictors are a weighted
+      sum of up to 12 previous samples, with weights fitted to each frame
+      (autocorrelation + Levinson-Durbin, the same math as speech codecs).
+    - Residual: only the error of the guess is stored. It is small, so it
+      needs far fewer bits than the sample itself.
+    - Rice coding: a small number k is picked per partition of the
+      residual. Each value is stored as (value >> k) in unary (that many 0s
+      and then a 1) followed by the low k bits. Small values = short codes.
+    - Stereo: left and right are usually similar, so FLAC can store
+      mid (L+R)/2 and side L-R instead, whichever pair is cheaper.
+    - Decoding just runs the same steps backwards, giving back the exact
+      original integers.
+
+    Why frames can be done in parallel:
+    - Frames are independent, so encoding is easy: each thread takes the
+      next block of audio, and the results are written out in order.
+    - Decoding is harder because frame lengths vary and aren't stored
+      anywhere. Each frame starts with a sync code (0xFFF8) followed by a
+      CRC-8-protected header carrying the frame number. We scan for sync
+      codes whose header is valid and whose frame number is the next one
+      expected, then decode those frames on all threads. Each frame's
+      CRC-16 has to match and the frame has to end exactly where the next
+      one starts. If a sync code was fake (audio data that happened to look
+      like a header), that check fails and we fall back to decoding in
+      order from there.
+
+    Limits:
+    - The encoder writes zeros for the MD5 checksum of the audio (which the
+      format allows and means "not computed"). Each frame still has a CRC.
+    - WAV files here are 8, 16 or 24-bit PCM. The FLAC side handles any
+      bit depth from 4 to 32 bits.
+
+    Build:
+        g++ -std=c++17 -O3 -march=native -pthread flac.cpp -o flac
+
+    Author: Jesse Whiting (GhostWire Audio)
+    GitHub: ghostwireaudio
+*/
+
+#define _USE_MATH_DEFINES
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <cctype>
+#include <cstdlib>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iterator>
+
+// Force the compiler to pack the struct exactly as written
+// with no padding bytes added for alignment, which ensures
+// sizeof(WavHeader) == 44 bytes
+#pragma pack(push, 1)
+struct WavHeader {
+    // RIFF Chunk Descriptor
+    char     riff[4];        // "RIFF"
+    uint32_t chunkSize;      // 36 + Subchunk2Size
+    char     wave[4];        // "WAVE"
+
+    // fmt subchunk
+    char     fmt[4];         // "fmt "
+    uint32_t subchunk1Size;  // 16 for PCM
+    uint16_t audioFormat;    // 1 for PCM
+    uint16_t numChannels;    // 1 for mono
+    uint32_t sampleRate;     // e.g., 44100
+    uint32_t byteRate;       // sampleRate * numChannels * bitsPerSample/8
+    uint16_t blockAlign;     // numChannels * bitsPerSample/8
+    uint16_t bitsPerSample;  // 16
+
+    // data subchunk
+    char     data[4];        // "data"
+    uint32_t subchunk2Size;  // NumSamples * numChannels * bitsPerSample/8
+};
+#pragma pack(pop)
+
+const uint32_t flacBlockSize = 4096;      // Samples per channel in each frame
+const uint32_t maxLpcOrder = 12;          // Highest LPC order the encoder tries
+const uint32_t maxPartitionOrder = 8;     // Up to 256 Rice partitions per subframe
+const size_t framesPerThread = 32;        // Encoder batch: frames per thread
+const size_t decodeBatchBytes = 4 << 20;  // Decoder batch: compressed bytes
+const size_t blockFrames = 4096;          // Frames per read/write in the job loop
+
+// Format shared by every reader and writer. Samples travel as interleaved
+// int32 so 8, 16, 24 and 32-bit audio all fit.
+struct AudioFormat {
+    uint32_t sampleRate = 0;
+    uint32_t channels = 0;
+    uint32_t bitsPerSample = 0;
+    uint64_t totalFrames = 0; // 0 = unknown
+};
+
+// ---------------------------------------------------------------------------
+// CRCs: FLAC protects each frame header with a CRC-8 and each whole frame
+// with a CRC-16
+// ---------------------------------------------------------------------------
+uint8_t crc8(const uint8_t* data, size_t size) {
+    static const std::vector<uint8_t> table = [] {
+        std::vector<uint8_t> t(256);
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int b = 0; b < 8; ++b) c = (c & 0x80) ? ((c << 1) ^ 0x07) : (c << 1);
+            t[i] = static_cast<uint8_t>(c);
+        }
+        return t;
+    }();
+    uint8_t crc = 0;
+    for (size_t i = 0; i < size; ++i) crc = table[crc ^ data[i]];
+    return crc;
+}
+
+uint16_t crc16(const uint8_t* data, size_t size) {
+    static const std::vector<uint16_t> table = [] {
+        std::vector<uint16_t> t(256);
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i << 8;
+            for (int b = 0; b < 8; ++b) c = (c & 0x8000) ? ((c << 1) ^ 0x8005) : (c << 1);
+            t[i] = static_cast<uint16_t>(c);
+        }
+        return t;
+    }();
+    uint16_t crc = 0;
+    for (size_t i = 0; i < size; ++i) crc = static_cast<uint16_t>((crc << 8) ^ table[(crc >> 8) ^ data[i]]);
+    return crc;
+}
+
+// ---------------------------------------------------------------------------
+// Bit-level reading and writing (FLAC packs fields most significant bit first)
+// ---------------------------------------------------------------------------
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+    uint32_t readBits(uint32_t n) { // n <= 32
+        if (n == 0) return 0;
+        const size_t byte = bitPos >> 3;
+        const uint32_t offset = static_cast<uint32_t>(bitPos & 7);
+        bitPos += n;
+        if (byte + 8 <= size) {
+            // Fast path: load 8 bytes big-endian and cut the field out
+            const uint64_t word = load64(data + byte) << offset;
+            return static_cast<uint32_t>(word >> (64 - n));
+        }
+        // Near the end of the data: one byte at a time
+        uint64_t value = 0;
+        for (size_t i = 0; i < 8; ++i) value = (value << 8) | (byte + i < size ? data[byte + i] : 0);
+        return static_cast<uint32_t>((value << offset) >> (64 - n));
+    }
+
+    int32_t readSigned(uint32_t n) { // Two's complement field of n bits
+        if (n == 0) return 0;
+        const uint32_t value = readBits(n);
+        if (n == 32) return static_cast<int32_t>(value);
+        return static_cast<int32_t>(value << (32 - n)) >> (32 - n);
+    }
+
+    uint32_t readUnary() { // Counts 0 bits up to the next 1 bit
+        uint32_t count = 0;
+        for (;;) {
+            const size_t byte = bitPos >> 3;
+            if (byte >= size) {
+                bitPos = size * 8 + 1; // Ran off the end: mark as overflowed
+                return count;
+            }
+            const uint32_t offset = static_cast<uint32_t>(bitPos & 7);
+            const uint64_t word = (byte + 8 <= size ? load64(data + byte) : loadTail(byte)) << offset;
+            if (word != 0) {
+                const uint32_t zeros = countLeadingZeros(word);
+                bitPos += zeros + 1;
+                return count + zeros;
+            }
+            const uint32_t skipped = (byte + 8 <= size ? 64 : static_cast<uint32_t>(size - byte) * 8) - offset;
+            count += skipped;
+            bitPos += skipped;
+        }
+    }
+
+    int32_t readRice(uint32_t k) {
+        const uint32_t high = readUnary();
+        const uint32_t folded = (high << k) | readBits(k);
+        // Undo the zigzag folding: 0, 1, 2, 3, 4 ... -> 0, -1, 1, -2, 2 ...
+        return static_cast<int32_t>(folded >> 1) ^ -static_cast<int32_t>(folded & 1);
+    }
+
+    void alignToByte() { bitPos = (bitPos + 7) & ~static_cast<size_t>(7); }
+    void skipBytes(size_t n) { bitPos += n * 8; }
+    size_t bytePosition() const { return bitPos >> 3; }
+    bool overflowed() const { return bitPos > size * 8; }
+
+private:
+    static uint64_t load64(const uint8_t* p) {
+        uint64_t value = 0;
+        for (int i = 0; i < 8; ++i) value = (value << 8) | p[i];
+        return value;
+    }
+
+    uint64_t loadTail(size_t byte) const {
+        uint64_t value = 0;
+        for (size_t i = 0; i < 8; ++i) value = (value << 8) | (byte + i < size ? data[byte + i] : 0);
+        return value;
+    }
+
+    static uint32_t countLeadingZeros(uint64_t word) { // word != 0
+#if defined(__GNUC__)
+        return static_cast<uint32_t>(__builtin_clzll(word));
+#else
+        uint32_t n = 0;
+        while (!(word & (1ull << 63))) { word <<= 1; ++n; }
+        return n;
+#endif
+    }
+
+    const uint8_t* data;
+    size_t size;
+    size_t bitPos = 0;
+};
+
+class BitWriter {
+public:
+    void writeBits(uint32_t value, uint32_t n) { // n <= 32
+        if (n == 0) return;
+        const uint64_t mask = (n == 32) ? 0xFFFFFFFFull : ((1ull << n) - 1);
+        accumulator = (accumulator << n) | (value & mask);
+        accumulatorBits += n;
+        while (accumulatorBits >= 8) {
+            accumulatorBits -= 8;
+            bytes.push_back(static_cast<uint8_t>(accumulator >> accumulatorBits));
+        }
+        accumulator &= (1ull << accumulatorBits) - 1;
+    }
+
+    void writeSigned(int32_t value, uint32_t n) { writeBits(static_cast<uint32_t>(value), n); }
+
+    void writeUnary(uint32_t zeros) { // zeros x 0 bit, then a 1 bit
+        while (zeros >= 31) {
+            writeBits(0, 31);
+            zeros -= 31;
+        }
+        writeBits(1, zeros + 1);
+    }
+
+    void writeRice(int32_t value, uint32_t k) {
+        // Zigzag fold so small negative numbers get small codes too
+        const uint32_t folded = (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+        writeUnary(folded >> k);
+        writeBits(folded, k);
+    }
+
+    void alignToByte() {
+        if (accumulatorBits) writeBits(0, 8 - accumulatorBits);
+    }
+
+    std::vector<uint8_t> bytes;
+
+private:
+    uint64_t accumulator = 0;
+    uint32_t accumulatorBits = 0;
+};
+
+// ---------------------------------------------------------------------------
+// FLAC stream and frame headers
+// ---------------------------------------------------------------------------
+struct StreamInfo {
+    uint32_t minBlockSize = 0;
+    uint32_t maxBlockSize = 0;
+    uint32_t minFrameSize = 0;   // Bytes, 0 = unknown
+    uint32_t maxFrameSize = 0;
+    uint32_t sampleRate = 0;
+    uint32_t channels = 0;
+    uint32_t bitsPerSample = 0;
+    uint64_t totalSamples = 0;   // Per channel, 0 = unknown
+};
+
+// The 34-byte STREAMINFO block, written at the start of every FLAC file
+std::vector<uint8_t> packStreamInfo(const StreamInfo& info) {
+    BitWriter bw;
+    bw.writeBits(info.minBlockSize, 16);
+    bw.writeBits(info.maxBlockSize, 16);
+    bw.writeBits(info.minFrameSize, 24);
+    bw.writeBits(info.maxFrameSize, 24);
+    bw.writeBits(info.sampleRate, 20);
+    bw.writeBits(info.channels - 1, 3);
+    bw.writeBits(info.bitsPerSample - 1, 5);
+    bw.writeBits(static_cast<uint32_t>(info.totalSamples >> 32), 4);
+    bw.writeBits(static_cast<uint32_t>(info.totalSamples), 32);
+    for (int i = 0; i < 4; ++i) bw.writeBits(0, 32); // MD5: all zeros = not computed
+    return bw.bytes;
+}
+
+StreamInfo unpackStreamInfo(const uint8_t* data) {
+    BitReader br(data, 34);
+    StreamInfo info;
+    info.minBlockSize = br.readBits(16);
+    info.maxBlockSize = br.readBits(16);
+    info.minFrameSize = br.readBits(24);
+    info.maxFrameSize = br.readBits(24);
+    info.sampleRate = br.readBits(20);
+    info.channels = br.readBits(3) + 1;
+    info.bitsPerSample = br.readBits(5) + 1;
+    info.totalSamples = static_cast<uint64_t>(br.readBits(4)) << 32;
+    info.totalSamples |= br.readBits(32);
+    return info;
+}
+
+struct FrameHeader {
+    bool variableBlockSize = false;
+    uint32_t blockSize = 0;
+    uint32_t sampleRate = 0;
+    uint32_t channelAssignment = 0; // 0-7 independent, 8 left/side, 9 side/right, 10 mid/side
+    uint32_t channels = 0;
+    uint32_t bitsPerSample = 0;
+    uint64_t number = 0;            // Frame number (fixed block size) or first sample number
+    size_t headerBytes = 0;
+};
+
+const uint32_t sampleRateTable[12] = {0, 88200, 176400, 192000, 8000, 16000, 22050, 24000, 32000, 44100, 48000, 96000};
+const uint32_t sampleSizeTable[8] = {0, 8, 12, 0, 16, 20, 24, 32};
+
+// Parses the frame header at data. Returns false unless it is a complete,
+// CRC-valid header, so it doubles as the sync code check for the decoder.
+bool parseFrameHeader(const uint8_t* data, size_t size, const StreamInfo& info, FrameHeader& h) {
+    if (size < 6 || data[0] != 0xFF || (data[1] & 0xFE) != 0xF8) return false;
+    h.variableBlockSize = (data[1] & 1) != 0;
+    const uint32_t blockSizeCode = data[2] >> 4;
+    const uint32_t sampleRateCode = data[2] & 15;
+    h.channelAssignment = data[3] >> 4;
+    const uint32_t sampleSizeCode = (data[3] >> 1) & 7;
+    if (blockSizeCode == 0 || sampleRateCode == 15 || h.channelAssignment > 10 || sampleSizeCode == 3 || (data[3] & 1)) return false;
+
+    // Frame/sample number, stored with the same variable-length scheme as UTF-8
+    size_t pos = 4;
+    const uint8_t first = data[pos++];
+    uint32_t extraBytes = 0;
+    while (extraBytes < 7 && (first & (0x80 >> extraBytes))) ++extraBytes;
+    if (extraBytes == 1 || extraBytes > (h.variableBlockSize ? 7u : 6u)) return false;
+    if (extraBytes) --extraBytes; // The count of leading 1s includes the first byte
+    uint64_t number = first & (0x7F >> (extraBytes ? extraBytes + 1 : 0));
+    for (uint32_t i = 0; i < extraBytes; ++i) {
+        if (pos >= size || (data[pos] & 0xC0) != 0x80) return false;
+        number = (number << 6) | (data[pos++] & 0x3F);
+    }
+    h.number = number;
+
+    // Block size and sample rate, either from a table or stored after the number
+    if (blockSizeCode == 1) h.blockSize = 192;
+    else if (blockSizeCode <= 5) h.blockSize = 576u << (blockSizeCode - 2);
+    else if (blockSizeCode == 6) {
+        if (pos + 1 > size) return false;
+        h.blockSize = data[pos++] + 1u;
+    } else if (blockSizeCode == 7) {
+        if (pos + 2 > size) return false;
+        h.blockSize = ((data[pos] << 8) | data[pos + 1]) + 1u;
+        pos += 2;
+    } else h.blockSize = 256u << (blockSizeCode - 8);
+
+    if (sampleRateCode == 0) h.sampleRate = info.sampleRate;
+    else if (sampleRateCode < 12) h.sampleRate = sampleRateTable[sampleRateCode];
+    else {
+        const size_t n = (sampleRateCode == 12) ? 1 : 2;
+        if (pos + n > size) return false;
+        const uint32_t value = (n == 1) ? data[pos] : ((data[pos] << 8) | data[pos + 1]);
+        pos += n;
+        h.sampleRate = (sampleRateCode == 12) ? value * 1000 : (sampleRateCode == 13) ? value : value * 10;
+    }
+
+    h.channels = (h.channelAssignment < 8) ? h.channelAssignment + 1 : 2;
+    h.bitsPerSample = (sampleSizeCode == 0) ? info.bitsPerSample : sampleSizeTable[sampleSizeCode];
+
+    if (pos >= size || crc8(data, pos) != data[pos]) return false;
+    h.headerBytes = pos + 1;
+    return true;
+}
+
+// The number the *next* frame header must carry
+uint64_t nextFrameNumber(const FrameHeader& h) {
+    return h.variableBlockSize ? h.number + h.blockSize : h.number + 1;
+}
+
+// ---------------------------------------------------------------------------
+// Decoder
+// ---------------------------------------------------------------------------
+struct DecodedFrame {
+    uint64_t firstSample = 0;
+    uint32_t blockSize = 0;
+    std::vector<int32_t> samples; // Interleaved
+    size_t bytes = 0;             // Length of the frame in the stream
+};
+
+// Fills residual[0 .. blockSize - order)
+bool decodeResidual(BitReader& br, uint32_t blockSize, uint32_t order, int32_t* residual) {
+    const uint32_t method = br.readBits(2);
+    if (method > 1) return false;
+    const uint32_t paramBits = (method == 0) ? 4 : 5;
+    const uint32_t escape = (1u << paramBits) - 1;
+    const uint32_t partitionOrder = br.readBits(4);
+    const uint32_t partitionSize = blockSize >> partitionOrder;
+    if ((partitionSize << partitionOrder) != blockSize || partitionSize < order) return false;
+
+    size_t i = 0;
+    for (uint32_t p = 0; p < (1u << partitionOrder); ++p) {
+        const uint32_t n = partitionSize - (p == 0 ? order : 0);
+        const uint32_t param = br.readBits(paramBits);
+        if (param == escape) {
+            // Escaped partition: plain signed numbers of a given width
+            const uint32_t bits = br.readBits(5);
+            for (uint32_t j = 0; j < n; ++j) residual[i++] = br.readSigned(bits);
+        } else {
+            for (uint32_t j = 0; j < n; ++j) residual[i++] = br.readRice(param);
+        }
+        if (br.overflowed()) return false;
+    }
+    return true;
+}
+
+// Decodes one channel of a frame into out[0 .. blockSize)
+bool decodeSubframe(BitReader& br, uint32_t blockSize, uint32_t bps, int32_t* out) {
+    if (bps > 32 || br.readBits(1) != 0) return false;
+    const uint32_t type = br.readBits(6);
+    uint32_t wasted = 0;
+    if (br.readBits(1)) wasted = br.readUnary() + 1; // Low bits that are always 0
+    if (wasted >= bps) return false;
+    const uint32_t sampleBits = bps - wasted;
+
+    if (type == 0) { // CONSTANT
+        std::fill(out, out + blockSize, br.readSigned(sampleBits));
+    } else if (type == 1) { // VERBATIM
+        for (uint32_t i = 0; i < blockSize; ++i) out[i] = br.readSigned(sampleBits);
+    } else if (type >= 8 && type <= 12) { // FIXED, order 0-4
+        const uint32_t order = type - 8;
+        if (order > blockSize) return false;
+        for (uint32_t i = 0; i < order; ++i) out[i] = br.readSigned(sampleBits);
+        if (!decodeResidual(br, blockSize, order, out + order)) return false;
+        // The residual is stored in place, so each sample becomes residual + prediction
+        for (uint32_t i = order; i < blockSize; ++i) {
+            int64_t prediction = 0;
+            switch (order) {
+            case 1: prediction = out[i - 1]; break;
+            case 2: prediction = 2ll * out[i - 1] - out[i - 2]; break;
+            case 3: prediction = 3ll * out[i - 1] - 3ll * out[i - 2] + out[i - 3]; break;
+            case 4: prediction = 4ll * out[i - 1] - 6ll * out[i - 2] + 4ll * out[i - 3] - out[i - 4]; break;
+            }
+            out[i] = static_cast<int32_t>(out[i] + prediction);
+        }
+    } else if (type >= 32) { // LPC, order 1-32
+        const uint32_t order = (type & 31) + 1;
+        if (order > blockSize) return false;
+        for (uint32_t i = 0; i < order; ++i) out[i] = br.readSigned(sampleBits);
+        const uint32_t precision = br.readBits(4) + 1;
+        const int32_t shift = br.readSigned(5);
+        if (precision == 16 || shift < 0) return false;
+        int32_t coefs[32];
+        for (uint32_t j = 0; j < order; ++j) coefs[j] = br.readSigned(precision);
+        if (!decodeResidual(br, blockSize, order, out + order)) return false;
+        for (uint32_t i = order; i < blockSize; ++i) {
+            int64_t sum = 0;
+            for (uint32_t j = 0; j < order; ++j) sum += static_cast<int64_t>(coefs[j]) * out[i - 1 - j];
+            out[i] = static_cast<int32_t>(out[i] + (sum >> shift));
+        }
+    } else {
+        return false; // Reserved subframe type
+    }
+
+    if (wasted) {
+        for (uint32_t i = 0; i < blockSize; ++i) out[i] = static_cast<int32_t>(static_cast<uint32_t>(out[i]) << wasted);
+    }
+    return !br.overflowed();
+}
+
+// Decodes the frame starting at data. size bounds how far it may read.
+bool decodeFrame(const uint8_t* data, size_t size, const StreamInfo& info, DecodedFrame& frame) {
+    FrameHeader h;
+    if (!parseFrameHeader(data, size, info, h)) return false;
+    if (h.channels != info.channels || h.bitsPerSample != info.bitsPerSample) return false;
+
+    const uint32_t n = h.blockSize;
+    std::vector<int32_t> planar(static_cast<size_t>(n) * h.channels);
+    BitReader br(data, size);
+    br.skipBytes(h.headerBytes);
+    for (uint32_t ch = 0; ch < h.channels; ++ch) {
+        // The side channel needs one extra bit (L - R can be twice as big)
+        const bool side = (h.channelAssignment == 8 && ch == 1) || (h.channelAssignment == 9 && ch == 0) ||
+                          (h.channelAssignment == 10 && ch == 1);
+        if (!decodeSubframe(br, n, h.bitsPerSample + (side ? 1 : 0), planar.data() + static_cast<size_t>(ch) * n)) return false;
+    }
+
+    // Frame footer: zero padding to a byte boundary, then a CRC-16 of everything before it
+    br.alignToByte();
+    const size_t crcPos = br.bytePosition();
+    if (crcPos + 2 > size) return false;
+    if (crc16(data, crcPos) != ((data[crcPos] << 8) | data[crcPos + 1])) return false;
+    frame.bytes = crcPos + 2;
+
+    // Undo the stereo decorrelation and interleave
+    frame.blockSize = n;
+    frame.firstSample = h.variableBlockSize ? h.number : h.number * info.maxBlockSize;
+    frame.samples.resize(planar.size());
+    const int32_t* a = planar.data();
+    const int32_t* b = planar.data() + n;
+    if (h.channelAssignment < 8) {
+        for (uint32_t ch = 0; ch < h.channels; ++ch)
+            for (uint32_t i = 0; i < n; ++i) frame.samples[static_cast<size_t>(i) * h.channels + ch] = planar[static_cast<size_t>(ch) * n + i];
+    } else {
+        for (uint32_t i = 0; i < n; ++i) {
+            int64_t left, right;
+            if (h.channelAssignment == 8) { // left, side
+                left = a[i];
+                right = static_cast<int64_t>(a[i]) - b[i];
+            } else if (h.channelAssignment == 9) { // side, right
+                right = b[i];
+                left = static_cast<int64_t>(a[i]) + b[i];
+            } else { // mid, side: the lost low bit of mid is the low bit of side
+                const int64_t mid = (static_cast<int64_t>(a[i]) * 2) | (b[i] & 1);
+                left = (mid + b[i]) >> 1;
+                right = (mid - b[i]) >> 1;
+            }
+            frame.samples[2 * static_cast<size_t>(i)] = static_cast<int32_t>(left);
+            frame.samples[2 * static_cast<size_t>(i) + 1] = static_cast<int32_t>(right);
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Encoder
+// ---------------------------------------------------------------------------
+
+// How one subframe's residual gets Rice-coded: the partition count and a
+// Rice parameter per partition
+struct RicePlan {
+    uint32_t partitionOrder = 0;
+    uint32_t method = 0;          // 0: 4-bit parameters, 1: 5-bit parameters
+    std::vector<uint32_t> params;
+    uint64_t bits = 0;            // Estimated size including the parameters
+};
+
+// Best Rice parameter for a partition of n folded values adding up to sum.
+// Cost of parameter k is about n * (k + 1) + sum / 2^k, which dips once.
+uint32_t bestRiceParam(uint64_t sum, uint32_t n, uint64_t& bits) {
+    uint32_t k = 0;
+    bits = static_cast<uint64_t>(n) + sum;
+    while (k < 30) {
+        const uint64_t next = static_cast<uint64_t>(n) * (k + 2) + (sum >> (k + 1));
+        if (next >= bits) break;
+        bits = next;
+        ++k;
+    }
+    return k;
+}
+
+class FrameEncoder {
+public:
+    explicit FrameEncoder(const AudioFormat& format) : format(format) {}
+
+    // Encodes blockSize interleaved frames as FLAC frame number frameNumber
+    void encode(const int32_t* interleaved, uint32_t blockSize, uint64_t frameNumber, std::vector<uint8_t>& out) {
+        const uint32_t channels = format.channels;
+        const uint32_t bps = format.bitsPerSample;
+        planar.resize(static_cast<size_t>(blockSize) * std::max(channels, 4u));
+        for (uint32_t ch = 0; ch < channels; ++ch)
+            for (uint32_t i = 0; i < blockSize; ++i) planar[static_cast<size_t>(ch) * blockSize + i] = interleaved[static_cast<size_t>(i) * channels + ch];
+
+        // Stereo: pick the cheapest of L/R, L/S, S/R and M/S
+        uint32_t assignment = channels - 1;
+        const int32_t* sources[8];
+        for (uint32_t ch = 0; ch < channels; ++ch) sources[ch] = planar.data() + static_cast<size_t>(ch) * blockSize;
+        if (channels == 2 && bps < 32) {
+            int32_t* mid = planar.data() + 2 * static_cast<size_t>(blockSize);
+            int32_t* side = planar.data() + 3 * static_cast<size_t>(blockSize);
+            for (uint32_t i = 0; i < blockSize; ++i) {
+                const int64_t l = sources[0][i], r = sources[1][i];
+                mid[i] = static_cast<int32_t>((l + r) >> 1);
+                side[i] = static_cast<int32_t>(l - r);
+            }
+            const uint64_t costL = roughCost(sources[0], blockSize), costR = roughCost(sources[1], blockSize);
+            const uint64_t costM = roughCost(mid, blockSize), costS = roughCost(side, blockSize);
+            const uint64_t options[4] = {costL + costR, costL + costS, costS + costR, costM + costS};
+            const uint32_t best = static_cast<uint32_t>(std::min_element(options, options + 4) - options);
+            if (best == 1) { assignment = 8; sources[1] = side; }
+            else if (best == 2) { assignment = 9; sources[0] = side; }
+            else if (best == 3) { assignment = 10; sources[0] = mid; sources[1] = side; }
+        }
+
+        BitWriter bw;
+        writeFrameHeader(bw, blockSize, frameNumber, assignment);
+        for (uint32_t ch = 0; ch < channels; ++ch) {
+            const bool side = (assignment == 8 && ch == 1) || (assignment == 9 && ch == 0) || (assignment == 10 && ch == 1);
+            encodeSubframe(bw, sources[ch], blockSize, bps + (side ? 1 : 0));
+        }
+        bw.alignToByte();
+        const uint16_t crc = crc16(bw.bytes.data(), bw.bytes.size());
+        bw.writeBits(crc, 16);
+        out.swap(bw.bytes);
+    }
+
+private:
+    // Quick size estimate for the stereo decision: sum of the order-2 residual
+    static uint64_t roughCost(const int32_t* x, uint32_t n) {
+        uint64_t sum = 0;
+        for (uint32_t i = 2; i < n; ++i) {
+            const int64_t r = static_cast<int64_t>(x[i]) - 2ll * x[i - 1] + x[i - 2];
+            sum += static_cast<uint64_t>(r < 0 ? -r : r);
+        }
+        return sum;
+    }
+
+    void writeFrameHeader(BitWriter& bw, uint32_t blockSize, uint64_t frameNumber, uint32_t assignment) const {
+        bw.writeBits(0x3FFE, 14); // Sync code
+        bw.writeBits(0, 1);       // Reserved
+        bw.writeBits(0, 1);       // Fixed block size: the header carries a frame number
+
+        uint32_t blockSizeCode = (blockSize <= 256) ? 6 : 7; // Stored after the number
+        if (blockSize == 192) blockSizeCode = 1;
+        for (uint32_t c = 2; c <= 5; ++c) if (blockSize == (576u << (c - 2))) blockSizeCode = c;
+        for (uint32_t c = 8; c <= 15; ++c) if (blockSize == (256u << (c - 8))) blockSizeCode = c;
+
+        uint32_t sampleRateCode = 0; // 0 = see STREAMINFO
+        for (uint32_t c = 1; c < 12; ++c) if (format.sampleRate == sampleRateTable[c]) sampleRateCode = c;
+        if (sampleRateCode == 0) {
+            if (format.sampleRate % 1000 == 0 && format.sampleRate / 1000 < 256) sampleRateCode = 12;
+            else if (format.sampleRate < 65536) sampleRateCode = 13;
+        }
+
+        uint32_t sampleSizeCode = 0;
+        for (uint32_t c = 1; c < 8; ++c) if (format.bitsPerSample == sampleSizeTable[c]) sampleSizeCode = c;
+
+        bw.writeBits(blockSizeCode, 4);
+        bw.writeBits(sampleRateCode, 4);
+        bw.writeBits(assignment, 4);
+        bw.writeBits(sampleSizeCode, 3);
+        bw.writeBits(0, 1);
+
+        // Frame number, UTF-8 style: 1 byte up to 7 bits, then 11, 16, 21, 26, 31 bits
+        if (frameNumber < 0x80) {
+            bw.writeBits(static_cast<uint32_t>(frameNumber), 8);
+        } else {
+            uint32_t extra = 1;
+            while (extra < 5 && frameNumber >= (1ull << (5 * extra + 6))) ++extra;
+            const uint32_t lead = (0xFF00u >> (extra + 1)) & 0xFF;
+            bw.writeBits(lead | static_cast<uint32_t>(frameNumber >> (6 * extra)), 8);
+            for (uint32_t i = extra; i-- > 0;) bw.writeBits(0x80 | static_cast<uint32_t>((frameNumber >> (6 * i)) & 0x3F), 8);
+        }
+
+        if (blockSizeCode == 6) bw.writeBits(blockSize - 1, 8);
+        if (blockSizeCode == 7) bw.writeBits(blockSize - 1, 16);
+        if (sampleRateCode == 12) bw.writeBits(format.sampleRate / 1000, 8);
+        if (sampleRateCode == 13) bw.writeBits(format.sampleRate, 16);
+
+        bw.writeBits(crc8(bw.bytes.data(), bw.bytes.size()), 8);
+    }
+
+    // Plans the partition order and Rice parameters for residual[0 .. n - order)
+    RicePlan planRice(const int32_t* residual, uint32_t n, uint32_t order) {
+        uint32_t topOrder = 0;
+        while (topOrder < maxPartitionOrder && (n % (2u << topOrder)) == 0 && (n >> (topOrder + 1)) > order) ++topOrder;
+
+        // Folded sums for the finest partitions; coarser ones are pairwise sums
+        sums.assign(1u << topOrder, 0);
+        const uint32_t partitionSize = n >> topOrder;
+        for (uint32_t i = order; i < n; ++i) {
+            const int32_t r = residual[i - order];
+            sums[i / partitionSize] += (static_cast<uint32_t>(r) << 1) ^ static_cast<uint32_t>(r >> 31);
+        }
+
+        RicePlan best;
+        best.bits = UINT64_MAX;
+        for (uint32_t po = topOrder + 1; po-- > 0;) {
+            const uint32_t partitions = 1u << po;
+            RicePlan plan;
+            plan.partitionOrder = po;
+            plan.params.resize(partitions);
+            uint64_t bits = 6; // Method + partition order
+            uint32_t highest = 0;
+            for (uint32_t p = 0; p < partitions; ++p) {
+                const uint32_t count = (n >> po) - (p == 0 ? order : 0);
+                uint64_t partitionBits = 0;
+                plan.params[p] = bestRiceParam(sums[p], count, partitionBits);
+                bits += partitionBits;
+                highest = std::max(highest, plan.params[p]);
+            }
+            plan.method = (highest > 14) ? 1 : 0; // Parameter 15 means "escape" in 4-bit mode
+            plan.bits = bits + static_cast<uint64_t>(partitions) * (plan.method ? 5 : 4);
+            if (plan.bits < best.bits) best = std::move(plan);
+            if (po > 0) {
+                for (uint32_t p = 0; p < partitions / 2; ++p) sums[p] = sums[2 * p] + sums[2 * p + 1];
+            }
+        }
+        return best;
+    }
+
+    // Windowed autocorrelation + Levinson-Durbin: lpc[o - 1] holds the
+    // order-o predictor coefficients. Returns the highest usable order.
+    uint32_t computeLpc(const int32_t* x, uint32_t n, uint32_t maxOrder, double lpc[maxLpcOrder][maxLpcOrder]) {
+        if (window.size() != n) {
+            // Tukey window (flat in the middle, cosine tapers over 25% at each end)
+            window.assign(n, 1.0);
+            const uint32_t taper = n / 4;
+            for (uint32_t i = 0; i < taper; ++i) {
+                const double w = 0.5 - 0.5 * std::cos(M_PI * i / taper);
+                window[i] = w;
+                window[n - 1 - i] = w;
+            }
+        }
+        windowed.resize(n);
+        for (uint32_t i = 0; i < n; ++i) windowed[i] = x[i] * window[i];
+
+        double autoc[maxLpcOrder + 1];
+        for (uint32_t lag = 0; lag <= maxOrder; ++lag) {
+            double sum = 0.0;
+            for (uint32_t i = lag; i < n; ++i) sum += windowed[i] * windowed[i - lag];
+            autoc[lag] = sum;
+        }
+        if (autoc[0] <= 0.0) return 0;
+
+        double coefs[maxLpcOrder];
+        double error = autoc[0];
+        for (uint32_t i = 0; i < maxOrder; ++i) {
+            // Reflection coefficient for this order, then update the lower ones
+            double r = -autoc[i + 1];
+            for (uint32_t j = 0; j < i; ++j) r -= coefs[j] * autoc[i - j];
+            r /= error;
+            coefs[i] = r;
+            uint32_t j = 0;
+            for (; j < i / 2; ++j) {
+                const double tmp = coefs[j];
+                coefs[j] += r * coefs[i - 1 - j];
+                coefs[i - 1 - j] += r * tmp;
+            }
+            if (i & 1) coefs[j] += coefs[j] * r;
+            error *= 1.0 - r * r;
+            for (uint32_t k = 0; k <= i; ++k) lpc[i][k] = -coefs[k];
+            if (error <= 0.0) return i + 1;
+        }
+        return maxOrder;
+    }
+
+    // Rounds the coefficients to precision-bit integers scaled by 2^shift,
+    // carrying the rounding error into the next coefficient
+    static bool quantizeLpc(const double* lpc, uint32_t order, uint32_t precision, int32_t* q, int32_t& shift) {
+        double cmax = 0.0;
+        for (uint32_t i = 0; i < order; ++i) cmax = std::max(cmax, std::fabs(lpc[i]));
+        if (cmax <= 0.0) return false;
+        int log2cmax;
+        std::frexp(cmax, &log2cmax);
+        shift = static_cast<int32_t>(precision) - 1 - log2cmax;
+        if (shift > 15) shift = 15;
+        if (shift < 0) return false;
+        const int32_t qmax = (1 << (precision - 1)) - 1;
+        const int32_t qmin = -(1 << (precision - 1));
+        double error = 0.0;
+        for (uint32_t i = 0; i < order; ++i) {
+            error += lpc[i] * (1 << shift);
+            const int32_t v = std::clamp(static_cast<int32_t>(std::lround(error)), qmin, qmax);
+            error -= v;
+            q[i] = v;
+        }
+        return true;
+    }
+
+    // Picks the smallest of CONSTANT, VERBATIM, FIXED 0-4 and LPC, then writes it
+    void encodeSubframe(BitWriter& bw, const int32_t* source, uint32_t n, uint32_t bps) {
+        // Wasted bits: low bits that are zero in every sample (e.g. 16-bit data in 24 bits)
+        uint32_t allBits = 0;
+        for (uint32_t i = 0; i < n; ++i) allBits |= static_cast<uint32_t>(source[i]);
+        uint32_t wasted = 0;
+        if (allBits) while (!(allBits & (1u << wasted))) ++wasted;
+        const uint32_t sampleBits = bps - wasted;
+        samples.resize(n);
+        for (uint32_t i = 0; i < n; ++i) samples[i] = source[i] >> wasted;
+        const int32_t* x = samples.data();
+
+        const uint32_t headerBits = 8 + wasted;
+        auto writeHeader = [&](uint32_t type) {
+            bw.writeBits(0, 1);
+            bw.writeBits(type, 6);
+            bw.writeBits(wasted ? 1 : 0, 1);
+            if (wasted) bw.writeUnary(wasted - 1);
+        };
+
+        if (std::all_of(x, x + n, [&](int32_t v) { return v == x[0]; })) {
+            writeHeader(0);
+            bw.writeSigned(x[0], sampleBits);
+            return;
+        }
+
+        enum { Verbatim, Fixed, Lpc } bestType = Verbatim;
+        uint64_t bestBits = headerBits + static_cast<uint64_t>(n) * sampleBits;
+        uint32_t bestOrder = 0;
+        RicePlan bestPlan;
+        bestResidual.resize(n);
+        residual.resize(n);
+
+        const uint32_t maxFixed = std::min(4u, n - 1);
+        for (uint32_t order = 0; order <= maxFixed; ++order) {
+            if (!fixedResidual(x, n, order, residual.data())) continue;
+            RicePlan plan = planRice(residual.data(), n, order);
+            const uint64_t bits = headerBits + static_cast<uint64_t>(order) * sampleBits + plan.bits;
+            if (bits < bestBits) {
+                bestType = Fixed;
+                bestBits = bits;
+                bestOrder = order;
+                bestPlan = std::move(plan);
+                residual.swap(bestResidual);
+            }
+        }
+
+        int32_t bestCoefs[maxLpcOrder];
+        int32_t bestShift = 0;
+        const uint32_t precision = (sampleBits <= 16) ? 12 : 15;
+        const uint32_t lpcOrderLimit = std::min(maxLpcOrder, n / 2);
+        double lpc[maxLpcOrder][maxLpcOrder];
+        const uint32_t available = (lpcOrderLimit > 0) ? computeLpc(x, n, lpcOrderLimit, lpc) : 0;
+        const uint32_t tryOrders[3] = {4, 8, 12};
+        for (uint32_t order : tryOrders) {
+            order = std::min(order, available);
+            if (order == 0) continue;
+            int32_t q[maxLpcOrder];
+            int32_t shift = 0;
+            if (!quantizeLpc(lpc[order - 1], order, precision, q, shift)) continue;
+            if (!lpcResidual(x, n, q, order, shift, residual.data())) continue;
+            RicePlan plan = planRice(residual.data(), n, order);
+            const uint64_t bits = headerBits + static_cast<uint64_t>(order) * (sampleBits + precision) + 9 + plan.bits;
+            if (bits < bestBits) {
+                bestType = Lpc;
+                bestBits = bits;
+                bestOrder = order;
+                bestShift = shift;
+                std::copy(q, q + order, bestCoefs);
+                bestPlan = std::move(plan);
+                residual.swap(bestResidual);
+            }
+        }
+
+        if (bestType == Verbatim) {
+            writeHeader(1);
+            for (uint32_t i = 0; i < n; ++i) bw.writeSigned(x[i], sampleBits);
+            return;
+        }
+
+        writeHeader(bestType == Fixed ? 8 + bestOrder : 32 + bestOrder - 1);
+        for (uint32_t i = 0; i < bestOrder; ++i) bw.writeSigned(x[i], sampleBits); // Warm-up samples
+        if (bestType == Lpc) {
+            bw.writeBits(precision - 1, 4);
+            bw.writeSigned(bestShift, 5);
+            for (uint32_t j = 0; j < bestOrder; ++j) bw.writeSigned(bestCoefs[j], precision);
+        }
+
+        bw.writeBits(bestPlan.method, 2);
+        bw.writeBits(bestPlan.partitionOrder, 4);
+        const uint32_t paramBits = bestPlan.method ? 5 : 4;
+        const uint32_t partitionSize = n >> bestPlan.partitionOrder;
+        size_t i = 0;
+        for (uint32_t p = 0; p < bestPlan.params.size(); ++p) {
+            const uint32_t k = bestPlan.params[p];
+            bw.writeBits(k, paramBits);
+            const uint32_t count = partitionSize - (p == 0 ? bestOrder : 0);
+            for (uint32_t j = 0; j < count; ++j) bw.writeRice(bestResidual[i++], k);
+        }
+    }
+
+    // Residuals are checked to fit in 31 bits so their folded form fits in 32
+    static bool fits(int64_t r) { return r >= -(1ll << 30) && r < (1ll << 30); }
+
+    static bool fixedResidual(const int32_t* x, uint32_t n, uint32_t order, int32_t* out) {
+        for (uint32_t i = order; i < n; ++i) {
+            int64_t r = x[i];
+            switch (order) {
+            case 1: r -= x[i - 1]; break;
+            case 2: r -= 2ll * x[i - 1] - x[i - 2]; break;
+            case 3: r -= 3ll * x[i - 1] - 3ll * x[i - 2] + x[i - 3]; break;
+            case 4: r -= 4ll * x[i - 1] - 6ll * x[i - 2] + 4ll * x[i - 3] - x[i - 4]; break;
+            }
+            if (!fits(r)) return false;
+            out[i - order] = static_cast<int32_t>(r);
+        }
+        return true;
+    }
+
+    static bool lpcResidual(const int32_t* x, uint32_t n, const int32_t* q, uint32_t order, int32_t shift, int32_t* out) {
+        for (uint32_t i = order; i < n; ++i) {
+            int64_t sum = 0;
+            for (uint32_t j = 0; j < order; ++j) sum += static_cast<int64_t>(q[j]) * x[i - 1 - j];
+            const int64_t r = x[i] - (sum >> shift);
+            if (!fits(r)) return false;
+            out[i - order] = static_cast<int32_t>(r);
+        }
+        return true;
+    }
+
+    AudioFormat format;
+    std::vector<int32_t> planar;       // Channels (+ mid and side) one after another
+    std::vector<int32_t> samples;      // Current channel with wasted bits removed
+    std::vector<int32_t> residual;
+    std::vector<int32_t> bestResidual;
+    std::vector<uint64_t> sums;
+    std::vector<double> window;
+    std::vector<double> windowed;
+};
+
+// ---------------------------------------------------------------------------
+// Block reader / writer interface: processing code reads and writes
+// interleaved int32 blocks and never sees the file format
+// ---------------------------------------------------------------------------
+class BlockReader {
+public:
+    virtual ~BlockReader() = default;
+    virtual bool open(const std::string& path) = 0;
+    // Reads up to `frames` frames; returns how many were read (0 at the end)
+    virtual size_t read(int32_t* interleaved, size_t frames) = 0;
+    virtual bool failed() const { return error; }
+    const AudioFormat& format() const { return fmt; }
+
+protected:
+    AudioFormat fmt;
+    bool error = false;
+};
+
+class BlockWriter {
+public:
+    virtual ~BlockWriter() = default;
+    virtual bool open(const std::string& path, const AudioFormat& format) = 0;
+    virtual bool write(const int32_t* interleaved, size_t frames) = 0;
+    // Flushes everything and fills in the header fields only known at the end
+    virtual bool close() = 0;
+};
+
+class WavBlockReader : public BlockReader {
+public:
+    bool open(const std::string& path) override {
+        in.open(path, std::ios::binary);
+        if (!in) {
+            std::cerr << "Error: could not open " << path << "\n";
+            return false;
+        }
+        WavHeader header;
+        in.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!in || std::strncmp(header.riff, "RIFF", 4) != 0 || std::strncmp(header.wave, "WAVE", 4) != 0) {
+            std::cerr << "Error: " << path << " is not a valid WAV file\n";
+            return false;
+        }
+        if (header.audioFormat != 1 || (header.bitsPerSample != 8 && header.bitsPerSample != 16 && header.bitsPerSample != 24)) {
+            std::cerr << "Error: " << path << " must be 8, 16 or 24-bit PCM\n";
+            return false;
+        }
+        fmt.sampleRate = header.sampleRate;
+        fmt.channels = header.numChannels;
+        fmt.bitsPerSample = header.bitsPerSample;
+        bytesPerSample = header.bitsPerSample / 8;
+        fmt.totalFrames = header.subchunk2Size / (bytesPerSample * fmt.channels);
+        remaining = fmt.totalFrames;
+        return true;
+    }
+
+    size_t read(int32_t* interleaved, size_t frames) override {
+        frames = static_cast<size_t>(std::min<uint64_t>(frames, remaining));
+        const size_t count = frames * fmt.channels;
+        raw.resize(count * bytesPerSample);
+        in.read(reinterpret_cast<char*>(raw.data()), static_cast<std::streamsize>(raw.size()));
+        if (static_cast<size_t>(in.gcount()) != raw.size()) {
+            error = true;
+            return 0;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            const uint8_t* p = raw.data() + i * bytesPerSample;
+            if (bytesPerSample == 1) interleaved[i] = p[0] - 128; // 8-bit WAV is unsigned
+            else if (bytesPerSample == 2) interleaved[i] = static_cast<int16_t>(p[0] | (p[1] << 8));
+            else interleaved[i] = static_cast<int32_t>(static_cast<uint32_t>(p[0]) << 8 | static_cast<uint32_t>(p[1]) << 16 | static_cast<uint32_t>(p[2]) << 24) >> 8;
+        }
+        remaining -= frames;
+        return frames;
+    }
+
+private:
+    std::ifstream in;
+    std::vector<uint8_t> raw;
+    uint32_t bytesPerSample = 2;
+    uint64_t remaining = 0;
+};
+
+class WavBlockWriter : public BlockWriter {
+public:
+    bool open(const std::string& path, const AudioFormat& format) override {
+        if (format.bitsPerSample != 8 && format.bitsPerSample != 16 && format.bitsPerSample != 24) {
+            std::cerr << "Error: WAV output needs 8, 16 or 24-bit audio (got " << format.bitsPerSample << "-bit)\n";
+            return false;
+        }
+        fmt = format;
+        bytesPerSample = fmt.bitsPerSample / 8;
+        out.open(path, std::ios::binary);
+        if (!out) {
+            std::cerr << "Error: could not create " << path << "\n";
+            return false;
+        }
+        WavHeader header = makeHeader(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header)); // Sizes are patched in close()
+        return true;
+    }
+
+    bool write(const int32_t* interleaved, size_t frames) override {
+        const size_t count = frames * fmt.channels;
+        raw.resize(count * bytesPerSample);
+        for (size_t i = 0; i < count; ++i) {
+            uint8_t* p = raw.data() + i * bytesPerSample;
+            const int32_t v = interleaved[i];
+            if (bytesPerSample == 1) p[0] = static_cast<uint8_t>(v + 128);
+            else {
+                for (uint32_t b = 0; b < bytesPerSample; ++b) p[b] = static_cast<uint8_t>(v >> (8 * b));
+            }
+        }
+        out.write(reinterpret_cast<const char*>(raw.data()), static_cast<std::streamsize>(raw.size()));
+        dataBytes += raw.size();
+        return static_cast<bool>(out);
+    }
+
+    bool close() override {
+        WavHeader header = makeHeader(static_cast<uint32_t>(dataBytes));
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.close();
+        return !out.fail();
+    }
+
+private:
+    WavHeader makeHeader(uint32_t dataSize) const {
+        WavHeader header;
+        std::memcpy(header.riff, "RIFF", 4);
+        std::memcpy(header.wave, "WAVE", 4);
+        std::memcpy(header.fmt, "fmt ", 4);
+        std::memcpy(header.data, "data", 4);
+        header.subchunk1Size = 16;
+        header.audioFormat = 1;
+        header.numChannels = static_cast<uint16_t>(fmt.channels);
+        header.sampleRate = fmt.sampleRate;
+        header.bitsPerSample = static_cast<uint16_t>(fmt.bitsPerSample);
+        header.blockAlign = static_cast<uint16_t>(fmt.channels * bytesPerSample);
+        header.byteRate = fmt.sampleRate * header.blockAlign;
+        header.subchunk2Size = dataSize;
+        header.chunkSize = 36 + dataSize;
+        return header;
+    }
+
+    AudioFormat fmt;
+    std::ofstream out;
+    std::vector<uint8_t> raw;
+    uint32_t bytesPerSample = 2;
+    uint64_t dataBytes = 0;
+};
+
+class FlacBlockReader : public BlockReader {
+public:
+    bool open(const std::string& path) override {
+        in.open(path, std::ios::binary);
+        if (!in) {
+            std::cerr << "Error: could not open " << path << "\n";
+            return false;
+        }
+        fill(10);
+        if (buffer.size() >= 10 && std::memcmp(buffer.data(), "ID3", 3) == 0) {
+            // Some taggers put an ID3v2 tag in front; its size is stored 7 bits per byte
+            fill(10);
+            pos = 10 + ((buffer[6] & 0x7F) << 21 | (buffer[7] & 0x7F) << 14 | (buffer[8] & 0x7F) << 7 | (buffer[9] & 0x7F));
+            fill(pos + 4);
+        }
+        if (buffer.size() < pos + 4 || std::memcmp(buffer.data() + pos, "fLaC", 4) != 0) {
+            std::cerr << "Error: " << path << " is not a FLAC file\n";
+            return false;
+        }
+        pos += 4;
+
+        // Metadata blocks: STREAMINFO comes first, the rest (tags, pictures, ...) is skipped
+        bool last = false, haveInfo = false;
+        while (!last) {
+            fill(pos + 4);
+            if (buffer.size() < pos + 4) break;
+            last = (buffer[pos] & 0x80) != 0;
+            const uint32_t type = buffer[pos] & 0x7F;
+            const size_t length = (buffer[pos + 1] << 16) | (buffer[pos + 2] << 8) | buffer[pos + 3];
+            pos += 4;
+            fill(pos + length);
+            if (buffer.size() < pos + length) break;
+            if (type == 0 && length >= 34) {
+                info = unpackStreamInfo(buffer.data() + pos);
+                haveInfo = true;
+            }
+            pos += length;
+        }
+        if (!haveInfo || !last || info.channels == 0 || info.bitsPerSample < 4 || info.bitsPerSample > 32) {
+            std::cerr << "Error: " << path << " has a missing or broken STREAMINFO block\n";
+            return false;
+        }
+        fmt.sampleRate = info.sampleRate;
+        fmt.channels = info.channels;
+        fmt.bitsPerSample = info.bitsPerSample;
+        fmt.totalFrames = info.totalSamples;
+        return true;
+    }
+
+    size_t read(int32_t* interleaved, size_t frames) override {
+        // Once a frame is found broken the stream stops there, so callers
+        // see the end and check failed()
+        if (error) return 0;
+        size_t done = 0;
+        while (done < frames) {
+            if (ready == decoded.size() && (error || !decodeBatch())) break;
+            const DecodedFrame& frame = decoded[ready];
+            const size_t take = std::min<size_t>(frames - done, frame.blockSize - readOffset);
+            std::copy(frame.samples.begin() + readOffset * fmt.channels, frame.samples.begin() + (readOffset + take) * fmt.channels,
+                      interleaved + done * fmt.channels);
+            done += take;
+            readOffset += take;
+            if (readOffset == frame.blockSize) {
+                ++ready;
+                readOffset = 0;
+            }
+        }
+        return done;
+    }
+
+private:
+    // Makes sure the buffer holds at least `size` bytes if the file has them
+    void fill(size_t size) {
+        if (buffer.size() >= size || eof) return;
+        const size_t old = buffer.size();
+        buffer.resize(size);
+        in.read(reinterpret_cast<char*>(buffer.data() + old), static_cast<std::streamsize>(size - old));
+        buffer.resize(old + static_cast<size_t>(in.gcount()));
+        if (buffer.size() < size) eof = true;
+    }
+
+    // Decodes the next batch of frames on all threads
+    bool decodeBatch() {
+        decoded.clear();
+        ready = 0;
+        readOffset = 0;
+
+        size_t batchBytes = decodeBatchBytes;
+        for (;;) {
+            // Drop the bytes already used and top the buffer up
+            buffer.erase(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(pos));
+            pos = 0;
+            fill(batchBytes);
+            if (buffer.empty()) {
+                // A file cut off right at a frame boundary ends early but cleanly
+                if (info.totalSamples && samplesOut < info.totalSamples) {
+                    std::cerr << "Error: FLAC stream ends early at sample " << samplesOut << "\n";
+                    error = true;
+                }
+                return false;
+            }
+
+            // 1) Chain together frame starts: sync code, valid header CRC and
+            //    the next frame number
+            FrameHeader h;
+            if (!parseFrameHeader(buffer.data(), buffer.size(), info, h)) {
+                // Trailing junk (e.g. an ID3v1 tag) is fine once all the audio is out
+                if (!eof || (info.totalSamples && samplesOut < info.totalSamples)) {
+                    std::cerr << "Error: lost frame sync in the FLAC stream\n";
+                    error = true;
+                }
+                return false;
+            }
+            std::vector<size_t> starts{0};
+            uint64_t expected = nextFrameNumber(h);
+            const uint8_t* base = buffer.data();
+            const uint8_t* end = base + buffer.size();
+            const uint8_t* p = base + h.headerBytes;
+            while (p + 1 < end) {
+                p = static_cast<const uint8_t*>(std::memchr(p, 0xFF, static_cast<size_t>(end - p - 1)));
+                if (!p) break;
+                FrameHeader c;
+                if ((p[1] & 0xFE) == 0xF8 && parseFrameHeader(p, static_cast<size_t>(end - p), info, c) && c.number == expected &&
+                    c.variableBlockSize == h.variableBlockSize) {
+                    starts.push_back(static_cast<size_t>(p - base));
+                    expected = nextFrameNumber(c);
+                    p += c.headerBytes;
+                } else {
+                    ++p;
+                }
+            }
+
+            // Only frames with a known end can be decoded, except at the end of the file
+            const size_t count = eof ? starts.size() : starts.size() - 1;
+            if (count == 0) {
+                batchBytes *= 2; // One frame bigger than the batch: read more
+                continue;
+            }
+
+            // 2) Decode them on all threads. A frame is good if its CRC-16
+            //    matches and it ends right where the next one starts.
+            decoded.resize(count);
+            std::vector<char> good(count, 0);
+            std::atomic<size_t> next{0};
+            auto worker = [&] {
+                for (size_t k = next++; k < count; k = next++) {
+                    const size_t limit = (k + 1 < starts.size()) ? starts[k + 1] : buffer.size();
+                    good[k] = decodeFrame(base + starts[k], limit - starts[k], info, decoded[k]) &&
+                              (k + 1 == starts.size() || decoded[k].bytes == limit - starts[k]);
+                }
+            };
+            const unsigned numThreads = std::max(1u, std::min<unsigned>(std::thread::hardware_concurrency(), static_cast<unsigned>(count)));
+            std::vector<std::thread> threads;
+            for (unsigned t = 1; t < numThreads; ++t) threads.emplace_back(worker);
+            worker();
+            for (auto& t : threads) t.join();
+
+            // 3) A bad frame means one of the sync codes was fake. Decode that
+            //    frame on its own (which tells us its real length) and stop the
+            //    batch there; the next batch rescans from the right place.
+            size_t goodCount = 0;
+            bool corrupt = false;
+            while (goodCount < count && good[goodCount]) ++goodCount;
+            if (goodCount < count) {
+                DecodedFrame& frame = decoded[goodCount];
+                if (decodeFrame(base + starts[goodCount], buffer.size() - starts[goodCount], info, frame)) {
+                    decoded.resize(goodCount + 1);
+                    pos = starts[goodCount] + frame.bytes;
+                } else {
+                    // Really broken: hand out the good frames before it and
+                    // stop there, so they are never decoded a second time
+                    corrupt = true;
+                    decoded.resize(goodCount);
+                    pos = starts[goodCount];
+                }
+            } else {
+                pos = (count < starts.size()) ? starts[count] : starts[count - 1] + decoded[count - 1].bytes;
+            }
+
+            // Frames must follow on from each other with no gaps
+            for (const DecodedFrame& frame : decoded) {
+                if (frame.firstSample != samplesOut) {
+                    std::cerr << "Error: FLAC frame out of sequence at sample " << samplesOut << "\n";
+                    error = true;
+                    decoded.clear();
+                    return false;
+                }
+                samplesOut += frame.blockSize;
+            }
+            if (corrupt) {
+                std::cerr << "Error: corrupt FLAC frame at sample " << samplesOut << "\n";
+                error = true;
+            }
+            return !decoded.empty();
+        }
+    }
+
+    std::ifstream in;
+    std::vector<uint8_t> buffer; // Compressed bytes, starting at the next frame
+    size_t pos = 0;
+    bool eof = false;
+    StreamInfo info;
+    std::vector<DecodedFrame> decoded;
+    size_t ready = 0;            // Next frame in `decoded` to hand out
+    size_t readOffset = 0;       // Position inside that frame
+    uint64_t samplesOut = 0;
+};
+
+class FlacBlockWriter : public BlockWriter {
+public:
+    bool open(const std::string& path, const AudioFormat& format) override {
+        if (format.channels < 1 || format.channels > 8 || format.bitsPerSample < 4 || format.bitsPerSample > 32 ||
+            format.sampleRate == 0 || format.sampleRate >= (1u << 20)) {
+            std::cerr << "Error: FLAC can't store this format\n";
+            return false;
+        }
+        fmt = format;
+        out.open(path, std::ios::binary);
+        if (!out) {
+            std::cerr << "Error: could not create " << path << "\n";
+            return false;
+        }
+        // "fLaC", then STREAMINFO as the only (so last) metadata block. The
+        // sizes and sample count are patched in close().
+        out.write("fLaC", 4);
+        const uint8_t blockHeader[4] = {0x80, 0, 0, 34};
+        out.write(reinterpret_cast<const char*>(blockHeader), 4);
+        const std::vector<uint8_t> streamInfo = packStreamInfo(makeStreamInfo());
+        out.write(reinterpret_cast<const char*>(streamInfo.data()), static_cast<std::streamsize>(streamInfo.size()));
+        return static_cast<bool>(out);
+    }
+
+    bool write(const int32_t* interleaved, size_t frames) override {
+        pending.insert(pending.end(), interleaved, interleaved + frames * fmt.channels);
+        if (pending.size() / fmt.channels >= batchFrames()) return flush(false);
+        return true;
+    }
+
+    bool close() override {
+        if (!flush(true)) return false;
+        out.seekp(8);
+        const std::vector<uint8_t> streamInfo = packStreamInfo(makeStreamInfo());
+        out.write(reinterpret_cast<const char*>(streamInfo.data()), static_cast<std::streamsize>(streamInfo.size()));
+        out.close();
+        return !out.fail();
+    }
+
+private:
+    static unsigned threadCount() { return std::max(1u, std::thread::hardware_concurrency()); }
+    static size_t batchFrames() { return flacBlockSize * framesPerThread * threadCount(); }
+
+    StreamInfo makeStreamInfo() const {
+        StreamInfo info;
+        // A stream shorter than one block is a single, smaller block
+        const uint32_t blockSize = (totalFrames > 0 && totalFrames < flacBlockSize) ? static_cast<uint32_t>(totalFrames) : flacBlockSize;
+        info.minBlockSize = blockSize;
+        info.maxBlockSize = blockSize;
+        info.minFrameSize = (minFrameSize == UINT32_MAX) ? 0 : minFrameSize;
+        info.maxFrameSize = maxFrameSize;
+        info.sampleRate = fmt.sampleRate;
+        info.channels = fmt.channels;
+        info.bitsPerSample = fmt.bitsPerSample;
+        info.totalSamples = totalFrames;
+        return info;
+    }
+
+    // Encodes the whole blocks in `pending` (and the partial last one if
+    // final) on all threads, then writes them out in order
+    bool flush(bool final) {
+        const size_t available = pending.size() / fmt.channels;
+        const size_t blocks = final ? (available + flacBlockSize - 1) / flacBlockSize : available / flacBlockSize;
+        if (blocks == 0) return true;
+
+        std::vector<std::vector<uint8_t>> encoded(blocks);
+        std::atomic<size_t> next{0};
+        auto worker = [&] {
+            FrameEncoder encoder(fmt);
+            for (size_t b = next++; b < blocks; b = next++) {
+                const size_t first = b * flacBlockSize;
+                const uint32_t n = static_cast<uint32_t>(std::min<size_t>(flacBlockSize, available - first));
+                encoder.encode(pending.data() + first * fmt.channels, n, framesWritten + b, encoded[b]);
+            }
+        };
+        const unsigned numThreads = std::min<unsigned>(threadCount(), static_cast<unsigned>(blocks));
+        std::vector<std::thread> threads;
+        for (unsigned t = 1; t < numThreads; ++t) threads.emplace_back(worker);
+        worker();
+        for (auto& t : threads) t.join();
+
+        for (const auto& frame : encoded) {
+            out.write(reinterpret_cast<const char*>(frame.data()), static_cast<std::streamsize>(frame.size()));
+            minFrameSize = std::min(minFrameSize, static_cast<uint32_t>(frame.size()));
+            maxFrameSize = std::max(maxFrameSize, static_cast<uint32_t>(frame.size()));
+        }
+        const size_t used = std::min(available, blocks * flacBlockSize);
+        pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(used * fmt.channels));
+        framesWritten += blocks;
+        totalFrames += used;
+        return static_cast<bool>(out);
+    }
+
+    AudioFormat fmt;
+    std::ofstream out;
+    std::vector<int32_t> pending; // Interleaved audio waiting for a full batch
+    uint64_t framesWritten = 0;   // FLAC frames so far
+    uint64_t totalFrames = 0;     // Audio frames so far
+    uint32_t minFrameSize = UINT32_MAX;
+    uint32_t maxFrameSize = 0;
+};
+
+// Picks the implementation from the file extension
+bool isFlacPath(const std::string& path) {
+    std::string ext = std::filesystem::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return ext == ".flac";
+}
+
+std::unique_ptr<BlockReader> openReader(const std::string& path) {
+    std::unique_ptr<BlockReader> reader;
+    if (isFlacPath(path)) reader = std::make_unique<FlacBlockReader>();
+    else reader = std::make_unique<WavBlockReader>();
+    if (!reader->open(path)) return nullptr;
+    return reader;
+}
+
+std::unique_ptr<BlockWriter> openWriter(const std::string& path, const AudioFormat& format) {
+    std::unique_ptr<BlockWriter> writer;
+    if (isFlacPath(path)) writer = std::make_unique<FlacBlockWriter>();
+    else writer = std::make_unique<WavBlockWriter>();
+    if (!writer->open(path, format)) return nullptr;
+    return writer;
+}
+
+// ---------------------------------------------------------------------------
+// A batch job: read blocks, optionally apply gain, write blocks
+// ---------------------------------------------------------------------------
+bool convert(const std::string& inPath, const std::string& outPath, double gain) {
+    auto reader = openReader(inPath);
+    if (!reader) return false;
+    const AudioFormat format = reader->format();
+    auto writer = openWriter(outPath, format);
+    if (!writer) return false;
+
+    const int64_t maxValue = (1ll << (format.bitsPerSample - 1)) - 1;
+    const int64_t minValue = -(1ll << (format.bitsPerSample - 1));
+    std::vector<int32_t> block(blockFrames * format.channels);
+    size_t frames;
+    while ((frames = reader->read(block.data(), blockFrames)) > 0) {
+        if (gain != 1.0) {
+            for (size_t i = 0; i < frames * format.channels; ++i) {
+                const int64_t v = std::llround(block[i] * gain);
+                block[i] = static_cast<int32_t>(std::clamp(v, minValue, maxValue));
+            }
+        }
+        if (!writer->write(block.data(), frames)) {
+            std::cerr << "Error: failed writing " << outPath << "\n";
+            return false;
+        }
+    }
+    if (reader->failed()) return false;
+    if (!writer->close()) {
+        std::cerr << "Error: failed finishing " << outPath << "\n";
+        return false;
+    }
+    return true;
+}
+
+// Reads both files through the block interface and compares every sample
+bool sameAudio(const std::string& a, const std::string& b) {
+    auto ra = openReader(a);
+    auto rb = openReader(b);
+    if (!ra || !rb) return false;
+    if (ra->format().channels != rb->format().channels || ra->format().bitsPerSample != rb->format().bitsPerSample) return false;
+    const size_t channels = ra->format().channels;
+    std::vector<int32_t> ba(blockFrames * channels), bb(blockFrames * channels);
+    for (;;) {
+        const size_t na = ra->read(ba.data(), blockFrames);
+        const size_t nb = rb->read(bb.data(), blockFrames);
+        if (na != nb) return false;
+        if (na == 0) return !ra->failed() && !rb->failed();
+        if (!std::equal(ba.begin(), ba.begin() + na * channels, bb.begin())) return false;
+    }
+}
+
+// Writes a damaged copy of a file: cut to `keepBytes`, then `flipBytes`
+// bytes inverted starting at `flipAt`
+void writeDamagedCopy(const std::string& inPath, const std::string& outPath, size_t keepBytes, size_t flipAt, size_t flipBytes) {
+    std::ifstream in(inPath, std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    bytes.resize(std::min(bytes.size(), keepBytes));
+    for (size_t i = flipAt; i < std::min(bytes.size(), flipAt + flipBytes); ++i) bytes[i] = static_cast<char>(~bytes[i]);
+    std::ofstream out(outPath, std::ios::binary);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    std::string inPath, outPath;
+    double gain = 1.0;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--gain" && i + 1 < argc) gain = std::atof(argv[++i]);
+        else if (inPath.empty()) inPath = arg;
+        else if (outPath.empty()) outPath = arg;
+        else {
+            std::cerr << "Usage: flac in.(wav|flac) out.(wav|flac) [--gain G]\n";
+            return 1;
+        }
+    }
+
+    if (!inPath.empty()) {
+        if (outPath.empty()) {
+            std::cerr << "Usage: flac in.(wav|flac) out.(wav|flac) [--gain G]\n";
+            return 1;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        if (!convert(inPath, outPath, gain)) return 1;
+        const double seconds = secondsSince(start);
+        const auto inBytes = std::filesystem::file_size(inPath);
+        const auto outBytes = std::filesystem::file_size(outPath);
+        std::cout << inPath << " (" << inBytes << " bytes) -> " << outPath << " (" << outBytes << " bytes, "
+                  << (100.0 * outBytes / inBytes) << "%) in " << seconds << " s\n";
+        return 0;
+    }
+
+    // Demo: round trip input.wav through FLAC and check nothing changed
+    const unsigned numThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "Threads: " << numThreads << "\n";
+
+    auto start = std::chrono::steady_clock::now();
+    if (!convert("input.wav", "output.flac", 1.0)) return 1;
+    const double encodeSeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    if (!convert("output.flac", "output_decoded.wav", 1.0)) return 1;
+    const double decodeSeconds = secondsSince(start);
+
+    const auto wavBytes = std::filesystem::file_size("input.wav");
+    const auto flacBytes = std::filesystem::file_size("output.flac");
+    std::cout << "input.wav:   " << wavBytes << " bytes\n";
+    std::cout << "output.flac: " << flacBytes << " bytes (" << (100.0 * flacBytes / wavBytes) << "% of the WAV)\n";
+    std::cout << "Encode: " << encodeSeconds * 1000.0 << " ms, decode: " << decodeSeconds * 1000.0 << " ms\n";
+
+    if (!sameAudio("input.wav", "output_decoded.wav")) {
+        std::cerr << "FAIL: output_decoded.wav does not match input.wav\n";
+        return 1;
+    }
+    std::cout << "PASS: output_decoded.wav matches input.wav sample for sample\n";
+
+    // Damaged files must fail cleanly: an error and a non-zero exit, not a
+    // hang or a short file reported as fine
+    const size_t half = static_cast<size_t>(flacBytes / 2);
+    writeDamagedCopy("output.flac", "output_truncated.flac", half, 0, 0);
+    writeDamagedCopy("output.flac", "output_corrupt.flac", static_cast<size_t>(flacBytes), half, 64);
+    bool ok = true;
+    for (const char* damaged : {"output_truncated.flac", "output_corrupt.flac"}) {
+        std::cout << damaged << ": ";
+        std::cout.flush();
+        if (convert(damaged, "output_damaged.wav", 1.0)) {
+            std::cerr << "FAIL: " << damaged << " decoded without an error\n";
+            ok = false;
+        } else {
+            std::cout << "PASS: rejected\n";
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,900 @@
+/*
+    MicroDSP - Day 25: Shared-Memory Ring Between Processes
+
+    What this program does:
+    - Connects two separate MicroDSP processes with a ring of audio blocks
+      in shared memory: the first process writes its output straight into
+      the ring, the second reads its input straight out of it
+    - The processes find each other through a small handshake over a Unix
+      socket, which hands over the shared memory itself (as a file
+      descriptor)
+    - An idle side sleeps in the kernel (futex) instead of spinning, and is
+      woken the moment there is something to do
+    - Benchmarks a gain -> delay chain (Day 2 gain into Day 4 delay) split
+      across two processes, connected three ways:
+        files   stage 1 writes a temp file, stage 2 reads it
+        pipes   stage 1 writes into a pipe, stage 2 reads from it
+        shm     the shared-memory ring
+      and checks all three produce identical output
+
+    Usage:
+        shm_ring [repeats]               benchmark (default 150 x input.wav,
+                                         about 5 minutes of audio)
+        shm_ring send sock [in.wav] [gain]
+        shm_ring recv sock [out.wav]
+            run the two halves of the chain as separate programs, e.g. in
+            two terminals; they meet at the Unix socket path "sock"
+
+    Why a shared ring saves copies:
+    - A pipe or file is a kernel buffer. write() copies a block from the
+      first process into the kernel, and read() copies it back out into the
+      second. Every block is copied twice, plus two system calls.
+    - With shared memory both processes see the same physical pages. Stage
+      1's gain writes its output straight into a slot, and stage 2's delay
+      reads its input straight from that slot. Nothing is copied in between.
+
+    How the ring works:
+    - 64 slots of 4096 frames. Two counters live in the shared header:
+      "written" (slots the producer has filled) and "released" (slots the
+      consumer has finished with). Each side only ever writes its own
+      counter, so no locks are needed (single producer, single consumer).
+    - The producer may fill a slot when written - released < 64. The
+      consumer may read one when released < written. A slot holding 0
+      frames marks the end of the stream.
+    - Waiting: spin for a moment (the other side is often just about to
+      finish), then raise a "sleeping" flag and sleep on the counter with
+      futex(). The other side only makes the wake-up system call when that
+      flag is up, so a busy chain makes no system calls at all.
+    - Handshake: the producer creates the memory with memfd_create (an
+      anonymous file that lives only in RAM) and sends its descriptor over
+      a Unix socket (SCM_RIGHTS). The consumer maps it, checks the magic
+      number and version, and replies with its process id. Both sides keep
+      the socket open afterwards: when a process exits or crashes the
+      kernel closes its end, so each side checks now and then whether the
+      socket has hung up, and neither waits forever for a dead partner.
+      (Checking the process id with kill(pid, 0) is not enough: a process
+      that has exited but not been reaped by its parent still "exists".)
+
+    Platform notes:
+    - Linux. Other POSIX systems fall back to shm_open and short sleeps
+      instead of futexes.
+
+    Build:
+        g++ -std=c++17 -O3 -march=native shm_ring.cpp -o shm_ring
+
+    Author: Jesse Whiting (GhostWire Audio)
+    GitHub: ghostwireaudio
+*/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <new>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+// Force the compiler to pack the struct exactly as written
+// with no padding bytes added for alignment, which ensures
+// sizeof(WavHeader) == 44 bytes
+#pragma pack(push, 1)
+struct WavHeader {
+    // RIFF Chunk Descriptor
+    char     riff[4];        // "RIFF"
+    uint32_t chunkSize;      // 36 + Subchunk2Size
+    char     wave[4];        // "WAVE"
+
+    // fmt subchunk
+    char     fmt[4];         // "fmt "
+    uint32_t subchunk1Size;  // 16 for PCM
+    uint16_t audioFormat;    // 1 for PCM
+    uint16_t numChannels;    // 1 for mono
+    uint32_t sampleRate;     // e.g., 44100
+    uint32_t byteRate;       // sampleRate * numChannels * bitsPerSample/8
+    uint16_t blockAlign;     // numChannels * bitsPerSample/8
+    uint16_t bitsPerSample;  // 16
+
+    // data subchunk
+    char     data[4];        // "data"
+    uint32_t subchunk2Size;  // NumSamples * numChannels * bitsPerSample/8
+};
+#pragma pack(pop)
+
+const uint32_t blockFrames = 4096;          // Frames per block (and per ring slot)
+const uint32_t ringSlots = 64;
+const uint32_t ringMagic = 0x5244534D;      // "MSDR"
+const uint32_t ringVersion = 1;
+const int spinCount = 200;                  // Checks before going to sleep
+
+// Chain settings: Day 2's gain, then Day 4's delay
+const double chainGain = 0.5;
+const float delayMs = 250.0f;
+const float dry = 0.8f;
+const float wet = 0.5f;
+
+struct StreamFormat {
+    uint16_t channels = 0;
+    uint32_t sampleRate = 0;
+    uint64_t totalFrames = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Small I/O helpers
+// ---------------------------------------------------------------------------
+bool writeAll(int fd, const void* buffer, size_t bytes) {
+    const char* p = static_cast<const char*>(buffer);
+    while (bytes > 0) {
+        const ssize_t n = ::write(fd, p, bytes);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        bytes -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Reads until `bytes` or the end of the stream; returns the count read
+size_t readUpTo(int fd, void* buffer, size_t bytes) {
+    char* p = static_cast<char*>(buffer);
+    size_t done = 0;
+    while (done < bytes) {
+        const ssize_t n = ::read(fd, p + done, bytes - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        done += static_cast<size_t>(n);
+    }
+    return done;
+}
+
+bool readWav(const std::string& path, std::vector<int16_t>& samples, StreamFormat& format) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cerr << "Error: could not open " << path << "\n";
+        return false;
+    }
+    WavHeader header;
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || std::strncmp(header.riff, "RIFF", 4) != 0 || std::strncmp(header.wave, "WAVE", 4) != 0) {
+        std::cerr << "Error: " << path << " is not a valid WAV file\n";
+        return false;
+    }
+    if (header.audioFormat != 1 || header.bitsPerSample != 16) {
+        std::cerr << "Error: only 16-bit PCM WAV is supported\n";
+        return false;
+    }
+    samples.resize(header.subchunk2Size / 2);
+    in.read(reinterpret_cast<char*>(samples.data()), static_cast<std::streamsize>(samples.size() * 2));
+    format.channels = header.numChannels;
+    format.sampleRate = header.sampleRate;
+    format.totalFrames = samples.size() / header.numChannels;
+    return true;
+}
+
+WavHeader makeHeader(const StreamFormat& format) {
+    WavHeader header;
+    std::memcpy(header.riff, "RIFF", 4);
+    std::memcpy(header.wave, "WAVE", 4);
+    std::memcpy(header.fmt, "fmt ", 4);
+    std::memcpy(header.data, "data", 4);
+    header.subchunk1Size = 16;
+    header.audioFormat = 1;
+    header.numChannels = format.channels;
+    header.sampleRate = format.sampleRate;
+    header.bitsPerSample = 16;
+    header.blockAlign = static_cast<uint16_t>(format.channels * 2);
+    header.byteRate = format.sampleRate * header.blockAlign;
+    header.subchunk2Size = static_cast<uint32_t>(format.totalFrames * header.blockAlign);
+    header.chunkSize = 36 + header.subchunk2Size;
+    return header;
+}
+
+// The partner holds the other end of the handshake socket until it exits,
+// so a hang-up means it is gone (however it ended)
+bool peerAlive(int peerSocket) {
+    if (peerSocket < 0) return true;
+    pollfd p{peerSocket, POLLIN, 0};
+    if (::poll(&p, 1, 0) <= 0) return true;
+    if (p.revents & (POLLHUP | POLLERR)) return false;
+    char byte;
+    return ::recv(peerSocket, &byte, 1, MSG_PEEK | MSG_DONTWAIT) != 0; // 0 = the other end closed
+}
+
+// ---------------------------------------------------------------------------
+// Sleeping and waking (futex on Linux)
+// ---------------------------------------------------------------------------
+void futexWait(std::atomic<uint32_t>& word, uint32_t expected) {
+#ifdef __linux__
+    // The timeout lets the caller check now and then that its partner is alive
+    timespec timeout{0, 100 * 1000 * 1000};
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+#else
+    (void)word;
+    (void)expected;
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+#endif
+}
+
+void futexWake(std::atomic<uint32_t>& word) {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+// Waits until `word` no longer holds `value`. False if the partner died.
+bool waitForChange(std::atomic<uint32_t>& word, uint32_t value, std::atomic<uint32_t>& sleeping, int peerSocket) {
+    for (int i = 0; i < spinCount; ++i) {
+        if (word.load(std::memory_order_acquire) != value) return true;
+    }
+    // Raise the flag *before* the final check: either we see the new value,
+    // or the other side sees the flag and wakes us (both use seq_cst)
+    sleeping.store(1);
+    while (word.load() == value) {
+        futexWait(word, value);
+        if (word.load() == value && !peerAlive(peerSocket)) {
+            sleeping.store(0);
+            return false;
+        }
+    }
+    sleeping.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// The shared ring
+// ---------------------------------------------------------------------------
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "the ring needs lock-free atomics in shared memory");
+
+// Lives at the start of the shared memory. Each counter sits on its own
+// cache line so the two processes don't fight over the same line.
+struct RingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slots;
+    uint32_t slotFrames;
+    uint32_t channels;
+    uint32_t sampleRate;
+    uint64_t totalFrames;
+    int32_t producerPid;
+    int32_t consumerPid;
+
+    alignas(64) std::atomic<uint32_t> written;          // Producer's counter (consumer sleeps on it)
+    std::atomic<uint32_t> consumerSleeping;
+    alignas(64) std::atomic<uint32_t> released;         // Consumer's counter (producer sleeps on it)
+    std::atomic<uint32_t> producerSleeping;
+    alignas(64) uint32_t frames[ringSlots];             // Frames in each slot; 0 = end of stream
+};
+
+class ShmRing {
+public:
+    ~ShmRing() {
+        if (base) ::munmap(base, size);
+        if (fd >= 0) ::close(fd);
+        if (peerSocket >= 0) ::close(peerSocket);
+    }
+
+    // Producer side: creates the memory and sets up the header
+    bool create(const StreamFormat& format) {
+#ifdef __linux__
+        fd = memfd_create("microdsp-ring", MFD_CLOEXEC);
+#else
+        const std::string name = "/microdsp-ring-" + std::to_string(::getpid());
+        fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd >= 0) shm_unlink(name.c_str()); // Only the descriptor keeps it alive
+#endif
+        if (fd < 0) {
+            std::cerr << "Error: could not create shared memory: " << std::strerror(errno) << "\n";
+            return false;
+        }
+        size = layoutSize(format.channels);
+        if (::ftruncate(fd, static_cast<off_t>(size)) != 0 || !map()) return false;
+        header = new (base) RingHeader{};
+        header->magic = ringMagic;
+        header->version = ringVersion;
+        header->slots = ringSlots;
+        header->slotFrames = blockFrames;
+        header->channels = format.channels;
+        header->sampleRate = format.sampleRate;
+        header->totalFrames = format.totalFrames;
+        header->producerPid = ::getpid();
+        return true;
+    }
+
+    // Consumer side: maps memory received from the producer and checks it
+    bool attach(int receivedFd) {
+        fd = receivedFd;
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(RingHeader)) {
+            std::cerr << "Error: shared memory is too small\n";
+            return false;
+        }
+        size = static_cast<size_t>(st.st_size);
+        if (!map()) return false;
+        header = reinterpret_cast<RingHeader*>(base);
+        if (header->magic != ringMagic || header->version != ringVersion || header->slots != ringSlots ||
+            header->slotFrames != blockFrames || header->channels == 0 || size != layoutSize(header->channels)) {
+            std::cerr << "Error: shared memory is not a compatible MicroDSP ring\n";
+            return false;
+        }
+        header->consumerPid = ::getpid();
+        return true;
+    }
+
+    int descriptor() const { return fd; }
+    RingHeader& info() { return *header; }
+
+    // Takes over the handshake socket, which tells us when the partner exits
+    void watchPeer(int sock) { peerSocket = sock; }
+
+    // Producer: the next free slot, or null if the consumer died
+    int16_t* acquire() {
+        uint32_t released = header->released.load(std::memory_order_acquire);
+        while (written - released >= ringSlots) {
+            if (!waitForChange(header->released, released, header->producerSleeping, peerSocket)) {
+                std::cerr << "Error: the consumer went away\n";
+                return nullptr;
+            }
+            released = header->released.load(std::memory_order_acquire);
+        }
+        return slot(written);
+    }
+
+    // Producer: hands the slot over (0 frames = end of stream)
+    void publish(uint32_t frames) {
+        header->frames[written % ringSlots] = frames;
+        header->written.store(++written); // Also makes the samples visible to the consumer
+        if (header->consumerSleeping.load()) futexWake(header->written);
+    }
+
+    // Consumer: the next filled slot, or null at the end of the stream
+    const int16_t* next(uint32_t& frames) {
+        frames = 0;
+        uint32_t available = header->written.load(std::memory_order_acquire);
+        while (available == released) {
+            if (!waitForChange(header->written, available, header->consumerSleeping, peerSocket)) {
+                std::cerr << "Error: the producer went away\n";
+                return nullptr;
+            }
+            available = header->written.load(std::memory_order_acquire);
+        }
+        frames = header->frames[released % ringSlots];
+        return frames ? slot(released) : nullptr;
+    }
+
+    // Consumer: gives the slot back
+    void release() {
+        header->released.store(++released);
+        if (header->producerSleeping.load()) futexWake(header->released);
+    }
+
+private:
+    static size_t dataOffset() {
+        const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        return (sizeof(RingHeader) + page - 1) / page * page;
+    }
+
+    static size_t layoutSize(uint32_t channels) {
+        return dataOffset() + static_cast<size_t>(ringSlots) * blockFrames * channels * sizeof(int16_t);
+    }
+
+    bool map() {
+        void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            std::cerr << "Error: could not map shared memory: " << std::strerror(errno) << "\n";
+            return false;
+        }
+        base = static_cast<uint8_t*>(p);
+        return true;
+    }
+
+    int16_t* slot(uint32_t index) {
+        return reinterpret_cast<int16_t*>(base + dataOffset()) + static_cast<size_t>(index % ringSlots) * blockFrames * header->channels;
+    }
+
+    int fd = -1;
+    int peerSocket = -1;
+    uint8_t* base = nullptr;
+    size_t size = 0;
+    RingHeader* header = nullptr;
+    uint32_t written = 0;   // Local copies: each side owns one counter
+    uint32_t released = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Handshake: the memory travels over a Unix socket as a file descriptor
+// ---------------------------------------------------------------------------
+struct HandshakeMessage {
+    uint32_t magic;
+    uint32_t version;
+    int32_t pid;
+};
+
+bool sendRing(int sock, const ShmRing& ring) {
+    HandshakeMessage hello{ringMagic, ringVersion, ::getpid()};
+    iovec iov{&hello, sizeof(hello)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS; // "This message carries file descriptors"
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    const int fd = ring.descriptor();
+    std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    if (::sendmsg(sock, &msg, 0) != static_cast<ssize_t>(sizeof(hello))) {
+        std::cerr << "Error: handshake send failed\n";
+        return false;
+    }
+    return true;
+}
+
+// Returns the received descriptor, or -1
+int receiveRing(int sock) {
+    HandshakeMessage hello{};
+    iovec iov{&hello, sizeof(hello)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (::recvmsg(sock, &msg, 0) != static_cast<ssize_t>(sizeof(hello)) || hello.magic != ringMagic || hello.version != ringVersion) {
+        std::cerr << "Error: handshake failed (not a MicroDSP ring producer, or a different version)\n";
+        return -1;
+    }
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+        std::cerr << "Error: handshake carried no shared memory\n";
+        return -1;
+    }
+    int fd;
+    std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    return fd;
+}
+
+// Producer: create the ring, send it, wait for the consumer to say it's
+// ready. The ring keeps the socket (and closes it), even on failure.
+std::unique_ptr<ShmRing> offerRing(int sock, const StreamFormat& format) {
+    auto ring = std::make_unique<ShmRing>();
+    ring->watchPeer(sock);
+    if (!ring->create(format) || !sendRing(sock, *ring)) return nullptr;
+    HandshakeMessage reply{};
+    if (readUpTo(sock, &reply, sizeof(reply)) != sizeof(reply) || reply.magic != ringMagic) {
+        std::cerr << "Error: consumer did not confirm the handshake\n";
+        return nullptr;
+    }
+    return ring;
+}
+
+// Consumer: receive the ring, map it, confirm. The ring keeps the socket.
+std::unique_ptr<ShmRing> acceptRing(int sock) {
+    auto ring = std::make_unique<ShmRing>();
+    ring->watchPeer(sock);
+    const int fd = receiveRing(sock);
+    if (fd < 0 || !ring->attach(fd)) return nullptr;
+    const HandshakeMessage reply{ringMagic, ringVersion, ::getpid()};
+    if (!writeAll(sock, &reply, sizeof(reply))) return nullptr;
+    return ring;
+}
+
+// ---------------------------------------------------------------------------
+// Transports: the chain stages only see these
+// ---------------------------------------------------------------------------
+class BlockOut {
+public:
+    virtual ~BlockOut() = default;
+    // Space for up to blockFrames frames, or null if the reader went away
+    virtual int16_t* acquire() = 0;
+    virtual bool publish(uint32_t frames) = 0;
+    virtual bool finish() = 0;
+};
+
+class BlockIn {
+public:
+    virtual ~BlockIn() = default;
+    // The next block, or null at the end of the stream
+    virtual const int16_t* next(uint32_t& frames) = 0;
+    virtual void release() = 0;
+};
+
+// Files and pipes are both plain descriptors: a local buffer plus write()/read()
+class FdBlockOut : public BlockOut {
+public:
+    FdBlockOut(int fd, uint32_t channels) : fd(fd), channels(channels), buffer(static_cast<size_t>(blockFrames) * channels) {}
+    int16_t* acquire() override { return buffer.data(); }
+    bool publish(uint32_t frames) override { return writeAll(fd, buffer.data(), static_cast<size_t>(frames) * channels * sizeof(int16_t)); }
+    bool finish() override { return ::close(fd) == 0; }
+
+private:
+    int fd;
+    uint32_t channels;
+    std::vector<int16_t> buffer;
+};
+
+class FdBlockIn : public BlockIn {
+public:
+    FdBlockIn(int fd, uint32_t channels) : fd(fd), channels(channels), buffer(static_cast<size_t>(blockFrames) * channels) {}
+    const int16_t* next(uint32_t& frames) override {
+        const size_t bytes = readUpTo(fd, buffer.data(), buffer.size() * sizeof(int16_t));
+        frames = static_cast<uint32_t>(bytes / (channels * sizeof(int16_t)));
+        return frames ? buffer.data() : nullptr;
+    }
+    void release() override {}
+
+private:
+    int fd;
+    uint32_t channels;
+    std::vector<int16_t> buffer;
+};
+
+class ShmBlockOut : public BlockOut {
+public:
+    explicit ShmBlockOut(ShmRing& ring) : ring(ring) {}
+    int16_t* acquire() override { return ring.acquire(); }
+    bool publish(uint32_t frames) override {
+        ring.publish(frames);
+        return true;
+    }
+    bool finish() override {
+        if (!ring.acquire()) return false;
+        ring.publish(0);
+        return true;
+    }
+
+private:
+    ShmRing& ring;
+};
+
+class ShmBlockIn : public BlockIn {
+public:
+    explicit ShmBlockIn(ShmRing& ring) : ring(ring) {}
+    const int16_t* next(uint32_t& frames) override { return ring.next(frames); }
+    void release() override { ring.release(); }
+
+private:
+    ShmRing& ring;
+};
+
+// ---------------------------------------------------------------------------
+// The two stages of the chain
+// ---------------------------------------------------------------------------
+
+// Stage 1: plays the input `repeats` times through Day 2's gain, writing
+// each block directly into the transport's buffer
+bool runGainStage(const std::vector<int16_t>& input, const StreamFormat& format, uint64_t repeats, double gain, BlockOut& out) {
+    const uint64_t inputFrames = format.totalFrames;
+    const uint64_t total = inputFrames * repeats;
+    uint64_t position = 0;
+    while (position < total) {
+        int16_t* block = out.acquire();
+        if (!block) return false;
+        const uint32_t frames = static_cast<uint32_t>(std::min<uint64_t>(blockFrames, total - position));
+        uint64_t source = position % inputFrames;
+        for (uint32_t n = 0; n < frames; ++n, ++source) {
+            if (source == inputFrames) source = 0; // Loop back to the start of the input
+            for (uint32_t c = 0; c < format.channels; ++c) {
+                double processed = input[source * format.channels + c] * gain;
+                processed = std::min(32767.0, std::max(-32768.0, processed));
+                block[static_cast<size_t>(n) * format.channels + c] = static_cast<int16_t>(processed);
+            }
+        }
+        if (!out.publish(frames)) return false;
+        position += frames;
+    }
+    return out.finish();
+}
+
+// Stage 2: Day 4's delay (circular history), reading each block directly
+// from the transport and writing the result to a WAV file
+bool runDelayStage(BlockIn& in, const StreamFormat& format, const std::string& outPath) {
+    std::ofstream out(outPath, std::ios::binary);
+    if (!out) {
+        std::cerr << "Error: could not create " << outPath << "\n";
+        return false;
+    }
+    const WavHeader header = makeHeader(format);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    const uint32_t channels = format.channels;
+    const uint64_t delay = static_cast<uint64_t>((delayMs / 1000.0f) * format.sampleRate);
+    std::vector<int16_t> history(std::max<uint64_t>(delay, 1) * channels, 0);
+    uint64_t writeIndex = 0;
+    std::vector<int16_t> output(static_cast<size_t>(blockFrames) * channels);
+    uint64_t framesDone = 0;
+
+    uint32_t frames;
+    while (const int16_t* block = in.next(frames)) {
+        for (uint32_t n = 0; n < frames; ++n) {
+            for (uint32_t c = 0; c < channels; ++c) {
+                const int16_t sample = block[static_cast<size_t>(n) * channels + c];
+                const float x = static_cast<float>(sample);
+                const float d = (delay > 0) ? static_cast<float>(history[writeIndex * channels + c]) : x;
+                if (delay > 0) history[writeIndex * channels + c] = sample;
+                const float mix = std::clamp(dry * x + wet * d, -32768.0f, 32767.0f);
+                output[static_cast<size_t>(n) * channels + c] = static_cast<int16_t>(mix);
+            }
+            if (delay > 0 && ++writeIndex == delay) writeIndex = 0;
+        }
+        in.release(); // The slot can be refilled while we write the file
+        out.write(reinterpret_cast<const char*>(output.data()), static_cast<std::streamsize>(static_cast<size_t>(frames) * channels * sizeof(int16_t)));
+        framesDone += frames;
+    }
+    if (framesDone != format.totalFrames) {
+        std::cerr << "Error: stream ended after " << framesDone << " of " << format.totalFrames << " frames\n";
+        return false;
+    }
+    return static_cast<bool>(out);
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark: each stage in its own process
+// ---------------------------------------------------------------------------
+template <typename Fn>
+pid_t spawn(Fn fn) {
+    const pid_t pid = ::fork();
+    if (pid == 0) {
+        const bool ok = fn();
+        std::cout.flush();
+        ::_exit(ok ? 0 : 1);
+    }
+    return pid;
+}
+
+// Reaps the children in whatever order they exit. As soon as one fails the
+// rest are stopped, so a stage never sits waiting for a partner that quit.
+bool waitAll(std::initializer_list<pid_t> pids) {
+    std::vector<pid_t> running;
+    bool ok = true;
+    for (pid_t pid : pids) {
+        if (pid < 0) ok = false;
+        else running.push_back(pid);
+    }
+    bool stopped = false;
+    while (!running.empty()) {
+        if (!ok && !stopped) {
+            for (pid_t pid : running) ::kill(pid, SIGTERM);
+            stopped = true;
+        }
+        int status = 0;
+        const pid_t pid = ::waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        const auto it = std::find(running.begin(), running.end(), pid);
+        if (it == running.end()) continue;
+        running.erase(it);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) ok = false;
+    }
+    return ok;
+}
+
+bool chainOverFiles(const std::vector<int16_t>& input, const StreamFormat& in, const StreamFormat& out, uint64_t repeats, const std::string& outPath) {
+    const std::string tempPath = "shm_ring_temp.raw";
+    // A file can only be read once it is complete, so the stages run one after the other
+    const pid_t first = spawn([&] {
+        const int fd = ::open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return false;
+        FdBlockOut transport(fd, in.channels);
+        return runGainStage(input, in, repeats, chainGain, transport);
+    });
+    if (!waitAll({first})) return false;
+    const pid_t second = spawn([&] {
+        const int fd = ::open(tempPath.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        FdBlockIn transport(fd, in.channels);
+        const bool ok = runDelayStage(transport, out, outPath);
+        ::close(fd);
+        return ok;
+    });
+    const bool ok = waitAll({second});
+    std::filesystem::remove(tempPath);
+    return ok;
+}
+
+bool chainOverPipe(const std::vector<int16_t>& input, const StreamFormat& in, const StreamFormat& out, uint64_t repeats, const std::string& outPath) {
+    int fds[2];
+    if (::pipe(fds) != 0) return false;
+    const pid_t first = spawn([&] {
+        ::close(fds[0]);
+        FdBlockOut transport(fds[1], in.channels);
+        return runGainStage(input, in, repeats, chainGain, transport);
+    });
+    const pid_t second = spawn([&] {
+        ::close(fds[1]);
+        FdBlockIn transport(fds[0], in.channels);
+        return runDelayStage(transport, out, outPath);
+    });
+    ::close(fds[0]);
+    ::close(fds[1]);
+    return waitAll({first, second});
+}
+
+bool chainOverShm(const std::vector<int16_t>& input, const StreamFormat& in, const StreamFormat& out, uint64_t repeats, const std::string& outPath) {
+    int sockets[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) return false;
+    const pid_t first = spawn([&] {
+        ::close(sockets[1]);
+        auto ring = offerRing(sockets[0], out);
+        if (!ring) return false;
+        ShmBlockOut transport(*ring);
+        return runGainStage(input, in, repeats, chainGain, transport);
+    });
+    const pid_t second = spawn([&] {
+        ::close(sockets[0]);
+        auto ring = acceptRing(sockets[1]);
+        if (!ring) return false;
+        ShmBlockIn transport(*ring);
+        return runDelayStage(transport, out, outPath);
+    });
+    ::close(sockets[0]);
+    ::close(sockets[1]);
+    return waitAll({first, second});
+}
+
+bool filesIdentical(const std::string& a, const std::string& b) {
+    std::ifstream fa(a, std::ios::binary), fb(b, std::ios::binary);
+    if (!fa || !fb) return false;
+    std::vector<char> ba(1 << 16), bb(1 << 16);
+    while (fa && fb) {
+        fa.read(ba.data(), static_cast<std::streamsize>(ba.size()));
+        fb.read(bb.data(), static_cast<std::streamsize>(bb.size()));
+        if (fa.gcount() != fb.gcount() || std::memcmp(ba.data(), bb.data(), static_cast<size_t>(fa.gcount())) != 0) return false;
+    }
+    return fa.eof() && fb.eof();
+}
+
+int runBenchmark(uint64_t repeats) {
+    std::vector<int16_t> input;
+    StreamFormat in;
+    if (!readWav("input.wav", input, in)) return 1;
+    if (in.totalFrames == 0) {
+        std::cerr << "Error: input.wav has no audio\n";
+        return 1;
+    }
+    StreamFormat out = in;
+    out.totalFrames = in.totalFrames * repeats;
+    const double megabytes = out.totalFrames * out.channels * 2 / (1024.0 * 1024.0);
+    std::cout << "Chain: gain " << chainGain << " -> delay " << delayMs << " ms, two processes\n";
+    std::cout << "Audio: " << out.totalFrames / static_cast<double>(out.sampleRate) << " s (" << megabytes << " MB between the stages)\n\n";
+
+    struct Transport {
+        const char* name;
+        const char* copies;
+        bool (*run)(const std::vector<int16_t>&, const StreamFormat&, const StreamFormat&, uint64_t, const std::string&);
+        std::string outPath;
+    };
+    const Transport transports[3] = {
+        {"files", "2 copies + disk", chainOverFiles, "output_chain_files.wav"},
+        {"pipes", "2 copies", chainOverPipe, "output_chain_pipes.wav"},
+        {"shm", "0 copies", chainOverShm, "output_chain.wav"},
+    };
+
+    std::cout << "transport   time (ms)    MB/s   per block\n";
+    for (const Transport& t : transports) {
+        std::cout.flush(); // Don't let the children inherit buffered output
+        const auto start = std::chrono::steady_clock::now();
+        if (!t.run(input, in, out, repeats, t.outPath)) {
+            std::cerr << "Error: the " << t.name << " chain failed\n";
+            return 1;
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%-9s %11.1f %7.0f   %s\n", t.name, seconds * 1000.0, megabytes / seconds, t.copies);
+    }
+
+    // All three must have produced the same audio
+    bool same = true;
+    for (int i = 0; i < 2; ++i) {
+        same = same && filesIdentical(transports[i].outPath, transports[2].outPath);
+        std::filesystem::remove(transports[i].outPath);
+    }
+    if (!same) {
+        std::cerr << "FAIL: the transports produced different output\n";
+        return 1;
+    }
+    std::cout << "\nPASS: files, pipes and shm outputs are identical (kept as output_chain.wav)\n";
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Separate programs: "send" listens on a socket path, "recv" connects to it
+// ---------------------------------------------------------------------------
+int runSend(const std::string& socketPath, const std::string& inPath, double gain) {
+    std::vector<int16_t> input;
+    StreamFormat format;
+    if (!readWav(inPath, input, format)) return 1;
+
+    const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Error: socket path is too long\n";
+        return 1;
+    }
+    std::strcpy(address.sun_path, socketPath.c_str());
+    ::unlink(socketPath.c_str());
+    if (listener < 0 || ::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listener, 1) != 0) {
+        std::cerr << "Error: could not listen on " << socketPath << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    std::cout << "Waiting for a receiver on " << socketPath << "...\n";
+    const int sock = ::accept(listener, nullptr, nullptr);
+    ::close(listener);
+    ::unlink(socketPath.c_str());
+    if (sock < 0) return 1;
+
+    auto ring = offerRing(sock, format);
+    if (!ring) return 1;
+    std::cout << "Connected to process " << ring->info().consumerPid << ", streaming " << format.totalFrames << " frames\n";
+    ShmBlockOut transport(*ring);
+    return runGainStage(input, format, 1, gain, transport) ? 0 : 1;
+}
+
+int runReceive(const std::string& socketPath, const std::string& outPath) {
+    const int sock = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Error: socket path is too long\n";
+        return 1;
+    }
+    std::strcpy(address.sun_path, socketPath.c_str());
+    if (sock < 0 || ::connect(sock, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        std::cerr << "Error: could not connect to " << socketPath << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    auto ring = acceptRing(sock);
+    if (!ring) return 1;
+
+    StreamFormat format;
+    format.channels = static_cast<uint16_t>(ring->info().channels);
+    format.sampleRate = ring->info().sampleRate;
+    format.totalFrames = ring->info().totalFrames;
+    ShmBlockIn transport(*ring);
+    if (!runDelayStage(transport, format, outPath)) return 1;
+    std::cout << "Wrote " << outPath << " (" << format.totalFrames << " frames from process " << ring->info().producerPid << ")\n";
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    const std::string mode = (argc > 1) ? argv[1] : "";
+    if (mode == "send" && argc > 2) return runSend(argv[2], (argc > 3) ? argv[3] : "input.wav", (argc > 4) ? std::atof(argv[4]) : chainGain);
+    if (mode == "recv" && argc > 2) return runReceive(argv[2], (argc > 3) ? argv[3] : "output_chain.wav");
+    if (mode == "send" || mode == "recv") {
+        std::cerr << "Usage: shm_ring send sock [in.wav] [gain] | shm_ring recv sock [out.wav]\n";
+        return 1;
+    }
+    const long long repeats = mode.empty() ? 150 : std::atoll(mode.c_str());
+    if (repeats < 1) {
+        std::cerr << "Usage: shm_ring [repeats]\n";
+        return 1;
+    }
+    return runBenchmark(static_cast<uint64_t>(repeats));
+}
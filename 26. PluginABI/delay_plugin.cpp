@@ -0,0 +1,153 @@
+/*
+    MicroDSP - Day 26: Delay Plugin
+
+    What this program does:
+    - Packages Day 4's feedforward delay as a plugin library that any
+      MicroDSP host can load at runtime (see microdsp_plugin.h)
+    - Same math as Day 4: y[n] = dry * x[n] + wet * x[n - D]
+    - Uses a circular history (Day 5) so it works block by block
+
+    Parameters:
+        delay_ms   0 .. 2000 (default 250)
+        dry        0 .. 2    (default 0.8)
+        wet        0 .. 2    (default 0.5)
+
+    Realtime notes:
+    - prepare() allocates the history for the longest delay (2 seconds),
+      so changing delay_ms later never allocates.
+    - Changing delay_ms clears the history, because the old contents no
+      longer line up with the new delay.
+
+    Build:
+        g++ -std=c++17 -O3 -march=native -shared -fPIC -fvisibility=hidden delay_plugin.cpp -o delay_plugin.so
+
+    Author: Jesse Whiting (GhostWire Audio)
+    GitHub: ghostwireaudio
+*/
+
+#include "microdsp_plugin.h"
+
+#include <new>
+#include <vector>
+#include <algorithm>
+
+namespace {
+
+const microdsp_param_info params[] = {
+    {"delay_ms", 0.0f, 2000.0f, 250.0f},
+    {"dry", 0.0f, 2.0f, 0.8f},
+    {"wet", 0.0f, 2.0f, 0.5f},
+};
+
+struct DelayInstance {
+    float delayMs = 250.0f;
+    float dry = 0.8f;
+    float wet = 0.5f;
+    double sampleRate = 44100.0;
+    uint32_t channels = 1;
+    uint64_t delay = 0;             // Delay in frames
+    std::vector<int16_t> history;   // Sized for the longest delay in prepare()
+    uint64_t writeIndex = 0;
+
+    void updateDelay() {
+        // Same conversion as Day 4 (float math, truncated)
+        delay = static_cast<uint64_t>((delayMs / 1000.0f) * static_cast<float>(sampleRate));
+        delay = std::min<uint64_t>(delay, history.size() / std::max(channels, 1u));
+        std::fill(history.begin(), history.end(), 0);
+        writeIndex = 0;
+    }
+};
+
+microdsp_instance* create() {
+    return reinterpret_cast<microdsp_instance*>(new (std::nothrow) DelayInstance());
+}
+
+void destroy(microdsp_instance* instance) {
+    delete reinterpret_cast<DelayInstance*>(instance);
+}
+
+int32_t prepare(microdsp_instance* instance, double sampleRate, uint32_t channels, uint32_t) {
+    DelayInstance* d = reinterpret_cast<DelayInstance*>(instance);
+    d->sampleRate = sampleRate;
+    d->channels = channels;
+    const uint64_t maxDelay = static_cast<uint64_t>((params[0].max_value / 1000.0f) * static_cast<float>(sampleRate));
+    try {
+        d->history.assign(std::max<uint64_t>(maxDelay, 1) * channels, 0);
+    } catch (...) {
+        return 1; // Out of memory: no exceptions across the ABI
+    }
+    d->updateDelay();
+    return 0;
+}
+
+void process(microdsp_instance* instance, const int16_t* in, int16_t* out, uint32_t frames) {
+    DelayInstance* d = reinterpret_cast<DelayInstance*>(instance);
+    const uint32_t channels = d->channels;
+    const uint64_t delay = d->delay;
+    int16_t* history = d->history.data();
+    uint64_t writeIndex = d->writeIndex;
+    for (uint32_t n = 0; n < frames; ++n) {
+        for (uint32_t c = 0; c < channels; ++c) {
+            const int16_t sample = in[n * channels + c];
+            const float x = static_cast<float>(sample);
+            // The oldest entry in the ring is exactly D frames ago
+            // (zero until the ring has filled, like Day 4's n < D case)
+            const float delayed = (delay > 0) ? static_cast<float>(history[writeIndex * channels + c]) : x;
+            if (delay > 0) history[writeIndex * channels + c] = sample;
+            const float mix = std::clamp(d->dry * x + d->wet * delayed, -32768.0f, 32767.0f);
+            out[n * channels + c] = static_cast<int16_t>(mix);
+        }
+        if (delay > 0 && ++writeIndex == delay) writeIndex = 0;
+    }
+    d->writeIndex = writeIndex;
+}
+
+void reset(microdsp_instance* instance) {
+    DelayInstance* d = reinterpret_cast<DelayInstance*>(instance);
+    std::fill(d->history.begin(), d->history.end(), 0);
+    d->writeIndex = 0;
+}
+
+int32_t setParam(microdsp_instance* instance, uint32_t index, float value) {
+    DelayInstance* d = reinterpret_cast<DelayInstance*>(instance);
+    if (index >= sizeof(params) / sizeof(params[0])) return 1;
+    value = std::clamp(value, params[index].min_value, params[index].max_value);
+    if (index == 0) {
+        d->delayMs = value;
+        d->updateDelay();
+    } else if (index == 1) {
+        d->dry = value;
+    } else {
+        d->wet = value;
+    }
+    return 0;
+}
+
+uint32_t latency(const microdsp_instance*) { return 0; } // The dry signal comes through immediately
+
+uint64_t tail(const microdsp_instance* instance) {
+    return reinterpret_cast<const DelayInstance*>(instance)->delay; // The last echo ends D frames later
+}
+
+const microdsp_plugin descriptor = {
+    MICRODSP_PLUGIN_API_VERSION,
+    sizeof(microdsp_plugin),
+    "ghostwire.delay",
+    "Delay",
+    3,
+    params,
+    create,
+    destroy,
+    prepare,
+    process,
+    reset,
+    setParam,
+    latency,
+    tail,
+};
+
+} // namespace
+
+extern "C" MICRODSP_EXPORT const microdsp_plugin* microdsp_get_plugin(uint32_t host_api_version) {
+    return (host_api_version == MICRODSP_PLUGIN_API_VERSION) ? &descriptor : nullptr;
+}
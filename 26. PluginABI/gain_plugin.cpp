@@ -0,0 +1,91 @@
+/*
+    MicroDSP - Day 26: Gain Plugin
+
+    What this program does:
+    - Packages Day 2's gain as a plugin library that any MicroDSP host can
+      load at runtime (see microdsp_plugin.h)
+    - Same math as Day 2: scale, clamp to 16 bits, truncate toward zero
+
+    Parameters:
+        gain    0 .. 4 (default 0.5)
+
+    Build:
+        g++ -std=c++17 -O3 -march=native -shared -fPIC -fvisibility=hidden gain_plugin.cpp -o gain_plugin.so
+
+    Author: Jesse Whiting (GhostWire Audio)
+    GitHub: ghostwireaudio
+*/
+
+#include "microdsp_plugin.h"
+
+#include <new>
+#include <algorithm>
+
+namespace {
+
+struct GainInstance {
+    float gain = 0.5f;
+    uint32_t channels = 1;
+};
+
+const microdsp_param_info params[] = {
+    {"gain", 0.0f, 4.0f, 0.5f},
+};
+
+microdsp_instance* create() {
+    return reinterpret_cast<microdsp_instance*>(new (std::nothrow) GainInstance());
+}
+
+void destroy(microdsp_instance* instance) {
+    delete reinterpret_cast<GainInstance*>(instance);
+}
+
+int32_t prepare(microdsp_instance* instance, double, uint32_t channels, uint32_t) {
+    reinterpret_cast<GainInstance*>(instance)->channels = channels;
+    return 0; // Nothing to allocate
+}
+
+void process(microdsp_instance* instance, const int16_t* in, int16_t* out, uint32_t frames) {
+    const GainInstance* g = reinterpret_cast<const GainInstance*>(instance);
+    const double gain = g->gain;
+    const uint32_t count = frames * g->channels;
+    for (uint32_t i = 0; i < count; ++i) {
+        double processed = in[i] * gain;
+        processed = std::min(32767.0, std::max(-32768.0, processed));
+        out[i] = static_cast<int16_t>(processed);
+    }
+}
+
+void reset(microdsp_instance*) {} // No state
+
+int32_t setParam(microdsp_instance* instance, uint32_t index, float value) {
+    if (index != 0) return 1;
+    reinterpret_cast<GainInstance*>(instance)->gain = std::clamp(value, params[0].min_value, params[0].max_value);
+    return 0;
+}
+
+uint32_t latency(const microdsp_instance*) { return 0; }
+uint64_t tail(const microdsp_instance*) { return 0; }
+
+const microdsp_plugin descriptor = {
+    MICRODSP_PLUGIN_API_VERSION,
+    sizeof(microdsp_plugin),
+    "ghostwire.gain",
+    "Gain",
+    1,
+    params,
+    create,
+    destroy,
+    prepare,
+    process,
+    reset,
+    setParam,
+    latency,
+    tail,
+};
+
+} // namespace
+
+extern "C" MICRODSP_EXPORT const microdsp_plugin* microdsp_get_plugin(uint32_t host_api_version) {
+    return (host_api_version == MICRODSP_PLUGIN_API_VERSION) ? &descriptor : nullptr;
+}
@@ -0,0 +1,114 @@
+/*
+    MicroDSP - Day 26: Processor Plugin ABI
+
+    The contract between a MicroDSP host and a processor loaded at runtime
+    from a shared library (.so / .dylib / .dll).
+
+    Why a C interface:
+    - C++ classes don't have a stable binary layout across compilers,
+      compiler versions or standard libraries. Plain C structs, function
+      pointers and fixed-size integer types do, so a plugin built with one
+      toolchain works with a host built with another.
+    - Nothing C++ crosses the boundary: no exceptions, no std::string, no
+      std::vector, no new/delete across the line. Each side frees what it
+      allocates.
+
+    How a host uses a plugin:
+        lib = dlopen("gain_plugin.so")
+        desc = microdsp_get_plugin(MICRODSP_PLUGIN_API_VERSION)
+        inst = desc->create()
+        desc->set_param(inst, index, value)     any time, realtime-safe
+        desc->prepare(inst, rate, channels, maxBlock)   allocates here
+        loop: desc->process(inst, in, out, frames)      never allocates
+        desc->reset(inst)                       clear state, e.g. after seeking
+        desc->destroy(inst)
+
+    Audio format:
+    - Interleaved 16-bit PCM, the same as every MicroDSP processor and WAV
+      file: frame n, channel c is at in[n * channels + c].
+    - `in` and `out` may point to the same buffer (in-place processing).
+    - `frames` is never more than the max_block_frames given to prepare().
+
+    Realtime rules for plugins:
+    - process(), reset(), set_param(), latency() and tail() must not
+      allocate, lock, block or do I/O. Anything that needs memory does it in
+      prepare().
+    - No exceptions may escape any function.
+
+    Versioning:
+    - The host passes the API version it was built against. A plugin
+      returns NULL if it can't serve that version.
+    - struct_size lets newer hosts detect older, shorter descriptor structs
+      if fields are ever added at the end.
+
+    Author: Jesse Whiting (GhostWire Audio)
+    GitHub: ghostwireaudio
+*/
+
+#ifndef MICRODSP_PLUGIN_H
+#define MICRODSP_PLUGIN_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MICRODSP_PLUGIN_API_VERSION 1
+
+#if defined(_WIN32)
+#define MICRODSP_EXPORT __declspec(dllexport)
+#else
+#define MICRODSP_EXPORT __attribute__((visibility("default")))
+#endif
+
+// Opaque per-instance state, owned by the plugin
+typedef struct microdsp_instance microdsp_instance;
+
+typedef struct microdsp_param_info {
+    const char* name;          // e.g. "gain", used by hosts to look parameters up
+    float min_value;
+    float max_value;
+    float default_value;
+} microdsp_param_info;
+
+typedef struct microdsp_plugin {
+    uint32_t api_version;      // MICRODSP_PLUGIN_API_VERSION the plugin was built with
+    uint32_t struct_size;      // sizeof(microdsp_plugin) in the plugin's build
+    const char* id;            // Unique, e.g. "ghostwire.gain"
+    const char* name;          // For display
+    uint32_t num_params;
+    const microdsp_param_info* params;
+
+    // Returns NULL on failure (out of memory)
+    microdsp_instance* (*create)(void);
+    void (*destroy)(microdsp_instance* instance);
+
+    // Allocates everything process() will need. Returns 0 on success.
+    int32_t (*prepare)(microdsp_instance* instance, double sample_rate, uint32_t channels, uint32_t max_block_frames);
+
+    void (*process)(microdsp_instance* instance, const int16_t* in, int16_t* out, uint32_t frames);
+
+    // Clears internal state (delay lines, envelopes) back to silence
+    void (*reset)(microdsp_instance* instance);
+
+    // Values outside [min_value, max_value] are clamped. Returns 0 on success,
+    // nonzero for an unknown index.
+    int32_t (*set_param)(microdsp_instance* instance, uint32_t index, float value);
+
+    // Frames by which the output lags the input
+    uint32_t (*latency)(const microdsp_instance* instance);
+
+    // Frames of output that can still be nonzero after the input goes silent
+    uint64_t (*tail)(const microdsp_instance* instance);
+} microdsp_plugin;
+
+// The one symbol every plugin library exports
+typedef const microdsp_plugin* (*microdsp_get_plugin_fn)(uint32_t host_api_version);
+MICRODSP_EXPORT const microdsp_plugin* microdsp_get_plugin(uint32_t host_api_version);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MICRODSP_PLUGIN_H
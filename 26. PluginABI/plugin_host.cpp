@@ -0,0 +1,451 @@
+/*
+    MicroDSP - Day 26: Plugin Host
+
+    What this program does:
+    - Loads processor plugins from shared libraries at runtime (dlopen), so
+      a new effect no longer needs its own main() in its own directory
+    - Runs a chain of plugins over a WAV file, block by block, with the
+      same allocation-free contract as the built-in processors
+    - Checks the plugin chain against the built-in gain and delay compiled
+      into this program: the output must be identical
+    - Measures what the plugin boundary costs per block
+
+    Usage:
+        plugin_host in.wav out.wav plugin[:name=value,...] ... [--tail]
+            e.g. plugin_host in.wav out.wav ./gain_plugin.so:gain=0.7 ./delay_plugin.so:delay_ms=300,wet=0.4
+            --tail keeps rendering after the input ends until the echoes die out
+    With no arguments it runs ./gain_plugin.so (gain 0.5) into
+    ./delay_plugin.so (Day 4 settings) over input.wav, writes
+    output_plugins.wav, checks it and runs the benchmark.
+
+    The plugin contract (see microdsp_plugin.h):
+    - A plain C struct of function pointers, returned by the one exported
+      function microdsp_get_plugin(). C has a stable binary interface, so
+      plugins and hosts built with different compilers still fit together.
+    - prepare() allocates, process() never does. latency() and tail() tell
+      the host how the output lines up with the input and how long it rings.
+
+    What a plugin call costs:
+    - Calling through a function pointer in another library is an
+      "indirect call": the CPU can't inline it, and it has to jump to an
+      address it reads from memory. That costs a few nanoseconds.
+    - Processing a block of 4096 frames takes microseconds, so the call is
+      a tiny fraction of the work. The benchmark measures both.
+
+    Build:
+        g++ -std=c++17 -O3 -march=native -shared -fPIC -fvisibility=hidden gain_plugin.cpp -o gain_plugin.so
+        g++ -std=c++17 -O3 -march=native -shared -fPIC -fvisibility=hidden delay_plugin.cpp -o delay_plugin.so
+        g++ -std=c++17 -O3 -march=native plugin_host.cpp -o plugin_host -ldl
+
+    Author: Jesse Whiting (GhostWire Audio)
+    GitHub: ghostwireaudio
+*/
+
+#include "microdsp_plugin.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+#include <chrono>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+// Force the compiler to pack the struct exactly as written
+// with no padding bytes added for alignment, which ensures
+// sizeof(WavHeader) == 44 bytes
+#pragma pack(push, 1)
+struct WavHeader {
+    // RIFF Chunk Descriptor
+    char     riff[4];        // "RIFF"
+    uint32_t chunkSize;      // 36 + Subchunk2Size
+    char     wave[4];        // "WAVE"
+
+    // fmt subchunk
+    char     fmt[4];         // "fmt "
+    uint32_t subchunk1Size;  // 16 for PCM
+    uint16_t audioFormat;    // 1 for PCM
+    uint16_t numChannels;    // 1 for mono
+    uint32_t sampleRate;     // e.g., 44100
+    uint32_t byteRate;       // sampleRate * numChannels * bitsPerSample/8
+    uint16_t blockAlign;     // numChannels * bitsPerSample/8
+    uint16_t bitsPerSample;  // 16
+
+    // data subchunk
+    char     data[4];        // "data"
+    uint32_t subchunk2Size;  // NumSamples * numChannels * bitsPerSample/8
+};
+#pragma pack(pop)
+
+const uint32_t blockFrames = 4096;
+
+#if defined(_WIN32)
+const char* pluginExtension = ".dll";
+#elif defined(__APPLE__)
+const char* pluginExtension = ".dylib";
+#else
+const char* pluginExtension = ".so";
+#endif
+
+// ---------------------------------------------------------------------------
+// Loading a plugin library
+// ---------------------------------------------------------------------------
+class PluginLibrary {
+public:
+    ~PluginLibrary() {
+#ifdef _WIN32
+        if (handle) FreeLibrary(static_cast<HMODULE>(handle));
+#else
+        if (handle) dlclose(handle);
+#endif
+    }
+
+    bool load(const std::string& path) {
+#ifdef _WIN32
+        handle = LoadLibraryA(path.c_str());
+        if (!handle) {
+            std::cerr << "Error: could not load " << path << "\n";
+            return false;
+        }
+        auto entry = reinterpret_cast<microdsp_get_plugin_fn>(GetProcAddress(static_cast<HMODULE>(handle), "microdsp_get_plugin"));
+#else
+        // RTLD_LOCAL: plugins can't see each other's symbols, so two plugins
+        // with a helper function of the same name don't clash
+        handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (!handle) {
+            std::cerr << "Error: could not load " << path << ": " << dlerror() << "\n";
+            return false;
+        }
+        auto entry = reinterpret_cast<microdsp_get_plugin_fn>(dlsym(handle, "microdsp_get_plugin"));
+#endif
+        if (!entry) {
+            std::cerr << "Error: " << path << " is not a MicroDSP plugin (no microdsp_get_plugin)\n";
+            return false;
+        }
+        descriptor = entry(MICRODSP_PLUGIN_API_VERSION);
+        if (!descriptor || descriptor->api_version != MICRODSP_PLUGIN_API_VERSION || descriptor->struct_size < sizeof(microdsp_plugin)) {
+            std::cerr << "Error: " << path << " was built for a different plugin API version\n";
+            return false;
+        }
+        return true;
+    }
+
+    const microdsp_plugin* descriptor = nullptr;
+
+private:
+    void* handle = nullptr;
+};
+
+// One instance of a loaded plugin. Keeps its library alive.
+class PluginProcessor {
+public:
+    PluginProcessor(std::shared_ptr<PluginLibrary> library, microdsp_instance* instance)
+        : library(std::move(library)), instance(instance) {}
+
+    ~PluginProcessor() {
+        if (instance) plugin().destroy(instance);
+    }
+
+    PluginProcessor(const PluginProcessor&) = delete;
+    PluginProcessor& operator=(const PluginProcessor&) = delete;
+
+    const microdsp_plugin& plugin() const { return *library->descriptor; }
+
+    bool setParam(const std::string& name, float value) {
+        for (uint32_t i = 0; i < plugin().num_params; ++i) {
+            if (name == plugin().params[i].name) return plugin().set_param(instance, i, value) == 0;
+        }
+        std::cerr << "Error: " << plugin().name << " has no parameter '" << name << "'\n";
+        return false;
+    }
+
+    bool prepare(double sampleRate, uint32_t channels, uint32_t maxBlock) {
+        if (plugin().prepare(instance, sampleRate, channels, maxBlock) != 0) {
+            std::cerr << "Error: " << plugin().name << " failed to prepare\n";
+            return false;
+        }
+        return true;
+    }
+
+    void process(const int16_t* in, int16_t* out, uint32_t frames) { plugin().process(instance, in, out, frames); }
+    void reset() { plugin().reset(instance); }
+    uint32_t latency() const { return plugin().latency(instance); }
+    uint64_t tail() const { return plugin().tail(instance); }
+
+private:
+    std::shared_ptr<PluginLibrary> library;
+    microdsp_instance* instance;
+};
+
+// Parses "path[:name=value,name=value]" and creates the instance
+std::unique_ptr<PluginProcessor> loadPlugin(const std::string& spec) {
+    const size_t slash = spec.find_last_of("/\\"); // A ':' before the file name is part of the path
+    const size_t colon = spec.find(':', slash == std::string::npos ? 0 : slash);
+    const std::string path = spec.substr(0, colon);
+    auto library = std::make_shared<PluginLibrary>();
+    if (!library->load(path)) return nullptr;
+    microdsp_instance* instance = library->descriptor->create();
+    if (!instance) {
+        std::cerr << "Error: " << library->descriptor->name << " could not create an instance\n";
+        return nullptr;
+    }
+    auto processor = std::make_unique<PluginProcessor>(library, instance);
+
+    std::string settings = (colon == std::string::npos) ? "" : spec.substr(colon + 1);
+    while (!settings.empty()) {
+        const size_t comma = settings.find(',');
+        const std::string setting = settings.substr(0, comma);
+        settings = (comma == std::string::npos) ? "" : settings.substr(comma + 1);
+        const size_t equals = setting.find('=');
+        if (equals == std::string::npos) {
+            std::cerr << "Error: expected name=value, got '" << setting << "'\n";
+            return nullptr;
+        }
+        if (!processor->setParam(setting.substr(0, equals), static_cast<float>(std::atof(setting.c_str() + equals + 1)))) return nullptr;
+    }
+    return processor;
+}
+
+// ---------------------------------------------------------------------------
+// Built-in reference processors (the code the plugins were made from)
+// ---------------------------------------------------------------------------
+struct BuiltinGain {
+    double gain = 0.5;
+
+    void process(const int16_t* in, int16_t* out, uint32_t count) const {
+        for (uint32_t i = 0; i < count; ++i) {
+            double processed = in[i] * gain;
+            processed = std::min(32767.0, std::max(-32768.0, processed));
+            out[i] = static_cast<int16_t>(processed);
+        }
+    }
+};
+
+struct BuiltinDelay {
+    float dry = 0.8f;
+    float wet = 0.5f;
+    uint32_t channels = 1;
+    uint64_t delay = 0;
+    std::vector<int16_t> history;
+    uint64_t writeIndex = 0;
+
+    void prepare(uint32_t sampleRate, uint32_t numChannels, float delayMs) {
+        channels = numChannels;
+        delay = static_cast<uint64_t>((delayMs / 1000.0f) * sampleRate);
+        history.assign(std::max<uint64_t>(delay, 1) * channels, 0);
+        writeIndex = 0;
+    }
+
+    void process(const int16_t* in, int16_t* out, uint32_t frames) {
+        for (uint32_t n = 0; n < frames; ++n) {
+            for (uint32_t c = 0; c < channels; ++c) {
+                const int16_t sample = in[n * channels + c];
+                const float x = static_cast<float>(sample);
+                const float d = (delay > 0) ? static_cast<float>(history[writeIndex * channels + c]) : x;
+                if (delay > 0) history[writeIndex * channels + c] = sample;
+                const float mix = std::clamp(dry * x + wet * d, -32768.0f, 32767.0f);
+                out[n * channels + c] = static_cast<int16_t>(mix);
+            }
+            if (delay > 0 && ++writeIndex == delay) writeIndex = 0;
+        }
+    }
+};
+
+// ---------------------------------------------------------------------------
+// WAV in and out
+// ---------------------------------------------------------------------------
+bool readWav(const std::string& path, WavHeader& header, std::vector<int16_t>& samples) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cerr << "Error: could not open " << path << "\n";
+        return false;
+    }
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || std::strncmp(header.riff, "RIFF", 4) != 0 || std::strncmp(header.wave, "WAVE", 4) != 0) {
+        std::cerr << "Error: " << path << " is not a valid WAV file\n";
+        return false;
+    }
+    if (header.audioFormat != 1 || header.bitsPerSample != 16) {
+        std::cerr << "Error: only 16-bit PCM WAV is supported\n";
+        return false;
+    }
+    samples.resize(header.subchunk2Size / 2);
+    in.read(reinterpret_cast<char*>(samples.data()), static_cast<std::streamsize>(samples.size() * 2));
+    samples.resize(static_cast<size_t>(in.gcount()) / 2);
+    return true;
+}
+
+bool writeWav(const std::string& path, WavHeader header, const std::vector<int16_t>& samples) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        std::cerr << "Error: could not create " << path << "\n";
+        return false;
+    }
+    header.subchunk2Size = static_cast<uint32_t>(samples.size() * 2);
+    header.chunkSize = 36 + header.subchunk2Size;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(samples.data()), static_cast<std::streamsize>(samples.size() * 2));
+    return static_cast<bool>(out);
+}
+
+// Runs the chain over the input in blocks, in place. With includeTail the
+// output is extended by the longest tail so the echoes can finish.
+std::vector<int16_t> renderChain(std::vector<std::unique_ptr<PluginProcessor>>& chain, const WavHeader& header,
+                                 const std::vector<int16_t>& input, bool includeTail) {
+    const uint32_t channels = header.numChannels;
+    uint64_t tail = 0;
+    for (auto& p : chain) tail = includeTail ? tail + p->tail() : 0; // Tails add up along a chain
+    std::vector<int16_t> output(input);
+    output.resize(input.size() + tail * channels, 0); // Silence in, echoes out
+    const uint64_t frames = output.size() / channels;
+    for (uint64_t start = 0; start < frames; start += blockFrames) {
+        const uint32_t n = static_cast<uint32_t>(std::min<uint64_t>(blockFrames, frames - start));
+        int16_t* block = output.data() + start * channels;
+        for (auto& p : chain) p->process(block, block, n);
+    }
+    return output;
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark: plugin calls vs the same code built into the host
+// ---------------------------------------------------------------------------
+template <typename Fn>
+double bestSeconds(Fn fn) {
+    double best = 1e30;
+    for (int run = 0; run < 5; ++run) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+void runBenchmark(PluginProcessor& gain, PluginProcessor& delay, const WavHeader& header, const std::vector<int16_t>& input) {
+    const uint32_t channels = header.numChannels;
+    const uint64_t totalFrames = 1 << 22; // About 95 s at 44.1 kHz per run
+    std::vector<int16_t> source(totalFrames * channels);
+    for (size_t i = 0; i < source.size(); ++i) source[i] = input[i % input.size()];
+    std::vector<int16_t> buffer(source.size());
+
+    BuiltinGain builtinGain;
+    BuiltinDelay builtinDelay;
+
+    // The pure cost of crossing the boundary: calls that process nothing
+    const uint64_t emptyCalls = 10000000;
+    int16_t dummy = 0;
+    const double empty = bestSeconds([&] {
+        for (uint64_t i = 0; i < emptyCalls; ++i) gain.process(&dummy, &dummy, 0);
+    });
+    const double callNs = empty * 1e9 / emptyCalls;
+
+    std::cout << "\nBenchmark: gain -> delay over " << totalFrames << " frames\n";
+    std::cout << "Empty plugin call: " << callNs << " ns\n\n";
+    std::cout << "block   built-in ns/frame   plugin ns/frame   call cost share\n";
+    for (uint32_t block : {16u, 64u, 256u, 1024u, 4096u}) {
+        gain.prepare(header.sampleRate, channels, block);
+        delay.prepare(header.sampleRate, channels, block);
+        builtinDelay.prepare(header.sampleRate, channels, 250.0f);
+
+        const double builtin = bestSeconds([&] {
+            std::copy(source.begin(), source.end(), buffer.begin());
+            for (uint64_t start = 0; start < totalFrames; start += block) {
+                int16_t* p = buffer.data() + start * channels;
+                builtinGain.process(p, p, block * channels);
+                builtinDelay.process(p, p, block);
+            }
+        });
+        const double plugin = bestSeconds([&] {
+            std::copy(source.begin(), source.end(), buffer.begin());
+            for (uint64_t start = 0; start < totalFrames; start += block) {
+                int16_t* p = buffer.data() + start * channels;
+                gain.process(p, p, block);
+                delay.process(p, p, block);
+            }
+        });
+        // Two boundary crossings per block, as a share of the plugin chain's time per block
+        const double blockNs = plugin * 1e9 / (totalFrames / block);
+        std::printf("%5u %19.3f %17.3f %16.3f%%\n", block, builtin * 1e9 / totalFrames, plugin * 1e9 / totalFrames,
+                    100.0 * 2.0 * callNs / blockNs);
+    }
+    std::cout << "(Built-in and plugin times differ by a few percent either way: they are the\n"
+                 " same code, but compiled separately and optimized slightly differently.)\n";
+}
+
+int main(int argc, char* argv[]) {
+    bool includeTail = false;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--tail") includeTail = true;
+        else args.push_back(argv[i]);
+    }
+
+    if (!args.empty()) {
+        if (args.size() < 3) {
+            std::cerr << "Usage: plugin_host in.wav out.wav plugin[:name=value,...] ... [--tail]\n";
+            return 1;
+        }
+        WavHeader header;
+        std::vector<int16_t> input;
+        if (!readWav(args[0], header, input)) return 1;
+        std::vector<std::unique_ptr<PluginProcessor>> chain;
+        for (size_t i = 2; i < args.size(); ++i) {
+            auto p = loadPlugin(args[i]);
+            if (!p || !p->prepare(header.sampleRate, header.numChannels, blockFrames)) return 1;
+            std::cout << p->plugin().name << " (" << p->plugin().id << "): latency " << p->latency() << ", tail " << p->tail() << " frames\n";
+            chain.push_back(std::move(p));
+        }
+        if (!writeWav(args[1], header, renderChain(chain, header, input, includeTail))) return 1;
+        std::cout << "Wrote " << args[1] << "\n";
+        return 0;
+    }
+
+    // Demo: Day 2's gain into Day 4's delay, as plugins
+    WavHeader header;
+    std::vector<int16_t> input;
+    if (!readWav("input.wav", header, input)) return 1;
+    if (input.empty()) {
+        std::cerr << "Error: input.wav has no audio\n";
+        return 1;
+    }
+    auto gain = loadPlugin(std::string("./gain_plugin") + pluginExtension + ":gain=0.5");
+    auto delay = loadPlugin(std::string("./delay_plugin") + pluginExtension);
+    if (!gain || !delay) return 1;
+    if (!gain->prepare(header.sampleRate, header.numChannels, blockFrames) || !delay->prepare(header.sampleRate, header.numChannels, blockFrames)) return 1;
+    for (const PluginProcessor* p : {gain.get(), delay.get()}) {
+        std::cout << "Loaded " << p->plugin().name << " (" << p->plugin().id << "): latency " << p->latency() << ", tail " << p->tail() << " frames\n";
+    }
+
+    std::vector<std::unique_ptr<PluginProcessor>> chain;
+    chain.push_back(std::move(gain));
+    chain.push_back(std::move(delay));
+    const std::vector<int16_t> output = renderChain(chain, header, input, false);
+    if (!writeWav("output_plugins.wav", header, output)) return 1;
+
+    // The same chain with the built-in processors
+    std::vector<int16_t> reference(input.size());
+    BuiltinGain builtinGain;
+    BuiltinDelay builtinDelay;
+    builtinDelay.prepare(header.sampleRate, header.numChannels, 250.0f);
+    builtinGain.process(input.data(), reference.data(), static_cast<uint32_t>(input.size()));
+    builtinDelay.process(reference.data(), reference.data(), static_cast<uint32_t>(input.size() / header.numChannels));
+    if (output != reference) {
+        std::cerr << "FAIL: plugin chain output differs from the built-in chain\n";
+        return 1;
+    }
+    std::cout << "PASS: output_plugins.wav matches the built-in gain -> delay chain\n";
+
+    for (auto& p : chain) p->reset();
+    runBenchmark(*chain[0], *chain[1], header, input);
+    return 0;
+}
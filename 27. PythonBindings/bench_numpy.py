@@ -0,0 +1,196 @@
+"""
+    MicroDSP - Day 27: microdsp vs NumPy
+
+    What this script does:
+    - Checks that every microdsp function gives exactly the same samples as
+      a pure-NumPy version of the same math
+    - Times both on one minute of audio (input.wav repeated)
+    - Times a plain Python loop of the Day 5 circular buffer, the way it
+      looks before anyone vectorises it
+    - Runs the same work on several Python threads at once to show that
+      microdsp releases the GIL (the speedup needs more than one core)
+
+    Usage:
+        python3 bench_numpy.py [input.wav]
+    (build microdsp first, see microdsp_python.cpp)
+
+    Author: Jesse Whiting (GhostWire Audio)
+    GitHub: ghostwireaudio
+"""
+
+import os
+import sys
+import time
+import threading
+
+import numpy as np
+import microdsp
+
+
+def read_wav(path):
+    # Same 44-byte header as every MicroDSP program
+    with open(path, "rb") as f:
+        header = f.read(44)
+        channels = int.from_bytes(header[22:24], "little")
+        rate = int.from_bytes(header[24:28], "little")
+        samples = np.frombuffer(f.read(), dtype=np.int16)
+    return samples, rate, channels
+
+
+# ---------------------------------------------------------------------------
+# Pure-NumPy versions of the same processors
+# ---------------------------------------------------------------------------
+def np_gain(x, gain):
+    return np.clip(x * gain, -32768.0, 32767.0).astype(np.int16)  # astype truncates like static_cast
+
+
+def np_bypass_fade(x, rate, gain=2.0, dry_until=1.0, fade_ms=10.0, channels=1):
+    frames = len(x) // channels
+    fade_start = int(rate * dry_until)
+    fade_frames = max(1, int(rate * (fade_ms / 1000.0)))
+    n = np.arange(frames, dtype=np.float64)
+    mix = np.clip((n - fade_start) / fade_frames, 0.0, 1.0)
+    dry = x.reshape(frames, channels).astype(np.float64)
+    mixed = (1.0 - mix)[:, None] * dry + mix[:, None] * dry * gain
+    return np.clip(mixed, -32768.0, 32767.0).astype(np.int16).reshape(-1)
+
+
+def np_delay(x, rate, delay_ms=250.0, dry=0.8, wet=0.5, channels=1):
+    d = int(np.float32(delay_ms) / np.float32(1000.0) * np.float32(rate)) * channels
+    xf = x.astype(np.float32)
+    delayed = np.zeros_like(xf)
+    if d == 0:
+        delayed[:] = xf
+    elif d < len(xf):
+        delayed[d:] = xf[:-d]
+    y = np.float32(dry) * xf + np.float32(wet) * delayed
+    return np.clip(y, -32768.0, 32767.0).astype(np.int16)
+
+
+def np_int16_to_float(x):
+    return x.astype(np.float32) * np.float32(1.0 / 32768.0)
+
+
+def np_float_to_int16(f):
+    return np.rint(np.clip(f * np.float32(32768.0), -32768.0, 32767.0)).astype(np.int16)
+
+
+def python_loop_delay(x, rate, delay_ms=250.0, dry=0.8, wet=0.5):
+    # circular_buffers.cpp written out in Python, one sample at a time
+    d = int(delay_ms / 1000.0 * rate)
+    history = [0] * d
+    write = 0
+    out = [0] * len(x)
+    for n, sample in enumerate(x):
+        delayed = history[write]
+        history[write] = sample
+        write = (write + 1) % d
+        out[n] = int(max(-32768.0, min(32767.0, dry * sample + wet * delayed)))
+    return out
+
+
+def best_of(fn, repeats=5):
+    best = float("inf")
+    for _ in range(repeats):
+        start = time.perf_counter()
+        fn()
+        best = min(best, time.perf_counter() - start)
+    return best
+
+
+def main():
+    path = sys.argv[1] if len(sys.argv) > 1 else "input.wav"
+    x, rate, channels = read_wav(path)
+    seconds = 60
+    reps = max(1, (rate * channels * seconds) // len(x))
+    x = np.tile(x, reps)
+    audio_seconds = len(x) / channels / rate
+    print(f"{path}: {rate} Hz, {channels} ch, tiled to {audio_seconds:.0f} s ({len(x)} samples)\n")
+
+    # -----------------------------------------------------------------------
+    # 1. Same output, sample for sample
+    # -----------------------------------------------------------------------
+    f = np_int16_to_float(x)
+    checks = [
+        ("gain", np.asarray(microdsp.gain(x, 0.5)), np_gain(x, 0.5)),
+        ("bypass_fade", np.asarray(microdsp.bypass_fade(x, rate, channels=channels)),
+         np_bypass_fade(x, rate, channels=channels)),
+        ("delay", np.asarray(microdsp.delay(x, rate, channels=channels)), np_delay(x, rate, channels=channels)),
+        ("int16_to_float", np.asarray(microdsp.int16_to_float(x)), f),
+        ("float_to_int16", np.asarray(microdsp.float_to_int16(f)), np_float_to_int16(f)),
+    ]
+    ok = True
+    for name, ours, theirs in checks:
+        same = ours.dtype == theirs.dtype and np.array_equal(ours, theirs)
+        ok = ok and same
+        print(f"  {name:<15} {'identical' if same else 'MISMATCH'}")
+    if not ok:
+        print("Error: microdsp and NumPy disagree")
+        return 1
+
+    # Feeding a Delay object block by block, in place, matches one big call
+    blocks = x.copy()
+    d = microdsp.Delay(rate, channels=channels)
+    for block in np.array_split(blocks, len(blocks) // (512 * channels)):
+        d.process(block, out=block)
+    print(f"  {'Delay blocks':<15} {'identical' if np.array_equal(blocks, checks[2][1]) else 'MISMATCH'}\n")
+
+    # -----------------------------------------------------------------------
+    # 2. Speed: microdsp (new buffer and out=) vs NumPy
+    # -----------------------------------------------------------------------
+    out16 = np.empty_like(x)
+    out32 = np.empty(len(x), dtype=np.float32)
+    rows = [
+        ("gain", lambda: microdsp.gain(x, 0.5), lambda: microdsp.gain(x, 0.5, out=out16), lambda: np_gain(x, 0.5)),
+        ("bypass_fade", lambda: microdsp.bypass_fade(x, rate, channels=channels),
+         lambda: microdsp.bypass_fade(x, rate, channels=channels, out=out16),
+         lambda: np_bypass_fade(x, rate, channels=channels)),
+        ("delay", lambda: microdsp.delay(x, rate, channels=channels),
+         lambda: microdsp.delay(x, rate, channels=channels, out=out16),
+         lambda: np_delay(x, rate, channels=channels)),
+        ("int16_to_float", lambda: microdsp.int16_to_float(x), lambda: microdsp.int16_to_float(x, out=out32),
+         lambda: np_int16_to_float(x)),
+        ("float_to_int16", lambda: microdsp.float_to_int16(f), lambda: microdsp.float_to_int16(f, out=out16),
+         lambda: np_float_to_int16(f)),
+    ]
+    print(f"{'processor':<15} {'microdsp':>10} {'out=':>10} {'NumPy':>10} {'speedup':>8}   (ms per {audio_seconds:.0f} s)")
+    for name, ours, ours_out, theirs in rows:
+        t_ours = best_of(ours)
+        t_out = best_of(ours_out)
+        t_np = best_of(theirs)
+        print(f"{name:<15} {t_ours * 1e3:10.2f} {t_out * 1e3:10.2f} {t_np * 1e3:10.2f} {t_np / t_out:7.1f}x")
+
+    # The loop people write first, on one second of audio only
+    one_second = x[:rate * channels].tolist()
+    t_loop = best_of(lambda: python_loop_delay(one_second, rate), repeats=1) * audio_seconds
+    print(f"{'python loop':<15} {t_loop * 1e3:10.0f} {'':>10} {'':>10}          (delay, extrapolated)\n")
+
+    # -----------------------------------------------------------------------
+    # 3. Threads: the GIL is released inside every call
+    # -----------------------------------------------------------------------
+    cores = os.cpu_count() or 1
+    workers = max(2, min(cores, 8))
+    inputs = [x.copy() for _ in range(workers)]
+    outputs = [np.empty_like(x) for _ in range(workers)]
+
+    def work(i):
+        for _ in range(20):
+            microdsp.delay(inputs[i], rate, channels=channels, out=outputs[i])
+
+    serial = best_of(lambda: [work(i) for i in range(workers)], repeats=2)
+
+    def threaded():
+        threads = [threading.Thread(target=work, args=(i,)) for i in range(workers)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+
+    parallel = best_of(threaded, repeats=2)
+    print(f"{workers} threads x 20 delays: serial {serial * 1e3:.1f} ms, threaded {parallel * 1e3:.1f} ms "
+          f"({serial / parallel:.2f}x on {cores} core{'s' if cores != 1 else ''})")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
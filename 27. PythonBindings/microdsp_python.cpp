@@ -0,0 +1,624 @@
+/*
+    MicroDSP - Day 27: Python Bindings
+
+    What this program does:
+    - Builds a Python extension module called `microdsp` that runs the
+      MicroDSP processors on NumPy arrays (or any other buffer) directly
+    - Same math as the C++ programs, sample for sample:
+        gain(x, g)               Day 2 gain (scale, clamp, truncate)
+        bypass_fade(x, rate)     Day 3 bypass switch with a crossfade
+        delay(x, rate)           Day 4/5 feedforward delay
+        Delay(rate)              the same delay, keeping its history between
+                                 calls so a long signal can be fed in blocks
+        int16_to_float(x)        16-bit PCM -> float32 in [-1, 1)
+        float_to_int16(x)        float32 -> 16-bit PCM (scaled, clamped, rounded;
+                                 NaN becomes 0)
+
+    Usage (Python):
+        import numpy as np, microdsp
+        x = np.fromfile("input.wav", dtype=np.int16, offset=44)
+        y = np.asarray(microdsp.gain(x, 0.5))        # new int16 buffer
+        microdsp.gain(x, 0.5, out=x)                 # in place, no allocation
+        d = microdsp.Delay(44100, delay_ms=250)
+        for block in np.split(x, 100): d.process(block, out=block)
+
+    Zero-copy in and out (the buffer protocol):
+    - Every Python object that holds raw memory (numpy arrays, array.array,
+      bytes, bytearray, memoryview, mmap) can hand out a pointer to that
+      memory through the "buffer protocol". We ask for it with
+      PyObject_GetBuffer and run the C++ loop straight on NumPy's memory:
+      no conversion to Python ints, no copy into a std::vector.
+    - Output goes into `out=` if you pass it (which may be the input itself),
+      otherwise into a new bytearray returned as a typed memoryview.
+      np.asarray() wraps that memoryview without copying either.
+    - Buffers must be C-contiguous. A strided view (x[::2]) is refused with
+      an error instead of being copied behind your back.
+
+    Releasing the GIL:
+    - Python only lets one thread run Python code at a time (the Global
+      Interpreter Lock). Our loops don't touch any Python objects, so we
+      let go of the lock around them (Py_BEGIN_ALLOW_THREADS). Several
+      Python threads calling microdsp at once really run in parallel,
+      one per core.
+    - The buffers stay pinned while the lock is released: we hold a buffer
+      "view" on each one until the loop is done, so NumPy can't resize or
+      free them underneath us.
+    - A Delay object keeps state, so two threads must not feed the same
+      one at once. That is detected and raised as a RuntimeError instead of
+      silently mixing their histories.
+
+    Build (Linux / macOS):
+        g++ -std=c++17 -O3 -march=native -shared -fPIC $(python3-config --includes) microdsp_python.cpp -o microdsp$(python3-config --extension-suffix)
+    Then, from the same folder:
+        python3 bench_numpy.py
+
+    Author: Jesse Whiting (GhostWire Audio)
+    GitHub: ghostwireaudio
+*/
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <atomic>
+#include <new>
+#include <algorithm>
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// The processors: plain C++ working on interleaved 16-bit blocks, exactly
+// as in the earlier days. Nothing in here knows about Python.
+// ---------------------------------------------------------------------------
+void processGain(const int16_t* in, int16_t* out, size_t count, double gain) {
+    for (size_t i = 0; i < count; ++i) {
+        double processed = in[i] * gain;
+        processed = std::min(32767.0, std::max(-32768.0, processed));
+        out[i] = static_cast<int16_t>(processed);
+    }
+}
+
+// Day 3: dry until dryUntilSeconds, then a linear crossfade to dry * gain.
+// firstFrame lets a long file be processed in blocks.
+void processBypassFade(const int16_t* in, int16_t* out, size_t frames, int channels, double sampleRate,
+                       double gain, double dryUntilSeconds, double fadeMs, uint64_t firstFrame) {
+    const uint64_t fadeStart = static_cast<uint64_t>(sampleRate * dryUntilSeconds);
+    const uint64_t fadeFrames = std::max<uint64_t>(1, static_cast<uint64_t>(sampleRate * (fadeMs / 1000.0)));
+    const uint64_t fadeEnd = fadeStart + fadeFrames;
+
+    // Before the fade the output is exactly the dry input, and after it is
+    // exactly Day 2's gain, so only the fade itself needs the per-frame mix
+    const uint64_t lastFrame = firstFrame + frames;
+    const size_t dryFrames = static_cast<size_t>(std::min(lastFrame, std::max(firstFrame, fadeStart)) - firstFrame);
+    const size_t wetFrom = static_cast<size_t>(std::min(lastFrame, std::max(firstFrame, fadeEnd)) - firstFrame);
+    if (in != out) std::memmove(out, in, dryFrames * channels * sizeof(int16_t));
+    for (size_t n = dryFrames; n < wetFrom; ++n) {
+        const uint64_t index = firstFrame + n;
+        const double mix = static_cast<double>(index - fadeStart) / static_cast<double>(fadeFrames);
+        for (int c = 0; c < channels; ++c) {
+            const double dry = in[n * channels + c];
+            const double mixed = (1.0 - mix) * dry + mix * dry * gain;
+            out[n * channels + c] = static_cast<int16_t>(std::clamp(mixed, -32768.0, 32767.0));
+        }
+    }
+    processGain(in + wetFrom * channels, out + wetFrom * channels, (frames - wetFrom) * channels, gain);
+}
+
+// Day 4's y[n] = dry * x[n] + wet * x[n - D], kept as a Day 5 circular
+// history of the last D frames so it works block by block and in place
+// (each input sample is read before the same slot in `out` is written).
+struct DelayState {
+    float dry = 0.8f;
+    float wet = 0.5f;
+    int channels = 1;
+    uint64_t delay = 0;             // Delay in frames
+    std::vector<int16_t> history;   // delay * channels samples
+    uint64_t writeIndex = 0;
+
+    DelayState(double sampleRate, int channels, float delayMs, float dry, float wet)
+        : dry(dry), wet(wet), channels(channels) {
+        // Same conversion as Day 4 (float math, truncated)
+        delay = static_cast<uint64_t>((delayMs / 1000.0f) * static_cast<float>(sampleRate));
+        history.assign(delay * channels, 0);
+    }
+
+    void reset() {
+        std::fill(history.begin(), history.end(), 0);
+        writeIndex = 0;
+    }
+
+    void process(const int16_t* in, int16_t* out, size_t frames) {
+        if (delay == 0) {
+            for (size_t i = 0; i < frames * channels; ++i) out[i] = mixSample(in[i], in[i]);
+            return;
+        }
+        // Walk the ring in runs that don't wrap, so the inner loop is a
+        // straight pass over three arrays that the compiler can vectorize.
+        // The oldest entry in the ring is exactly D frames ago (zero until
+        // the ring has filled, like Day 4's n < D case).
+        while (frames > 0) {
+            const size_t run = static_cast<size_t>(std::min<uint64_t>(frames, delay - writeIndex));
+            int16_t* h = history.data() + writeIndex * channels;
+            for (size_t i = 0; i < run * channels; ++i) {
+                const int16_t sample = in[i];
+                const int16_t delayed = h[i];
+                h[i] = sample;
+                out[i] = mixSample(sample, delayed);
+            }
+            in += run * channels;
+            out += run * channels;
+            frames -= run;
+            writeIndex += run;
+            if (writeIndex == delay) writeIndex = 0;
+        }
+    }
+
+    int16_t mixSample(int16_t sample, int16_t delayed) const {
+        const float mix = std::clamp(dry * static_cast<float>(sample) + wet * static_cast<float>(delayed), -32768.0f, 32767.0f);
+        return static_cast<int16_t>(mix);
+    }
+};
+
+// The usual PCM <-> float convention: -32768 maps to exactly -1.0
+void int16ToFloat(const int16_t* in, float* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) out[i] = static_cast<float>(in[i]) * (1.0f / 32768.0f);
+}
+
+void floatToInt16(const float* in, int16_t* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        // NaN gets through the clamp (every comparison with it is false),
+        // and converting NaN to an integer is undefined, so it becomes
+        // silence first. x == x is false only for NaN, and the check costs
+        // one compare and one blend per vector.
+        const float v = (in[i] == in[i]) ? in[i] : 0.0f;
+
+        // Adding and removing 1.5 * 2^23 leaves no bits below the point, so
+        // the float rounds to the nearest integer (ties to even, like
+        // lrintf) and the loop still vectorizes
+        const float scaled = std::clamp(v * 32768.0f, -32768.0f, 32767.0f);
+        const float rounded = (scaled + 12582912.0f) - 12582912.0f;
+        out[i] = static_cast<int16_t>(rounded);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Buffer protocol helpers
+// ---------------------------------------------------------------------------
+enum class SampleType { Int16, Float32 };
+
+size_t sampleSize(SampleType type) { return type == SampleType::Int16 ? 2 : 4; }
+const char* sampleFormat(SampleType type) { return type == SampleType::Int16 ? "h" : "f"; }
+
+// Holds a buffer view and releases it on every return path
+class BufferView {
+public:
+    BufferView() { std::memset(&view, 0, sizeof(view)); }
+    ~BufferView() { if (acquired) PyBuffer_Release(&view); }
+    BufferView(const BufferView&) = delete;
+    BufferView& operator=(const BufferView&) = delete;
+
+    // Pins obj's memory and checks it holds `type` samples. Returns false
+    // with a Python exception set if it doesn't.
+    bool acquire(PyObject* obj, SampleType type, bool writable, const char* argName) {
+        int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT;
+        if (writable) flags |= PyBUF_WRITABLE;
+        if (PyObject_GetBuffer(obj, &view, flags) != 0) return false;
+        acquired = true;
+
+        // '@', '=' and '<' all mean native little-endian here; '>' does not
+        const char* format = view.format ? view.format : "B";
+        if (*format == '@' || *format == '=' || *format == '<') ++format;
+
+        // Raw bytes (bytes, bytearray, uint8 arrays) are taken as packed samples
+        const bool rawBytes = view.itemsize == 1 && (std::strcmp(format, "B") == 0 || std::strcmp(format, "b") == 0 ||
+                                                     std::strcmp(format, "c") == 0);
+        const bool typed = std::strcmp(format, sampleFormat(type)) == 0 &&
+                           view.itemsize == static_cast<Py_ssize_t>(sampleSize(type));
+        if (!typed && !rawBytes) {
+            PyErr_Format(PyExc_TypeError, "%s must be %s buffer, got format '%s'", argName,
+                         type == SampleType::Int16 ? "an int16" : "a float32", view.format ? view.format : "B");
+            return false;
+        }
+        if (view.len % static_cast<Py_ssize_t>(sampleSize(type)) != 0) {
+            PyErr_Format(PyExc_ValueError, "%s has %zd bytes, not a whole number of samples", argName, view.len);
+            return false;
+        }
+        return true;
+    }
+
+    size_t count(SampleType type) const { return static_cast<size_t>(view.len) / sampleSize(type); }
+    void* data() const { return view.buf; }
+
+private:
+    Py_buffer view;
+    bool acquired = false;
+};
+
+// Gets the buffer the result goes into: `out` if the caller passed one
+// (must hold exactly `count` samples), otherwise a new bytearray seen
+// through a typed memoryview. Returns a new reference to what the Python
+// function should return, or NULL with an exception set.
+PyObject* prepareOutput(PyObject* out, SampleType type, size_t count, BufferView& outView) {
+    PyObject* result = nullptr;
+    if (out == nullptr || out == Py_None) {
+        PyObject* bytes = PyByteArray_FromStringAndSize(nullptr, static_cast<Py_ssize_t>(count * sampleSize(type)));
+        if (!bytes) return nullptr;
+        PyObject* raw = PyMemoryView_FromObject(bytes);
+        Py_DECREF(bytes); // The memoryview keeps the bytearray alive
+        if (!raw) return nullptr;
+        result = PyObject_CallMethod(raw, "cast", "s", sampleFormat(type));
+        Py_DECREF(raw);
+        if (!result) return nullptr;
+    } else {
+        Py_INCREF(out);
+        result = out;
+    }
+
+    if (!outView.acquire(result, type, true, "out")) {
+        Py_DECREF(result);
+        return nullptr;
+    }
+    if (outView.count(type) != count) {
+        PyErr_Format(PyExc_ValueError, "out holds %zu samples but the result has %zu", outView.count(type), count);
+        Py_DECREF(result);
+        return nullptr;
+    }
+    return result;
+}
+
+bool checkChannels(int channels, size_t count) {
+    if (channels < 1) {
+        PyErr_SetString(PyExc_ValueError, "channels must be at least 1");
+        return false;
+    }
+    if (count % static_cast<size_t>(channels) != 0) {
+        PyErr_Format(PyExc_ValueError, "%zu samples is not a whole number of %d-channel frames", count, channels);
+        return false;
+    }
+    return true;
+}
+
+bool checkSampleRate(double sampleRate) {
+    if (!(sampleRate > 0.0)) {
+        PyErr_SetString(PyExc_ValueError, "sample_rate must be positive");
+        return false;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Module functions
+// ---------------------------------------------------------------------------
+PyObject* pyGain(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"input", "gain", "out", nullptr};
+    PyObject* input = nullptr;
+    double gain = 1.0;
+    PyObject* out = nullptr;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "Od|O", const_cast<char**>(keywords), &input, &gain, &out)) {
+        return nullptr;
+    }
+
+    BufferView inView, outView;
+    if (!inView.acquire(input, SampleType::Int16, false, "input")) return nullptr;
+    const size_t count = inView.count(SampleType::Int16);
+    PyObject* result = prepareOutput(out, SampleType::Int16, count, outView);
+    if (!result) return nullptr;
+
+    const int16_t* src = static_cast<const int16_t*>(inView.data());
+    int16_t* dst = static_cast<int16_t*>(outView.data());
+    Py_BEGIN_ALLOW_THREADS
+    processGain(src, dst, count, gain);
+    Py_END_ALLOW_THREADS
+    return result;
+}
+
+PyObject* pyBypassFade(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"input", "sample_rate", "gain", "dry_until", "fade_ms",
+                                     "channels", "first_frame", "out", nullptr};
+    PyObject* input = nullptr;
+    double sampleRate = 0.0;
+    double gain = 2.0;
+    double dryUntil = 1.0;
+    double fadeMs = 10.0;
+    int channels = 1;
+    unsigned long long firstFrame = 0;
+    PyObject* out = nullptr;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "Od|dddiKO", const_cast<char**>(keywords), &input, &sampleRate,
+                                     &gain, &dryUntil, &fadeMs, &channels, &firstFrame, &out)) {
+        return nullptr;
+    }
+    if (!checkSampleRate(sampleRate)) return nullptr;
+
+    BufferView inView, outView;
+    if (!inView.acquire(input, SampleType::Int16, false, "input")) return nullptr;
+    const size_t count = inView.count(SampleType::Int16);
+    if (!checkChannels(channels, count)) return nullptr;
+    PyObject* result = prepareOutput(out, SampleType::Int16, count, outView);
+    if (!result) return nullptr;
+
+    const int16_t* src = static_cast<const int16_t*>(inView.data());
+    int16_t* dst = static_cast<int16_t*>(outView.data());
+    Py_BEGIN_ALLOW_THREADS
+    processBypassFade(src, dst, count / channels, channels, sampleRate, gain, dryUntil, fadeMs, firstFrame);
+    Py_END_ALLOW_THREADS
+    return result;
+}
+
+PyObject* pyDelay(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"input", "sample_rate", "delay_ms", "dry", "wet", "channels", "out", nullptr};
+    PyObject* input = nullptr;
+    double sampleRate = 0.0;
+    float delayMs = 250.0f;
+    float dry = 0.8f;
+    float wet = 0.5f;
+    int channels = 1;
+    PyObject* out = nullptr;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "Od|fffiO", const_cast<char**>(keywords), &input, &sampleRate,
+                                     &delayMs, &dry, &wet, &channels, &out)) {
+        return nullptr;
+    }
+    if (!checkSampleRate(sampleRate)) return nullptr;
+    if (delayMs < 0.0f) {
+        PyErr_SetString(PyExc_ValueError, "delay_ms must not be negative");
+        return nullptr;
+    }
+
+    BufferView inView, outView;
+    if (!inView.acquire(input, SampleType::Int16, false, "input")) return nullptr;
+    const size_t count = inView.count(SampleType::Int16);
+    if (!checkChannels(channels, count)) return nullptr;
+    PyObject* result = prepareOutput(out, SampleType::Int16, count, outView);
+    if (!result) return nullptr;
+
+    const int16_t* src = static_cast<const int16_t*>(inView.data());
+    int16_t* dst = static_cast<int16_t*>(outView.data());
+    bool outOfMemory = false;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        DelayState state(sampleRate, channels, delayMs, dry, wet);
+        state.process(src, dst, count / channels);
+    } catch (const std::bad_alloc&) {
+        outOfMemory = true;
+    }
+    Py_END_ALLOW_THREADS
+    if (outOfMemory) {
+        Py_DECREF(result);
+        return PyErr_NoMemory();
+    }
+    return result;
+}
+
+PyObject* pyInt16ToFloat(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"input", "out", nullptr};
+    PyObject* input = nullptr;
+    PyObject* out = nullptr;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|O", const_cast<char**>(keywords), &input, &out)) return nullptr;
+
+    BufferView inView, outView;
+    if (!inView.acquire(input, SampleType::Int16, false, "input")) return nullptr;
+    const size_t count = inView.count(SampleType::Int16);
+    PyObject* result = prepareOutput(out, SampleType::Float32, count, outView);
+    if (!result) return nullptr;
+
+    const int16_t* src = static_cast<const int16_t*>(inView.data());
+    float* dst = static_cast<float*>(outView.data());
+    Py_BEGIN_ALLOW_THREADS
+    int16ToFloat(src, dst, count);
+    Py_END_ALLOW_THREADS
+    return result;
+}
+
+PyObject* pyFloatToInt16(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"input", "out", nullptr};
+    PyObject* input = nullptr;
+    PyObject* out = nullptr;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|O", const_cast<char**>(keywords), &input, &out)) return nullptr;
+
+    BufferView inView, outView;
+    if (!inView.acquire(input, SampleType::Float32, false, "input")) return nullptr;
+    const size_t count = inView.count(SampleType::Float32);
+    PyObject* result = prepareOutput(out, SampleType::Int16, count, outView);
+    if (!result) return nullptr;
+
+    const float* src = static_cast<const float*>(inView.data());
+    int16_t* dst = static_cast<int16_t*>(outView.data());
+    Py_BEGIN_ALLOW_THREADS
+    floatToInt16(src, dst, count);
+    Py_END_ALLOW_THREADS
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// microdsp.Delay: a delay that remembers its history between calls
+// ---------------------------------------------------------------------------
+struct DelayObject {
+    PyObject_HEAD
+    DelayState* state;
+    std::atomic<bool> busy; // Set while a process() call runs without the GIL
+};
+
+int delayInit(PyObject* self, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"sample_rate", "delay_ms", "dry", "wet", "channels", nullptr};
+    DelayObject* d = reinterpret_cast<DelayObject*>(self);
+    double sampleRate = 0.0;
+    float delayMs = 250.0f;
+    float dry = 0.8f;
+    float wet = 0.5f;
+    int channels = 1;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "d|fffi", const_cast<char**>(keywords), &sampleRate, &delayMs,
+                                     &dry, &wet, &channels)) {
+        return -1;
+    }
+    if (!checkSampleRate(sampleRate)) return -1;
+    if (channels < 1 || delayMs < 0.0f) {
+        PyErr_SetString(PyExc_ValueError, "channels must be at least 1 and delay_ms must not be negative");
+        return -1;
+    }
+    if (d->busy.load()) {
+        PyErr_SetString(PyExc_RuntimeError, "Delay is being used by another thread");
+        return -1;
+    }
+
+    try {
+        DelayState* fresh = new DelayState(sampleRate, channels, delayMs, dry, wet);
+        delete d->state;
+        d->state = fresh;
+    } catch (const std::bad_alloc&) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    return 0;
+}
+
+PyObject* delayNew(PyTypeObject* type, PyObject*, PyObject*) {
+    PyObject* self = type->tp_alloc(type, 0);
+    if (!self) return nullptr;
+    DelayObject* d = reinterpret_cast<DelayObject*>(self);
+    d->state = nullptr;
+    new (&d->busy) std::atomic<bool>(false);
+    return self;
+}
+
+void delayDealloc(PyObject* self) {
+    DelayObject* d = reinterpret_cast<DelayObject*>(self);
+    delete d->state;
+    PyTypeObject* type = Py_TYPE(self);
+    type->tp_free(self);
+    Py_DECREF(type); // Heap types own a reference from each instance
+}
+
+PyObject* delayProcess(PyObject* self, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"input", "out", nullptr};
+    DelayObject* d = reinterpret_cast<DelayObject*>(self);
+    PyObject* input = nullptr;
+    PyObject* out = nullptr;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|O", const_cast<char**>(keywords), &input, &out)) return nullptr;
+    if (!d->state) {
+        PyErr_SetString(PyExc_RuntimeError, "Delay was not initialised");
+        return nullptr;
+    }
+
+    BufferView inView, outView;
+    if (!inView.acquire(input, SampleType::Int16, false, "input")) return nullptr;
+    const size_t count = inView.count(SampleType::Int16);
+    if (!checkChannels(d->state->channels, count)) return nullptr;
+    PyObject* result = prepareOutput(out, SampleType::Int16, count, outView);
+    if (!result) return nullptr;
+
+    // Two threads feeding one Delay would interleave their blocks in one
+    // history. Refuse instead of producing garbage.
+    if (d->busy.exchange(true)) {
+        Py_DECREF(result);
+        PyErr_SetString(PyExc_RuntimeError, "Delay is being used by another thread");
+        return nullptr;
+    }
+    const int16_t* src = static_cast<const int16_t*>(inView.data());
+    int16_t* dst = static_cast<int16_t*>(outView.data());
+    DelayState* state = d->state;
+    Py_BEGIN_ALLOW_THREADS
+    state->process(src, dst, count / state->channels);
+    Py_END_ALLOW_THREADS
+    d->busy.store(false);
+    return result;
+}
+
+PyObject* delayReset(PyObject* self, PyObject*) {
+    DelayObject* d = reinterpret_cast<DelayObject*>(self);
+    if (d->busy.load()) {
+        PyErr_SetString(PyExc_RuntimeError, "Delay is being used by another thread");
+        return nullptr;
+    }
+    if (d->state) d->state->reset();
+    Py_RETURN_NONE;
+}
+
+PyObject* delayGetFrames(PyObject* self, void*) {
+    const DelayObject* d = reinterpret_cast<const DelayObject*>(self);
+    return PyLong_FromUnsignedLongLong(d->state ? d->state->delay : 0);
+}
+
+// Functions taking keyword arguments have a different signature than
+// PyCFunction; Python calls them correctly because of METH_KEYWORDS
+template <typename F>
+PyCFunction asCFunction(F f) {
+    return reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(f));
+}
+
+PyMethodDef delayMethods[] = {
+    {"process", asCFunction(delayProcess),
+     METH_VARARGS | METH_KEYWORDS,
+     "process(input, out=None)\n--\n\nDelays the next block of int16 samples, continuing from the last call."},
+    {"reset", delayReset, METH_NOARGS, "reset()\n--\n\nClears the history back to silence."},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+PyGetSetDef delayGetSet[] = {
+    {"delay_frames", delayGetFrames, nullptr, "Delay length in frames (D)", nullptr},
+    {nullptr, nullptr, nullptr, nullptr, nullptr},
+};
+
+PyType_Slot delaySlots[] = {
+    {Py_tp_new, reinterpret_cast<void*>(delayNew)},
+    {Py_tp_init, reinterpret_cast<void*>(delayInit)},
+    {Py_tp_dealloc, reinterpret_cast<void*>(delayDealloc)},
+    {Py_tp_methods, delayMethods},
+    {Py_tp_getset, delayGetSet},
+    {Py_tp_doc, const_cast<char*>("Delay(sample_rate, delay_ms=250, dry=0.8, wet=0.5, channels=1)\n--\n\n"
+                                  "Feedforward delay that keeps its history between process() calls.")},
+    {0, nullptr},
+};
+
+PyType_Spec delaySpec = {
+    "microdsp.Delay",
+    sizeof(DelayObject),
+    0,
+    Py_TPFLAGS_DEFAULT,
+    delaySlots,
+};
+
+// ---------------------------------------------------------------------------
+// Module definition
+// ---------------------------------------------------------------------------
+PyMethodDef moduleMethods[] = {
+    {"gain", asCFunction(pyGain), METH_VARARGS | METH_KEYWORDS,
+     "gain(input, gain, out=None)\n--\n\nDay 2 gain on int16 samples."},
+    {"bypass_fade", asCFunction(pyBypassFade), METH_VARARGS | METH_KEYWORDS,
+     "bypass_fade(input, sample_rate, gain=2.0, dry_until=1.0, fade_ms=10.0, channels=1, first_frame=0, out=None)\n--\n\n"
+     "Day 3 bypass switch: dry until dry_until seconds, then a linear crossfade to input * gain."},
+    {"delay", asCFunction(pyDelay), METH_VARARGS | METH_KEYWORDS,
+     "delay(input, sample_rate, delay_ms=250, dry=0.8, wet=0.5, channels=1, out=None)\n--\n\n"
+     "Day 4 feedforward delay over a whole signal. out may be the input."},
+    {"int16_to_float", asCFunction(pyInt16ToFloat), METH_VARARGS | METH_KEYWORDS,
+     "int16_to_float(input, out=None)\n--\n\nint16 PCM to float32, x / 32768."},
+    {"float_to_int16", asCFunction(pyFloatToInt16), METH_VARARGS | METH_KEYWORDS,
+     "float_to_int16(input, out=None)\n--\n\nfloat32 to int16 PCM, x * 32768 clamped and rounded to nearest. NaN becomes 0."},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+PyModuleDef moduleDef = {
+    PyModuleDef_HEAD_INIT,
+    "microdsp",
+    "MicroDSP processors with zero-copy buffers that run without the GIL.",
+    -1,
+    moduleMethods,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+};
+
+} // namespace
+
+PyMODINIT_FUNC PyInit_microdsp(void) {
+    PyObject* module = PyModule_Create(&moduleDef);
+    if (!module) return nullptr;
+    PyObject* delayType = PyType_FromSpec(&delaySpec);
+    if (!delayType || PyModule_AddObject(module, "Delay", delayType) != 0) {
+        Py_XDECREF(delayType);
+        Py_DECREF(module);
+        return nullptr;
+    }
+    return module;
+}
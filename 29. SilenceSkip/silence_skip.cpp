@@ -0,0 +1,453 @@
+/*
+    MicroDSP - Day 29: Skipping Silence
+
+    What this program does:
+    - Renders a gain -> delay chain over a file with long stretches of
+      digital silence (the demo builds one from input.wav, like a broadcast
+      recording with gaps between segments)
+    - Checks every block for silence before processing it, and skips the
+      work wherever the output is already known
+    - Renders the same file the plain way too, checks that both outputs are
+      byte-for-byte identical, and reports how many blocks were skipped
+
+    Usage:
+        silence_skip
+            (demo on broadcast.wav built from input.wav)
+        silence_skip <input.wav> <output.wav> [job ...]
+            jobs as in Day 28: gain:0.5  delay:250:0.8:0.5
+            (default: gain:0.5 delay:250:0.8:0.5)
+
+    Finding constant blocks:
+    - Every block that is read gets one quick scan for its smallest and
+      largest sample. If they're equal, every sample in the block has the
+      same value: the block is "constant", and if that value is 0 it is
+      digital silence. The scan is a plain min/max loop with no branches,
+      which the compiler turns into SIMD instructions (16 samples per
+      instruction with AVX2) at -O3 -march=native.
+
+    Passing it down the chain:
+    - Each processor can say what it does to a constant block WITHOUT
+      looking at the samples:
+        gain:   a block of v comes out as a block of v * gain (clamped).
+                Silence stays silence.
+        delay:  y[n] = dry * x[n] + wet * x[n - D] is only constant if the
+                last D input frames were the same value too. After the
+                input goes silent the echo keeps sounding for D more
+                frames; once the delay buffer has drained, silence in
+                means silence out.
+    - So the delay remembers how many frames in a row it has been fed the
+      same value. Until that reaches D it processes normally; after that it
+      skips.
+    - If a stage can't skip, the constant block is written out for it to
+      process and the blocks after it are "unknown" again. A constant
+      result at the end of the chain is written out directly (all zeros
+      for silence) without any per-sample math.
+
+    Build:
+        g++ -std=c++17 -O3 -march=native silence_skip.cpp -o silence_skip
+
+    Author: Jesse Whiting (GhostWire Audio)
+    GitHub: ghostwireaudio
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <cstdio>
+
+// Force the compiler to pack the struct exactly as written
+// with no padding bytes added for alignment, which ensures
+// sizeof(WavHeader) == 44 bytes
+#pragma pack(push, 1)
+struct WavHeader {
+    // RIFF Chunk Descriptor
+    char     riff[4];        // "RIFF"
+    uint32_t chunkSize;      // 36 + Subchunk2Size
+    char     wave[4];        // "WAVE"
+
+    // fmt subchunk
+    char     fmt[4];         // "fmt "
+    uint32_t subchunk1Size;  // 16 for PCM
+    uint16_t audioFormat;    // 1 for PCM
+    uint16_t numChannels;    // 1 for mono
+    uint32_t sampleRate;     // e.g., 44100
+    uint32_t byteRate;       // sampleRate * numChannels * bitsPerSample/8
+    uint16_t blockAlign;     // numChannels * bitsPerSample/8
+    uint16_t bitsPerSample;  // 16
+
+    // data subchunk
+    char     data[4];        // "data"
+    uint32_t subchunk2Size;  // NumSamples * numChannels * bitsPerSample/8
+};
+#pragma pack(pop)
+
+const uint64_t blockFrames = 4096;
+
+// What the engine knows about a block without looking at it again
+struct BlockInfo {
+    bool constant = false;   // Every sample (every channel) has the same value
+    int16_t value = 0;       // That value; 0 means digital silence
+};
+
+// One pass of min/max over the block. No branches in the loop, so it
+// vectorizes.
+BlockInfo scanBlock(const int16_t* samples, size_t count) {
+    if (count == 0) return {};
+    int16_t lo = samples[0];
+    int16_t hi = samples[0];
+    for (size_t i = 1; i < count; ++i) {
+        lo = std::min(lo, samples[i]);
+        hi = std::max(hi, samples[i]);
+    }
+    BlockInfo info;
+    info.constant = (lo == hi);
+    info.value = lo;
+    return info;
+}
+
+// ---------------------------------------------------------------------------
+// Processors
+// ---------------------------------------------------------------------------
+class Processor {
+public:
+    virtual ~Processor() = default;
+
+    // Back to silence, as at the start of a render
+    virtual void reset(int channels) = 0;
+
+    // Processes interleaved 16-bit frames; 'in' and 'out' may be the same buffer
+    virtual void process(const int16_t* in, int16_t* out, uint64_t frames) = 0;
+
+    // Called before process() when every input sample of the block equals
+    // 'value'. If the output is then constant too, the processor updates
+    // its state as process() would have, sets outValue and returns true,
+    // and process() is NOT called. Returning false is always safe.
+    virtual bool processConstant(int16_t value, uint64_t frames, int16_t& outValue) {
+        (void)value;
+        (void)frames;
+        (void)outValue;
+        return false;
+    }
+};
+
+// Day 2 gain: every sample on its own, no state
+class Gain : public Processor {
+public:
+    explicit Gain(double gain) : gain(gain) {}
+
+    void reset(int numChannels) override { channels = numChannels; }
+
+    void process(const int16_t* in, int16_t* out, uint64_t frames) override {
+        for (uint64_t i = 0; i < frames * channels; ++i) out[i] = apply(in[i]);
+    }
+
+    // A block of v is a block of apply(v): silence stays silence
+    bool processConstant(int16_t value, uint64_t, int16_t& outValue) override {
+        outValue = apply(value);
+        return true;
+    }
+
+private:
+    int16_t apply(int16_t sample) const {
+        double processed = sample * gain;
+        processed = std::min(32767.0, std::max(-32768.0, processed));
+        return static_cast<int16_t>(processed);
+    }
+
+    double gain;
+    int channels = 1;
+};
+
+// The Day 4 delay with a Day 5 circular history (as in Day 16), plus a
+// count of how long the input has held one value
+class FeedforwardDelay : public Processor {
+public:
+    FeedforwardDelay(uint64_t delayFrames, float dry, float wet)
+        : delay(delayFrames), dry(dry), wet(wet) {}
+
+    void reset(int numChannels) override {
+        channels = numChannels;
+        history.assign(std::max<uint64_t>(delay, 1) * channels, 0);
+        writeIndex = 0;
+        // An empty history is the same as having been fed D frames of silence
+        runValue = 0;
+        runFrames = delay;
+    }
+
+    void process(const int16_t* in, int16_t* out, uint64_t frames) override {
+        const uint64_t count = frames * channels;
+        if (count > 0) trackRun(in, count);
+        for (uint64_t n = 0; n < frames; ++n) {
+            for (int c = 0; c < channels; ++c) {
+                const int16_t sample = in[n * channels + c];
+                const float x = static_cast<float>(sample);
+
+                // The oldest entry in the ring is exactly D frames ago
+                // (zero until the ring has filled, like Day 4's n < D case)
+                const float d = (delay > 0) ? static_cast<float>(history[writeIndex * channels + c]) : x;
+                if (delay > 0) history[writeIndex * channels + c] = sample;
+                out[n * channels + c] = mix(x, d);
+            }
+            if (delay > 0 && ++writeIndex == delay) writeIndex = 0;
+        }
+    }
+
+    // Once the last D frames were all 'value', every slot of the ring holds
+    // 'value', so x[n] and x[n - D] are both 'value' for this whole block.
+    // Where the write index sits no longer matters: every slot is the same.
+    bool processConstant(int16_t value, uint64_t frames, int16_t& outValue) override {
+        if (delay > 0 && (value != runValue || runFrames < delay)) return false;
+        runFrames = std::min(runFrames + frames, delay); // Only "at least D" matters
+        const float x = static_cast<float>(value);
+        outValue = mix(x, x);
+        return true;
+    }
+
+private:
+    int16_t mix(float x, float d) const {
+        float m = dry * x + wet * d;
+        m = std::clamp(m, -32768.0f, 32767.0f);
+        return static_cast<int16_t>(m);
+    }
+
+    // Counts the frames at the end of this block that hold the block's last
+    // value, and adds them to the run from earlier blocks if it continues
+    void trackRun(const int16_t* in, uint64_t count) {
+        const int16_t last = in[count - 1];
+        uint64_t same = 0;
+        while (same < count && in[count - 1 - same] == last) ++same;
+        const uint64_t frames = same / channels; // Whole frames only
+        if (same == count && last == runValue) runFrames = std::min(runFrames + frames, delay);
+        else {
+            runValue = last;
+            runFrames = std::min(frames, delay);
+        }
+    }
+
+    uint64_t delay;
+    float dry, wet;
+    int channels = 1;
+    std::vector<int16_t> history;
+    uint64_t writeIndex = 0;
+    int16_t runValue = 0;       // The value the input has been holding...
+    uint64_t runFrames = 0;     // ...for this many frames (capped at D)
+};
+
+// Parses "gain:0.5" or "delay:250:0.8:0.5"
+std::unique_ptr<Processor> parseJob(const std::string& job, uint32_t sampleRate) {
+    std::vector<std::string> parts;
+    std::stringstream ss(job);
+    for (std::string part; std::getline(ss, part, ':'); ) parts.push_back(part);
+    if (parts.empty()) return nullptr;
+
+    try {
+        if (parts[0] == "gain" && parts.size() == 2) {
+            return std::make_unique<Gain>(std::stod(parts[1]));
+        }
+        if (parts[0] == "delay" && parts.size() == 4) {
+            const float delayMs = std::stof(parts[1]);
+            if (delayMs < 0.0f) return nullptr;
+            const uint64_t delayFrames = static_cast<uint64_t>((delayMs / 1000.0f) * sampleRate);
+            return std::make_unique<FeedforwardDelay>(delayFrames, std::stof(parts[2]), std::stof(parts[3]));
+        }
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+    return nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// The render engine
+// ---------------------------------------------------------------------------
+// 16-bit PCM whose block size matches its channel count. A zero or
+// mismatched blockAlign would throw off every frame count and seek below.
+bool validHeader(const WavHeader& header) {
+    return header.bitsPerSample == 16 && header.numChannels > 0 && header.blockAlign == header.numChannels * 2;
+}
+
+struct RenderStats {
+    uint64_t blocks = 0;            // Blocks read from the input
+    uint64_t constantBlocks = 0;    // ...of which the scan found constant
+    uint64_t stageBlocks = 0;       // blocks x stages
+    uint64_t skippedStageBlocks = 0;
+    uint64_t directBlocks = 0;      // Output blocks written without any processing
+    double seconds = 0.0;
+};
+
+bool render(const std::string& inputPath, const std::string& outputPath, std::vector<std::unique_ptr<Processor>>& chain,
+            bool skipConstant, RenderStats& stats) {
+    const auto t0 = std::chrono::steady_clock::now();
+    std::ifstream in(inputPath, std::ios::binary);
+    WavHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(WavHeader));
+    if (!in || !validHeader(header)) return false;
+    std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(WavHeader));
+
+    const int channels = header.numChannels;
+    const uint64_t numFrames = header.subchunk2Size / header.blockAlign;
+    std::vector<int16_t> work(blockFrames * channels);
+    for (auto& p : chain) p->reset(channels);
+
+    for (uint64_t pos = 0; pos < numFrames; ) {
+        const uint64_t frames = std::min(blockFrames, numFrames - pos);
+        const uint64_t count = frames * channels;
+        in.read(reinterpret_cast<char*>(work.data()), static_cast<std::streamsize>(frames * header.blockAlign));
+        if (!in) return false;
+
+        BlockInfo info;
+        if (skipConstant) info = scanBlock(work.data(), count);
+        ++stats.blocks;
+        if (info.constant) ++stats.constantBlocks;
+
+        // 'work' holds the signal between stages unless a stage was skipped,
+        // in which case only info.value is known
+        bool inBuffer = true;
+        bool computedAny = false;
+        for (auto& p : chain) {
+            ++stats.stageBlocks;
+            int16_t outValue = 0;
+            if (info.constant && p->processConstant(info.value, frames, outValue)) {
+                info.value = outValue;
+                inBuffer = false;
+                ++stats.skippedStageBlocks;
+                continue;
+            }
+            if (!inBuffer) std::fill(work.begin(), work.begin() + count, info.value);
+            p->process(work.data(), work.data(), frames);
+            info.constant = false; // Unknown until scanned again
+            inBuffer = true;
+            computedAny = true;
+        }
+        if (!inBuffer) std::fill(work.begin(), work.begin() + count, info.value); // memset for silence
+        if (!computedAny) ++stats.directBlocks;
+
+        out.write(reinterpret_cast<const char*>(work.data()), static_cast<std::streamsize>(frames * header.blockAlign));
+        pos += frames;
+    }
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return static_cast<bool>(out);
+}
+
+// Streams both files and compares them byte by byte
+bool filesIdentical(const std::string& a, const std::string& b) {
+    std::ifstream fa(a, std::ios::binary), fb(b, std::ios::binary);
+    if (!fa || !fb) return false;
+    std::vector<char> ba(1 << 16), bb(1 << 16);
+    while (true) {
+        fa.read(ba.data(), static_cast<std::streamsize>(ba.size()));
+        fb.read(bb.data(), static_cast<std::streamsize>(bb.size()));
+        if (fa.gcount() != fb.gcount()) return false;
+        if (!std::equal(ba.begin(), ba.begin() + fa.gcount(), bb.begin())) return false;
+        if (fa.gcount() == 0) return true;
+    }
+}
+
+// Demo input: 'minutes' of input.wav segments separated by digital silence,
+// with one stretch of DC offset (a constant that isn't zero) for good measure
+bool makeBroadcast(const std::string& inputPath, const std::string& outPath, int minutes) {
+    std::ifstream in(inputPath, std::ios::binary);
+    WavHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(WavHeader));
+    if (!in || !validHeader(header)) return false;
+    std::vector<int16_t> program(header.subchunk2Size / sizeof(int16_t));
+    in.read(reinterpret_cast<char*>(program.data()), static_cast<std::streamsize>(program.size() * sizeof(int16_t)));
+    if (!in || program.empty()) return false;
+
+    const uint64_t rate = header.sampleRate;
+    const uint64_t channels = header.numChannels;
+    const uint64_t totalSamples = static_cast<uint64_t>(minutes) * 60 * rate * channels;
+    std::vector<int16_t> audio;
+    audio.reserve(totalSamples);
+    for (int segment = 0; audio.size() < totalSamples; ++segment) {
+        audio.insert(audio.end(), program.begin(), program.end());
+        const uint64_t gapSeconds = 3 + (segment % 5) * 2; // 3 to 11 seconds of silence
+        const int16_t gapValue = (segment % 7 == 3) ? 1000 : 0;
+        audio.insert(audio.end(), gapSeconds * rate * channels, gapValue);
+    }
+    audio.resize(totalSamples);
+
+    header.subchunk2Size = static_cast<uint32_t>(audio.size() * sizeof(int16_t));
+    header.chunkSize = 36 + header.subchunk2Size;
+    std::ofstream out(outPath, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(WavHeader));
+    out.write(reinterpret_cast<const char*>(audio.data()), static_cast<std::streamsize>(header.subchunk2Size));
+    return static_cast<bool>(out);
+}
+
+void printStats(const char* label, const RenderStats& s) {
+    std::printf("%-6s %8.1f ms   constant blocks %5.1f%%   stage work skipped %5.1f%%   output written directly %5.1f%%\n",
+        label, s.seconds * 1000.0, 100.0 * s.constantBlocks / std::max<uint64_t>(s.blocks, 1),
+        100.0 * s.skippedStageBlocks / std::max<uint64_t>(s.stageBlocks, 1),
+        100.0 * s.directBlocks / std::max<uint64_t>(s.blocks, 1));
+}
+
+int main(int argc, char* argv[]) {
+    const bool demo = (argc < 3);
+    const std::string inputPath = demo ? "broadcast.wav" : argv[1];
+    const std::string outputPath = demo ? "output_silence_skip.wav" : argv[2];
+    const std::string plainPath = "output_plain.wav";
+
+    if (demo && !makeBroadcast("input.wav", inputPath, 5)) {
+        std::cerr << "Error: Could not build " << inputPath << " from input.wav\n";
+        return 1;
+    }
+
+    std::ifstream in(inputPath, std::ios::binary);
+    WavHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(WavHeader));
+    if (!in || !validHeader(header)) {
+        std::cerr << "Error: Expected a 16-bit PCM WAV file.\n";
+        return 1;
+    }
+    in.close();
+
+    std::vector<std::string> jobs;
+    for (int i = 3; i < argc; ++i) jobs.push_back(argv[i]);
+    if (jobs.empty()) jobs = { "gain:0.5", "delay:250:0.8:0.5" };
+
+    // Two identical chains: one for each render
+    std::vector<std::unique_ptr<Processor>> plainChain, skipChain;
+    for (const std::string& job : jobs) {
+        std::unique_ptr<Processor> a = parseJob(job, header.sampleRate);
+        std::unique_ptr<Processor> b = parseJob(job, header.sampleRate);
+        if (!a || !b) {
+            std::cerr << "Error: Unknown job " << job << "\n";
+            return 1;
+        }
+        plainChain.push_back(std::move(a));
+        skipChain.push_back(std::move(b));
+    }
+
+    RenderStats plain, skip;
+    if (!render(inputPath, plainPath, plainChain, false, plain) ||
+        !render(inputPath, outputPath, skipChain, true, skip)) {
+        std::cerr << "Error: Render failed.\n";
+        return 1;
+    }
+
+    std::printf("%s: %.1f s, %llu blocks of %llu frames, chain:", inputPath.c_str(),
+        static_cast<double>(header.subchunk2Size / header.blockAlign) / header.sampleRate,
+        static_cast<unsigned long long>(skip.blocks), static_cast<unsigned long long>(blockFrames));
+    for (const std::string& job : jobs) std::printf(" %s", job.c_str());
+    std::printf("\n");
+    printStats("plain", plain);
+    printStats("skip", skip);
+    std::printf("Speedup: %.2fx\n", plain.seconds / skip.seconds);
+
+    const bool identical = filesIdentical(plainPath, outputPath);
+    std::error_code ec;
+    std::filesystem::remove(plainPath, ec);
+    if (demo) std::filesystem::remove(inputPath, ec);
+    std::cout << "Identical to plain render: " << (identical ? "PASS" : "FAIL") << "\n";
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,405 @@
+/*
+    MicroDSP - Day 30: Instance Batching
+
+    What this program does:
+    - Simulates a hosting service running many small, independent
+      gain -> delay chains, one per user stream (mono, 48 kHz, 10 ms blocks)
+    - Every user has their own settings: gain, delay time, dry and wet
+    - Processes all of them two ways:
+        1) one instance at a time (the usual way: a loop over objects)
+        2) batched: 16 instances side by side, one per SIMD lane
+    - Checks that every user's output is identical both ways and reports
+      how many instances one core can keep running in realtime
+
+    Usage:
+        instance_batching [instances] [seconds]
+        (default: 1024 instances, 5 seconds of audio each)
+
+    Why batch:
+    - A single delay does one multiply-add per sample with a data-dependent
+      read from its buffer, so there's little for SIMD to work on inside
+      one instance. But 1000 users all run the SAME code at the same time.
+      Put 16 of them side by side and one AVX-512 instruction does the
+      same step for all 16 (16 floats = 512 bits).
+
+    Structure of arrays (SoA):
+    - The one-at-a-time version keeps each instance as an object (array of
+      structures): gain, dry, wet, buffer, indices together.
+    - A batch keeps one array per field with one entry per lane:
+      dry[16], wet[16], readIndex[16], ... so lane l of every vector is
+      instance l.
+    - The 16 Day 5 circular buffers live back to back in one allocation,
+      and all lanes share one write index. Every user has a different delay
+      time, so each lane reads its own position: one "gather" instruction
+      loads all 16 delayed samples, and one "scatter" stores the 16 new ones.
+    - Why not interleave the delay lines (buffer[slot * 16 + lane])? Then
+      the writes would be one plain store, but each lane's reads would jump
+      64 bytes every frame and pull in a fresh cache line for just 4 bytes.
+      Back to back, a lane's reads and writes walk along its own line and
+      stay in the L1 cache.
+    - Audio arrives per user ([user][frame]), so each block is transposed
+      into lane order ([frame][lane]) before the batch runs, and back after.
+      The transposes are included in the timing; the time without them is
+      shown too, for a host that keeps its audio in lane order anyway.
+
+    Why intrinsics here:
+    - Everywhere else in MicroDSP, plain loops plus -O3 -march=native are
+      enough. Compilers don't vectorize gathers and scatters written like
+      this, so the AVX-512 path spells out the instructions
+      (<immintrin.h>). Without AVX-512 the same lane loop runs as plain C++:
+      it gives the same output but is no faster than one at a time.
+
+    Same numbers either way:
+    - Both versions do the same float (delay) and double (gain) math in
+      the same order, so the results are bit-for-bit identical.
+    - Left alone, the compiler may fuse dry * x + wet * d into one
+      multiply-add (FMA) instruction in one version and not the other. FMA
+      rounds once instead of twice, so the two could land 1 LSB apart. The
+      pragma below the #includes switches that fusing off for this file
+      (g++ and clang), so no special build flag is needed.
+
+    Build:
+        g++ -std=c++17 -O3 -march=native instance_batching.cpp -o instance_batching
+
+    Author: Jesse Whiting (GhostWire Audio)
+    GitHub: ghostwireaudio
+*/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#if defined(__AVX512F__)
+// GCC 12's AVX-512 header fills "don't care" lanes from a variable that
+// is never set on purpose, and -Wall then reports it as "may be used
+// uninitialized" wherever an intrinsic is inlined. It is harmless.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+#endif
+
+// Never fuse a * b + c into an FMA here (see "Same numbers either way")
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+// Force the compiler to pack the struct exactly as written
+// with no padding bytes added for alignment, which ensures
+// sizeof(WavHeader) == 44 bytes
+#pragma pack(push, 1)
+struct WavHeader {
+    // RIFF Chunk Descriptor
+    char     riff[4];        // "RIFF"
+    uint32_t chunkSize;      // 36 + Subchunk2Size
+    char     wave[4];        // "WAVE"
+
+    // fmt subchunk
+    char     fmt[4];         // "fmt "
+    uint32_t subchunk1Size;  // 16 for PCM
+    uint16_t audioFormat;    // 1 for PCM
+    uint16_t numChannels;    // 1 for mono
+    uint32_t sampleRate;     // e.g., 44100
+    uint32_t byteRate;       // sampleRate * numChannels * bitsPerSample/8
+    uint16_t blockAlign;     // numChannels * bitsPerSample/8
+    uint16_t bitsPerSample;  // 16
+
+    // data subchunk
+    char     data[4];        // "data"
+    uint32_t subchunk2Size;  // NumSamples * numChannels * bitsPerSample/8
+};
+#pragma pack(pop)
+
+const int lanes = 16;                  // Instances per batch (one AVX-512 register of floats)
+const uint32_t sampleRate = 48000;
+const uint32_t blockFrames = 480;      // 10 ms
+const float maxDelayMs = 500.0f;       // Longest delay a user may pick
+
+// One user's settings
+struct Settings {
+    double gain;
+    float delayMs;
+    float dry;
+    float wet;
+};
+
+uint32_t delayFrames(const Settings& s) {
+    // Same conversion as Day 5, at least 1 frame
+    return std::max(1u, static_cast<uint32_t>((s.delayMs / 1000.0f) * sampleRate));
+}
+
+const uint32_t maxDelaySamples = static_cast<uint32_t>((maxDelayMs / 1000.0f) * sampleRate) + 1;
+
+// ---------------------------------------------------------------------------
+// One instance at a time (array of structures)
+// ---------------------------------------------------------------------------
+class ScalarInstance {
+public:
+    explicit ScalarInstance(const Settings& s)
+        : gain(s.gain), dry(s.dry), wet(s.wet), delaySamples(delayFrames(s)),
+          delayBuffer(maxDelaySamples, 0.0f) {}
+
+    void process(const int16_t* in, int16_t* out, uint32_t frames) {
+        for (uint32_t n = 0; n < frames; ++n) {
+            // Day 2 gain
+            double processed = in[n] * gain;
+            processed = std::min(32767.0, std::max(-32768.0, processed));
+            const int16_t g = static_cast<int16_t>(processed);
+
+            // Day 5 delay: read delaySamples behind the write head
+            int32_t readIndex = static_cast<int32_t>(writeIndex) - static_cast<int32_t>(delaySamples);
+            if (readIndex < 0) readIndex += maxDelaySamples;
+            const float x = static_cast<float>(g);
+            const float d = delayBuffer[readIndex];
+            const float mix = std::clamp(dry * x + wet * d, -32768.0f, 32767.0f);
+            out[n] = static_cast<int16_t>(mix);
+
+            delayBuffer[writeIndex] = x;
+            if (++writeIndex >= maxDelaySamples) writeIndex = 0;
+        }
+    }
+
+private:
+    double gain;
+    float dry, wet;
+    uint32_t delaySamples;
+    std::vector<float> delayBuffer;
+    uint32_t writeIndex = 0;
+};
+
+// ---------------------------------------------------------------------------
+// 16 instances in SIMD lanes (structure of arrays)
+// ---------------------------------------------------------------------------
+class InstanceBatch {
+public:
+    InstanceBatch() : buffer(static_cast<size_t>(maxDelaySamples) * lanes, 0.0f) {
+        for (int l = 0; l < lanes; ++l) {
+            gain[l] = 0.0;
+            dry[l] = 0.0f;
+            wet[l] = 0.0f;
+            readIndex[l] = 0;
+        }
+    }
+
+    // Unused lanes stay silent (gain 0), but they still do a full lane's
+    // work: a part-filled last batch costs as much as a full one
+    void setLane(int l, const Settings& s) {
+        gain[l] = s.gain;
+        dry[l] = s.dry;
+        wet[l] = s.wet;
+        readIndex[l] = static_cast<int32_t>(maxDelaySamples - delayFrames(s)); // writeIndex (0) minus the delay, wrapped
+    }
+
+    // in and out are lane-interleaved: frame n of lane l is at [n * lanes + l]
+    void process(const int16_t* in, int16_t* out, uint32_t frames) {
+#if defined(__AVX512F__)
+        processAvx512(in, out, frames);
+#else
+        processLanes(in, out, frames);
+#endif
+    }
+
+private:
+    // The same steps as plain loops over the lanes (CPUs without AVX-512)
+    void processLanes(const int16_t* in, int16_t* out, uint32_t frames) {
+        for (uint32_t n = 0; n < frames; ++n) {
+            const int16_t* x = in + static_cast<size_t>(n) * lanes;
+            int16_t* y = out + static_cast<size_t>(n) * lanes;
+            for (int l = 0; l < lanes; ++l) {
+                double processed = x[l] * gain[l];
+                processed = std::min(32767.0, std::max(-32768.0, processed));
+                const float g = static_cast<float>(static_cast<int16_t>(processed));
+
+                float* line = buffer.data() + static_cast<size_t>(l) * maxDelaySamples;
+                const float d = line[readIndex[l]];
+                const float mix = std::clamp(dry[l] * g + wet[l] * d, -32768.0f, 32767.0f);
+                y[l] = static_cast<int16_t>(mix);
+                line[writeIndex] = g;
+                if (++readIndex[l] >= static_cast<int32_t>(maxDelaySamples)) readIndex[l] = 0;
+            }
+            if (++writeIndex >= maxDelaySamples) writeIndex = 0;
+        }
+    }
+
+#if defined(__AVX512F__)
+    // One frame of all 16 lanes per iteration: every line below is one
+    // instruction working on 16 lanes (8 for the doubles of the gain)
+    void processAvx512(const int16_t* in, int16_t* out, uint32_t frames) {
+        // Lane l's delay line starts at l * maxDelaySamples in 'buffer'
+        const __m512i laneStart = _mm512_mullo_epi32(
+            _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+            _mm512_set1_epi32(static_cast<int32_t>(maxDelaySamples)));
+        const __m512d gainLo = _mm512_load_pd(gain);
+        const __m512d gainHi = _mm512_load_pd(gain + 8);
+        const __m512 vdry = _mm512_load_ps(dry);
+        const __m512 vwet = _mm512_load_ps(wet);
+        const __m512d minD = _mm512_set1_pd(-32768.0), maxD = _mm512_set1_pd(32767.0);
+        const __m512 minF = _mm512_set1_ps(-32768.0f), maxF = _mm512_set1_ps(32767.0f);
+        const __m512i wrapAt = _mm512_set1_epi32(static_cast<int32_t>(maxDelaySamples));
+        const __m512i one = _mm512_set1_epi32(1);
+        __m512i read = _mm512_load_si512(readIndex);
+        float* buf = buffer.data();
+
+        for (uint32_t n = 0; n < frames; ++n) {
+            // Day 2 gain in double, as in the scalar version
+            const __m512i x = _mm512_cvtepi16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + static_cast<size_t>(n) * lanes)));
+            __m512d lo = _mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_castsi512_si256(x)), gainLo);
+            __m512d hi = _mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(x, 1)), gainHi);
+            lo = _mm512_min_pd(maxD, _mm512_max_pd(minD, lo));
+            hi = _mm512_min_pd(maxD, _mm512_max_pd(minD, hi));
+            const __m512i gi = _mm512_inserti64x4(_mm512_zextsi256_si512(_mm512_cvttpd_epi32(lo)), _mm512_cvttpd_epi32(hi), 1);
+            const __m512 g = _mm512_cvtepi32_ps(gi);
+
+            // Day 5 delay: gather each lane's delayed sample, mix, clamp, truncate
+            const __m512 d = _mm512_i32gather_ps(_mm512_add_epi32(laneStart, read), buf, 4);
+            __m512 mix = _mm512_add_ps(_mm512_mul_ps(vdry, g), _mm512_mul_ps(vwet, d));
+            mix = _mm512_min_ps(maxF, _mm512_max_ps(minF, mix));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + static_cast<size_t>(n) * lanes),
+                                _mm512_cvtepi32_epi16(_mm512_cvttps_epi32(mix)));
+
+            // Scatter the new samples to every lane's write head, then move
+            // the read heads on, wrapping the ones that hit the end
+            _mm512_i32scatter_ps(buf, _mm512_add_epi32(laneStart, _mm512_set1_epi32(static_cast<int32_t>(writeIndex))), g, 4);
+            read = _mm512_add_epi32(read, one);
+            read = _mm512_mask_mov_epi32(read, _mm512_cmpge_epi32_mask(read, wrapAt), _mm512_setzero_si512());
+            if (++writeIndex >= maxDelaySamples) writeIndex = 0;
+        }
+        _mm512_store_si512(readIndex, read);
+    }
+#endif
+
+    alignas(64) double gain[lanes];
+    alignas(64) float dry[lanes];
+    alignas(64) float wet[lanes];
+    alignas(64) int32_t readIndex[lanes];  // Each lane's own read head
+    std::vector<float> buffer;             // Lane l's delay line: buffer[l * maxDelaySamples + slot]
+    uint32_t writeIndex = 0;               // Shared: all lanes write the same slot
+};
+
+// ---------------------------------------------------------------------------
+// Benchmark
+// ---------------------------------------------------------------------------
+// Small deterministic random numbers, so every run uses the same settings
+uint32_t nextRandom(uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+int main(int argc, char* argv[]) {
+    const int numInstances = (argc > 1) ? std::max(1, std::atoi(argv[1])) : 1024;
+    const double seconds = (argc > 2) ? std::max(0.1, std::atof(argv[2])) : 5.0;
+
+    // Every user streams input.wav, each starting at a different point
+    std::ifstream in("input.wav", std::ios::binary);
+    WavHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(WavHeader));
+    if (!in || header.bitsPerSample != 16 || header.subchunk2Size < 2) {
+        std::cerr << "Error: Expected a 16-bit PCM WAV file (input.wav).\n";
+        return 1;
+    }
+    std::vector<int16_t> source(header.subchunk2Size / sizeof(int16_t));
+    in.read(reinterpret_cast<char*>(source.data()), static_cast<std::streamsize>(source.size() * sizeof(int16_t)));
+    if (!in) {
+        std::cerr << "Error: Failed to read audio data.\n";
+        return 1;
+    }
+
+    // Random settings per user
+    std::vector<Settings> settings(numInstances);
+    uint32_t rng = 12345;
+    for (Settings& s : settings) {
+        s.gain = 0.25 + (nextRandom(rng) % 1000) / 500.0;          // 0.25 .. 2.25
+        s.delayMs = 20.0f + static_cast<float>(nextRandom(rng) % 480); // 20 .. 499 ms
+        s.dry = 0.5f + (nextRandom(rng) % 100) / 200.0f;
+        s.wet = 0.2f + (nextRandom(rng) % 100) / 200.0f;
+    }
+
+    std::vector<ScalarInstance> scalar;
+    scalar.reserve(numInstances);
+    for (const Settings& s : settings) scalar.emplace_back(s);
+
+    const int numBatches = (numInstances + lanes - 1) / lanes;
+    std::vector<InstanceBatch> batches(numBatches);
+    for (int i = 0; i < numInstances; ++i) batches[i / lanes].setLane(i % lanes, settings[i]);
+
+    // Per-user blocks, as they'd arrive from the network: [user][frame]
+    std::vector<int16_t> input(static_cast<size_t>(numInstances) * blockFrames);
+    std::vector<int16_t> outScalar(input.size());
+    std::vector<int16_t> outBatched(input.size());
+    std::vector<int16_t> laneIn(static_cast<size_t>(lanes) * blockFrames);
+    std::vector<int16_t> laneOut(laneIn.size());
+
+    const uint64_t numBlocks = static_cast<uint64_t>(seconds * sampleRate / blockFrames);
+    double scalarSeconds = 0.0, batchedSeconds = 0.0;
+    double kernelSeconds = 0.0; // Batched time without the transposes
+    bool identical = true;
+
+    for (uint64_t b = 0; b < numBlocks; ++b) {
+        // Fill this block for every user (not timed: it stands in for the network)
+        for (int i = 0; i < numInstances; ++i) {
+            size_t pos = (b * blockFrames + static_cast<uint64_t>(i) * 997) % source.size();
+            int16_t* dst = input.data() + static_cast<size_t>(i) * blockFrames;
+            for (uint32_t n = 0; n < blockFrames; ++n) {
+                dst[n] = source[pos];
+                if (++pos == source.size()) pos = 0;
+            }
+        }
+
+        // 1) One instance at a time
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < numInstances; ++i) {
+            const size_t offset = static_cast<size_t>(i) * blockFrames;
+            scalar[i].process(input.data() + offset, outScalar.data() + offset, blockFrames);
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        scalarSeconds += std::chrono::duration<double>(t1 - t0).count();
+
+        // 2) Batched: transpose in, 16 lanes at once, transpose out
+        t0 = std::chrono::steady_clock::now();
+        for (int batch = 0; batch < numBatches; ++batch) {
+            const int first = batch * lanes;
+            const int active = std::min(lanes, numInstances - first);
+            if (active < lanes) std::fill(laneIn.begin(), laneIn.end(), 0);
+            for (int l = 0; l < active; ++l) {
+                const int16_t* src = input.data() + static_cast<size_t>(first + l) * blockFrames;
+                for (uint32_t n = 0; n < blockFrames; ++n) laneIn[static_cast<size_t>(n) * lanes + l] = src[n];
+            }
+            const auto k0 = std::chrono::steady_clock::now();
+            batches[batch].process(laneIn.data(), laneOut.data(), blockFrames);
+            kernelSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - k0).count();
+            for (int l = 0; l < active; ++l) {
+                int16_t* dst = outBatched.data() + static_cast<size_t>(first + l) * blockFrames;
+                for (uint32_t n = 0; n < blockFrames; ++n) dst[n] = laneOut[static_cast<size_t>(n) * lanes + l];
+            }
+        }
+        t1 = std::chrono::steady_clock::now();
+        batchedSeconds += std::chrono::duration<double>(t1 - t0).count();
+
+        if (outScalar != outBatched) identical = false;
+    }
+
+    // Realtime = one second of audio per user per second of CPU
+    const double audioSeconds = static_cast<double>(numBlocks * blockFrames) / sampleRate;
+    const double scalarPerCore = numInstances * audioSeconds / scalarSeconds;
+    const double batchedPerCore = numInstances * audioSeconds / batchedSeconds;
+    const double kernelPerCore = numInstances * audioSeconds / kernelSeconds;
+    std::printf("%d instances (gain -> delay, %d batches of %d lanes), %.2f s of %u Hz audio in %u-frame blocks\n",
+        numInstances, numBatches, lanes, audioSeconds, sampleRate, blockFrames);
+    std::printf("One at a time:          %8.3f s CPU   %8.0f instances per core in realtime\n", scalarSeconds, scalarPerCore);
+    std::printf("Batched:                %8.3f s CPU   %8.0f instances per core in realtime (%.2fx)\n",
+        batchedSeconds, batchedPerCore, batchedPerCore / scalarPerCore);
+    std::printf("  without transposes:   %8.3f s CPU   %8.0f instances per core in realtime (%.2fx)\n",
+        kernelSeconds, kernelPerCore, kernelPerCore / scalarPerCore);
+#if !defined(__AVX512F__)
+    std::printf("(built without AVX-512: the batch ran as plain C++ lane loops)\n");
+#endif
+    std::cout << "Every instance identical: " << (identical ? "PASS" : "FAIL") << "\n";
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,569 @@
+/*
+    MicroDSP - Day 6: Waveshaper / Saturator
+
+    What this program does:
+    - Reads a 16-bit PCM mono WAV file: input.wav
+    - Pushes it through a waveshaper (tanh, soft-clip, polynomial or table lookup)
+    - Optionally runs the shaper at 2x / 4x / 8x the sample rate (oversampling),
+      or uses antiderivative anti-aliasing (ADAA) instead of oversampling
+    - Writes the result to: output_waveshaper.wav
+    - Times every shape/quality combination and prints a cost table,
+      so you can pick the cheapest mode that sounds good enough for a job
+
+    Why oversampling?
+    A waveshaper is a NON-linear function. Feeding a 5 kHz sine through tanh()
+    creates harmonics at 15 kHz, 25 kHz, 35 kHz... Anything above Nyquist
+    (sampleRate / 2) cannot be represented and "folds back" down as aliasing,
+    which sounds like inharmonic fizz. If we temporarily raise the sample rate,
+    those harmonics have room to exist, and we can low-pass them away before
+    going back down to the original rate.
+
+    Half-band filters:
+    Going up or down by exactly 2x is done with a "half-band" low-pass FIR.
+    Its cutoff sits at exactly a quarter of the (high) sample rate, which
+    makes every other coefficient exactly zero. Splitting the filter into its
+    even and odd coefficients ("polyphase") means one phase is a short FIR and
+    the other phase is just a delayed copy of the input. 4x and 8x are simply
+    two or three 2x stages in a row.
+
+    ADAA (antiderivative anti-aliasing):
+    Instead of evaluating f(x[n]), we evaluate the average of f between the
+    previous and current sample:
+        y[n] = (F(x[n]) - F(x[n-1])) / (x[n] - x[n-1])
+    where F is the antiderivative (integral) of f. This smooths out the sharp
+    corners that cause aliasing at roughly the cost of one extra function call,
+    with no oversampling at all.
+
+    SIMD note:
+    The filter loops below are written "across the block" (outer loop over
+    taps, inner loop over samples). The inner loop has no dependencies between
+    iterations, so compiling with optimizations (e.g. g++ -O3 -march=native)
+    lets the compiler turn it into SSE/AVX instructions automatically.
+
+    Build:
+        g++ -std=c++17 -O3 -march=native waveshaper.cpp -o waveshaper
+
+    Author: Jesse Whiting (GhostWire Audio)
+    GitHub: ghostwireaudio
+*/
+
+#define _USE_MATH_DEFINES
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+// Force the compiler to pack the struct exactly as written
+// with no padding bytes added for alignment, which ensures
+// sizeof(WavHeader) == 44 bytes
+#pragma pack(push, 1)
+struct WavHeader {
+    // RIFF Chunk Descriptor
+    char     riff[4];        // "RIFF"
+    uint32_t chunkSize;      // 36 + Subchunk2Size
+    char     wave[4];        // "WAVE"
+
+    // fmt subchunk
+    char     fmt[4];         // "fmt "
+    uint32_t subchunk1Size;  // 16 for PCM
+    uint16_t audioFormat;    // 1 for PCM
+    uint16_t numChannels;    // 1 for mono
+    uint32_t sampleRate;     // e.g., 44100
+    uint32_t byteRate;       // sampleRate * numChannels * bitsPerSample/8
+    uint16_t blockAlign;     // numChannels * bitsPerSample/8
+    uint16_t bitsPerSample;  // 16
+
+    // data subchunk
+    char     data[4];        // "data"
+    uint32_t subchunk2Size;  // NumSamples * numChannels * bitsPerSample/8
+};
+#pragma pack(pop)
+
+// Which curve to bend the signal through
+enum class ShapeType { Tanh, SoftClip, Polynomial, Table };
+
+// Number of base-rate samples processed per block
+const int blockSize = 512;
+
+// ---------------------------------------------------------------------------
+// Shaping curves and their antiderivatives
+// ---------------------------------------------------------------------------
+
+// Lookup table for the "Table" shape. Any curve could be stored here
+// (e.g. a measured tube transfer curve); we fill it with an asymmetric
+// tanh so it sounds different from the analytic shapes.
+const int tableSize = 4096;
+const float tableRange = 4.0f; // Table covers x in [-4, +4]
+std::vector<float> shapeTable(tableSize + 1);
+std::vector<double> shapeTableIntegral(tableSize + 1); // Running integral, used by ADAA
+
+void buildShapeTable() {
+    const double step = (2.0 * tableRange) / tableSize;
+    for (int i = 0; i <= tableSize; ++i) {
+        const double x = -tableRange + i * step;
+        // A little DC bias before tanh gives even harmonics ("warmer" sound)
+        shapeTable[i] = static_cast<float>(std::tanh(x + 0.2) - std::tanh(0.2));
+    }
+
+    // Trapezoidal integration gives us F(x) for the ADAA path
+    shapeTableIntegral[0] = 0.0;
+    for (int i = 1; i <= tableSize; ++i) {
+        shapeTableIntegral[i] = shapeTableIntegral[i - 1] + 0.5 * (shapeTable[i - 1] + shapeTable[i]) * step;
+    }
+}
+
+// Linear interpolation into the table. Outside the table we hold the edge value.
+inline float tableLookup(float x) {
+    float pos = (x + tableRange) * (tableSize / (2.0f * tableRange));
+    pos = std::clamp(pos, 0.0f, static_cast<float>(tableSize) - 0.0001f);
+    const int i = static_cast<int>(pos);
+    const float frac = pos - static_cast<float>(i);
+    return shapeTable[i] + frac * (shapeTable[i + 1] - shapeTable[i]);
+}
+
+// The shaping function f(x)
+inline double shape(ShapeType type, double x) {
+    switch (type) {
+    case ShapeType::Tanh:
+        return std::tanh(x);
+    case ShapeType::SoftClip:
+        // Cubic soft clip: 1.5 * (x - x^3/3), flat at +-1 beyond |x| = 1
+        if (x >= 1.0) return 1.0;
+        if (x <= -1.0) return -1.0;
+        return 1.5 * (x - x * x * x / 3.0);
+    case ShapeType::Polynomial:
+        // 5th order "smoothstep" curve: first and second derivatives are 0 at +-1,
+        // so the knee is even softer than the cubic
+        if (x >= 1.0) return 1.0;
+        if (x <= -1.0) return -1.0;
+        {
+            const double x2 = x * x;
+            return x * (15.0 - 10.0 * x2 + 3.0 * x2 * x2) / 8.0;
+        }
+    case ShapeType::Table:
+        return tableLookup(static_cast<float>(x));
+    }
+    return x;
+}
+
+// The antiderivative F(x), where dF/dx = f(x). Used only by ADAA.
+inline double shapeAntiderivative(ShapeType type, double x) {
+    const double ax = std::fabs(x);
+    switch (type) {
+    case ShapeType::Tanh:
+        // F(x) = log(cosh(x)), rewritten so it never overflows for large |x|
+        return ax + std::log1p(std::exp(-2.0 * ax)) - M_LN2;
+    case ShapeType::SoftClip:
+        if (ax >= 1.0) return 0.625 + (ax - 1.0);
+        return 1.5 * (x * x / 2.0 - x * x * x * x / 12.0);
+    case ShapeType::Polynomial:
+        if (ax >= 1.0) return 11.0 / 16.0 + (ax - 1.0);
+        {
+            const double x2 = x * x;
+            return (15.0 * x2 - 5.0 * x2 * x2 + x2 * x2 * x2) / 16.0;
+        }
+    case ShapeType::Table: {
+        double pos = (x + tableRange) * (tableSize / (2.0 * tableRange));
+        const double step = (2.0 * tableRange) / tableSize;
+        if (pos <= 0.0) return shapeTableIntegral[0] + shapeTable[0] * (pos * step);
+        if (pos >= tableSize) return shapeTableIntegral[tableSize] + shapeTable[tableSize] * ((pos - tableSize) * step);
+        // Integrate the linear segment exactly from its left edge
+        const int i = static_cast<int>(pos);
+        const double frac = pos - i;
+        const double a = shapeTable[i];
+        const double b = shapeTable[i + 1];
+        return shapeTableIntegral[i] + step * (a * frac + 0.5 * (b - a) * frac * frac);
+    }
+    }
+    return 0.5 * x * x;
+}
+
+// Applies the shape to a whole block. The switch sits OUTSIDE the loop so
+// each loop body is tiny and branch-free (the polynomial one vectorizes).
+void shapeBlock(ShapeType type, float drive, float* samples, int n) {
+    switch (type) {
+    case ShapeType::Tanh:
+        for (int i = 0; i < n; ++i) samples[i] = std::tanh(drive * samples[i]);
+        break;
+    case ShapeType::SoftClip:
+        for (int i = 0; i < n; ++i) {
+            const float x = std::clamp(drive * samples[i], -1.0f, 1.0f);
+            samples[i] = 1.5f * (x - x * x * x * (1.0f / 3.0f));
+        }
+        break;
+    case ShapeType::Polynomial:
+        for (int i = 0; i < n; ++i) {
+            const float x = std::clamp(drive * samples[i], -1.0f, 1.0f);
+            const float x2 = x * x;
+            samples[i] = x * (15.0f - 10.0f * x2 + 3.0f * x2 * x2) * 0.125f;
+        }
+        break;
+    case ShapeType::Table:
+        for (int i = 0; i < n; ++i) samples[i] = tableLookup(drive * samples[i]);
+        break;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// First-order ADAA state
+// ---------------------------------------------------------------------------
+struct AdaaShaper {
+    ShapeType type = ShapeType::Tanh;
+    double prevX = 0.0;  // Previous (driven) input sample
+    double prevF = 0.0;  // F(prevX), cached so F is evaluated once per sample
+
+    void reset() {
+        prevX = 0.0;
+        prevF = shapeAntiderivative(type, 0.0);
+    }
+
+    void process(float drive, float* samples, int n) {
+        for (int i = 0; i < n; ++i) {
+            const double x = static_cast<double>(drive) * samples[i];
+            const double F = shapeAntiderivative(type, x);
+            const double dx = x - prevX;
+
+            double y;
+            if (std::fabs(dx) > 1e-6) {
+                // Average value of f between the two samples
+                y = (F - prevF) / dx;
+            } else {
+                // Samples (almost) equal: divide-by-zero territory, so
+                // fall back to f at the midpoint, which is the same limit
+                y = shape(type, 0.5 * (x + prevX));
+            }
+
+            samples[i] = static_cast<float>(y);
+            prevX = x;
+            prevF = F;
+        }
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Half-band polyphase filters
+// ---------------------------------------------------------------------------
+
+// Designs a half-band low-pass with numTaps = 4k + 3 coefficients using a
+// Kaiser-windowed sinc. Returns ONLY the non-zero "odd offset" coefficients
+// (the centre tap is always exactly 0.5 and every other tap is 0).
+std::vector<float> designHalfband(int numTaps, double kaiserBeta) {
+    const int centre = (numTaps - 1) / 2;
+
+    // Zeroth-order modified Bessel function, needed for the Kaiser window
+    auto besselI0 = [](double x) {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; k < 50; ++k) {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    };
+
+    std::vector<float> taps;
+    double sum = 0.0;
+    for (int i = 0; i < numTaps; i += 2) {
+        // i is even and centre is odd, so (i - centre) is always odd
+        const double t = (i - centre) / 2.0;
+        const double sinc = std::sin(M_PI * t) / (M_PI * t);
+        const double r = (i - centre) / static_cast<double>(centre);
+        const double window = besselI0(kaiserBeta * std::sqrt(1.0 - r * r)) / besselI0(kaiserBeta);
+        taps.push_back(static_cast<float>(0.5 * sinc * window));
+        sum += taps.back();
+    }
+
+    // The odd taps must sum to exactly 0.5 so the total DC gain is 1.0
+    for (float& t : taps) t = static_cast<float>(t * (0.5 / sum));
+    return taps;
+}
+
+// Upsamples by 2: n input samples -> 2n output samples
+struct HalfbandUp {
+    std::vector<float> taps;    // Odd-offset taps (already doubled for the zero-stuffing gain)
+    std::vector<float> buffer;  // [history | new input]
+    std::vector<float> evenOut; // FIR phase
+    int history = 0;            // taps.size() - 1
+    int centreDelay = 0;        // Delay of the pure-copy phase
+
+    void init(const std::vector<float>& halfbandTaps, int maxBlock) {
+        taps = halfbandTaps;
+        for (float& t : taps) t *= 2.0f; // Inserting zeros halves the energy, so make it up here
+        history = static_cast<int>(taps.size()) - 1;
+        centreDelay = (history - 1) / 2;
+        buffer.assign(history + maxBlock, 0.0f);
+        evenOut.assign(maxBlock, 0.0f);
+    }
+
+    void reset() { std::fill(buffer.begin(), buffer.end(), 0.0f); }
+
+    void process(const float* in, float* out, int n) {
+        std::copy(in, in + n, buffer.begin() + history);
+        const float* x = buffer.data() + history; // x[m - j] is valid for j <= history
+
+        // Even output phase: a normal FIR, computed across the block
+        std::fill(evenOut.begin(), evenOut.begin() + n, 0.0f);
+        for (int j = 0; j < static_cast<int>(taps.size()); ++j) {
+            const float c = taps[j];
+            const float* src = x - j;
+            for (int m = 0; m < n; ++m) evenOut[m] += c * src[m];
+        }
+
+        // Odd output phase: just the input, delayed to line up with the FIR centre
+        for (int m = 0; m < n; ++m) {
+            out[2 * m] = evenOut[m];
+            out[2 * m + 1] = x[m - centreDelay];
+        }
+
+        // Keep the last "history" samples for the next block
+        std::copy(buffer.begin() + n, buffer.begin() + n + history, buffer.begin());
+    }
+};
+
+// Downsamples by 2: 2n input samples -> n output samples
+struct HalfbandDown {
+    std::vector<float> taps;
+    std::vector<float> evenIn; // [history | even-indexed input samples]
+    std::vector<float> oddIn;  // [history | odd-indexed input samples]
+    int history = 0;
+    int centreDelay = 0;
+
+    void init(const std::vector<float>& halfbandTaps, int maxBlock) {
+        taps = halfbandTaps;
+        history = static_cast<int>(taps.size()) - 1;
+        centreDelay = (history - 1) / 2 + 1;
+        evenIn.assign(history + maxBlock, 0.0f);
+        oddIn.assign(history + maxBlock, 0.0f);
+    }
+
+    void reset() {
+        std::fill(evenIn.begin(), evenIn.end(), 0.0f);
+        std::fill(oddIn.begin(), oddIn.end(), 0.0f);
+    }
+
+    void process(const float* in, float* out, int n) {
+        // Split the input into its two phases
+        for (int m = 0; m < n; ++m) {
+            evenIn[history + m] = in[2 * m];
+            oddIn[history + m] = in[2 * m + 1];
+        }
+        const float* xe = evenIn.data() + history;
+        const float* xo = oddIn.data() + history;
+
+        // Centre tap (always 0.5) applied to the odd phase
+        for (int m = 0; m < n; ++m) out[m] = 0.5f * xo[m - centreDelay];
+
+        // The rest of the taps applied to the even phase
+        for (int j = 0; j < static_cast<int>(taps.size()); ++j) {
+            const float c = taps[j];
+            const float* src = xe - j;
+            for (int m = 0; m < n; ++m) out[m] += c * src[m];
+        }
+
+        std::copy(evenIn.begin() + n, evenIn.begin() + n + history, evenIn.begin());
+        std::copy(oddIn.begin() + n, oddIn.begin() + n + history, oddIn.begin());
+    }
+};
+
+// ---------------------------------------------------------------------------
+// The complete saturator: drive -> (oversample) -> shape -> (downsample)
+// ---------------------------------------------------------------------------
+struct Saturator {
+    ShapeType type = ShapeType::Tanh;
+    int oversample = 1;   // 1, 2, 4 or 8
+    bool useAdaa = false; // ADAA replaces oversampling (oversample is ignored)
+    float drive = 4.0f;   // Pre-gain into the curve
+    float outputGain = 0.5f;
+
+    std::vector<HalfbandUp> upStages;
+    std::vector<HalfbandDown> downStages;
+    std::vector<std::vector<float>> stageBuffers; // One scratch buffer per rate
+    AdaaShaper adaa;
+
+    void prepare() {
+        int stages = 0;
+        if (!useAdaa) {
+            if (oversample >= 2) stages = 1;
+            if (oversample >= 4) stages = 2;
+            if (oversample >= 8) stages = 3;
+        }
+
+        // The first stage (closest to the original rate) has the narrowest
+        // transition band and needs the most taps. Later stages only have to
+        // reject images far above the audio band, so they can be much shorter.
+        const int tapsPerStage[3] = { 47, 23, 11 };
+
+        upStages.assign(stages, HalfbandUp{});
+        downStages.assign(stages, HalfbandDown{});
+        stageBuffers.assign(stages + 1, std::vector<float>());
+        for (int s = 0; s <= stages; ++s) stageBuffers[s].assign(blockSize << s, 0.0f);
+
+        for (int s = 0; s < stages; ++s) {
+            const std::vector<float> hb = designHalfband(tapsPerStage[s], 8.0);
+            upStages[s].init(hb, blockSize << s);
+            downStages[s].init(hb, blockSize << s);
+        }
+
+        adaa.type = type;
+        adaa.reset();
+    }
+
+    // Processes up to blockSize samples in place
+    void process(float* samples, int n) {
+        if (useAdaa) {
+            adaa.process(drive, samples, n);
+        } else {
+            const int stages = static_cast<int>(upStages.size());
+
+            // Climb up to the high rate
+            const float* src = samples;
+            for (int s = 0; s < stages; ++s) {
+                upStages[s].process(src, stageBuffers[s + 1].data(), n << s);
+                src = stageBuffers[s + 1].data();
+            }
+
+            // Shape at the highest rate
+            float* top = (stages == 0) ? samples : stageBuffers[stages].data();
+            shapeBlock(type, drive, top, n << stages);
+
+            // Climb back down to the original rate
+            for (int s = stages - 1; s >= 0; --s) {
+                float* dst = (s == 0) ? samples : stageBuffers[s].data();
+                downStages[s].process(stageBuffers[s + 1].data(), dst, n << s);
+            }
+        }
+
+        for (int i = 0; i < n; ++i) samples[i] *= outputGain;
+    }
+};
+
+const char* shapeName(ShapeType type) {
+    switch (type) {
+    case ShapeType::Tanh: return "tanh";
+    case ShapeType::SoftClip: return "soft-clip";
+    case ShapeType::Polynomial: return "polynomial";
+    case ShapeType::Table: return "table";
+    }
+    return "?";
+}
+
+int main() {
+    const char* inputPath = "input.wav";
+    const char* outputPath = "output_waveshaper.wav";
+
+    // Settings for the rendered file
+    const ShapeType shapeType = ShapeType::Tanh;
+    const int oversample = 4;   // 1, 2, 4 or 8
+    const bool useAdaa = false; // true = ADAA instead of oversampling
+    const float drive = 4.0f;   // How hard we push into the curve
+
+    buildShapeTable();
+
+    // Open input file in binary mode
+    std::ifstream in(inputPath, std::ios::binary);
+    if (!in) {
+        std::cerr << "Error: Could not open input file.\n";
+        return 1;
+    }
+
+    WavHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(WavHeader));
+    if (!in) {
+        std::cerr << "Error: Failed to read WAV header.\n";
+        return 1;
+    }
+
+    const uint32_t bytesPerSample = header.bitsPerSample / 8;
+    const uint32_t numSamples = header.subchunk2Size / bytesPerSample;
+
+    std::vector<int16_t> input(numSamples);
+    in.read(reinterpret_cast<char*>(input.data()), header.subchunk2Size);
+    if (!in) {
+        std::cerr << "Error: Failed to read audio data.\n";
+        return 1;
+    }
+    in.close();
+
+    // Work in float, scaled to [-1, 1), so the curves saturate around full scale
+    std::vector<float> signal(numSamples);
+    for (uint32_t n = 0; n < numSamples; ++n) signal[n] = input[n] / 32768.0f;
+
+    // Renders the whole signal block by block with one saturator configuration
+    auto render = [&](Saturator& sat, std::vector<float>& buffer) {
+        sat.prepare();
+        for (uint32_t start = 0; start < numSamples; start += blockSize) {
+            const int n = static_cast<int>(std::min<uint32_t>(blockSize, numSamples - start));
+            sat.process(buffer.data() + start, n);
+        }
+    };
+
+    // Render the output file
+    Saturator sat;
+    sat.type = shapeType;
+    sat.oversample = oversample;
+    sat.useAdaa = useAdaa;
+    sat.drive = drive;
+
+    std::vector<float> processed = signal;
+    render(sat, processed);
+
+    std::vector<int16_t> output(numSamples);
+    for (uint32_t n = 0; n < numSamples; ++n) {
+        const float scaled = std::clamp(processed[n] * 32768.0f, -32768.0f, 32767.0f);
+        output[n] = static_cast<int16_t>(scaled);
+    }
+
+    std::ofstream out(outputPath, std::ios::binary);
+    if (!out) {
+        std::cerr << "Error: Could not open output file.\n";
+        return 1;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(WavHeader));
+    out.write(reinterpret_cast<const char*>(output.data()), header.subchunk2Size);
+    out.close();
+
+    std::cout << "Wrote " << outputPath << " (" << shapeName(shapeType) << ", "
+              << (useAdaa ? std::string("ADAA") : std::to_string(oversample) + "x") << ")\n\n";
+
+    // Cost report: time every shape at every quality setting.
+    // ns/sample is measured per ORIGINAL sample, so the numbers are
+    // directly comparable; "x realtime" is how many seconds of audio
+    // one core renders per second.
+    const ShapeType shapes[4] = { ShapeType::Tanh, ShapeType::SoftClip, ShapeType::Polynomial, ShapeType::Table };
+    const int factors[4] = { 1, 2, 4, 8 };
+    const double audioSeconds = static_cast<double>(numSamples) / header.sampleRate;
+
+    std::printf("%-11s %-6s %12s %14s\n", "shape", "mode", "ns/sample", "x realtime");
+    for (ShapeType type : shapes) {
+        for (int mode = 0; mode < 5; ++mode) {
+            Saturator bench;
+            bench.type = type;
+            bench.drive = drive;
+            bench.useAdaa = (mode == 4);
+            bench.oversample = bench.useAdaa ? 1 : factors[mode];
+
+            // Repeat until we've measured at least ~50 ms so the timer is meaningful
+            std::vector<float> buffer;
+            int runs = 0;
+            double seconds = 0.0;
+            while (seconds < 0.05 || runs < 3) {
+                buffer = signal;
+                const auto t0 = std::chrono::steady_clock::now();
+                render(bench, buffer);
+                const auto t1 = std::chrono::steady_clock::now();
+                seconds += std::chrono::duration<double>(t1 - t0).count();
+                ++runs;
+            }
+
+            const double nsPerSample = seconds * 1e9 / (static_cast<double>(numSamples) * runs);
+            const double realtime = audioSeconds * runs / seconds;
+            const std::string modeName = bench.useAdaa ? "ADAA" : std::to_string(bench.oversample) + "x";
+            std::printf("%-11s %-6s %12.2f %14.0f\n", shapeName(type), modeName.c_str(), nsPerSample, realtime);
+        }
+    }
+
+    return 0;
+}
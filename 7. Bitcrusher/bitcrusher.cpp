@@ -0,0 +1,286 @@
+/*
+    MicroDSP - Day 7: Bitcrusher / Sample-Rate Reducer
+
+    What this program does:
+    - Reads a 16-bit PCM mono WAV file: input.wav
+    - Reduces the bit depth (fewer amplitude steps = gritty quantization noise)
+    - Reduces the sample rate with sample-and-hold (every new sample is
+      "held" for a while, creating the classic aliased, lo-fi sound)
+    - Optionally adds TPDF dither before quantizing
+    - Writes the result to: output_bitcrush.wav
+
+    Two kernels are provided:
+    - A float kernel, for use inside a float processing chain
+    - An int16 kernel, which works directly on the raw 16-bit samples from
+      the file (like gain_processor.cpp does) without converting to float
+
+    Both kernels work on BLOCKS of samples. The quantization step is a plain
+    loop with no dependencies between samples, so the compiler can turn it
+    into SIMD instructions (g++ -O3 -march=native). The sample-and-hold step
+    has to remember what it was holding, so its state (phase, held value and
+    the dither random generator) is stored in the struct and carried from
+    one block to the next. This makes the output EXACTLY the same no matter
+    how the file is cut into blocks, which the program checks at the end.
+
+    Build:
+        g++ -std=c++17 -O3 -march=native bitcrusher.cpp -o bitcrusher
+
+    Author: Jesse Whiting (GhostWire Audio)
+    GitHub: ghostwireaudio
+*/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+
+// Force the compiler to pack the struct exactly as written
+// with no padding bytes added for alignment, which ensures
+// sizeof(WavHeader) == 44 bytes
+#pragma pack(push, 1)
+struct WavHeader {
+    // RIFF Chunk Descriptor
+    char     riff[4];        // "RIFF"
+    uint32_t chunkSize;      // 36 + Subchunk2Size
+    char     wave[4];        // "WAVE"
+
+    // fmt subchunk
+    char     fmt[4];         // "fmt "
+    uint32_t subchunk1Size;  // 16 for PCM
+    uint16_t audioFormat;    // 1 for PCM
+    uint16_t numChannels;    // 1 for mono
+    uint32_t sampleRate;     // e.g., 44100
+    uint32_t byteRate;       // sampleRate * numChannels * bitsPerSample/8
+    uint16_t blockAlign;     // numChannels * bitsPerSample/8
+    uint16_t bitsPerSample;  // 16
+
+    // data subchunk
+    char     data[4];        // "data"
+    uint32_t subchunk2Size;  // NumSamples * numChannels * bitsPerSample/8
+};
+#pragma pack(pop)
+
+// Largest block either kernel accepts in one call
+const int maxBlockSize = 4096;
+
+struct Bitcrusher {
+    // Parameters
+    int bits = 6;               // Output bit depth (1..16)
+    double holdRatio = 0.25;    // New rate / original rate (0.25 = hold each sample for 4)
+    bool dither = false;        // Add TPDF dither before quantizing
+
+    // State carried across blocks
+    double phase = 1.0;         // Sample-and-hold phase; >= 1 means "grab a new sample"
+    float heldFloat = 0.0f;     // Value being held (float kernel)
+    int16_t heldInt = 0;        // Value being held (int16 kernel)
+    uint32_t rngState = 22222;  // xorshift32 state for the dither noise
+
+    // Scratch space so process() never allocates
+    std::vector<float> noiseFloat = std::vector<float>(maxBlockSize);
+    std::vector<int32_t> noiseInt = std::vector<int32_t>(maxBlockSize);
+
+    void reset() {
+        phase = 1.0;
+        heldFloat = 0.0f;
+        heldInt = 0;
+        rngState = 22222;
+    }
+
+    // Tiny, fast pseudo-random generator. Deterministic, so renders repeat exactly.
+    uint32_t nextRandom() {
+        rngState ^= rngState << 13;
+        rngState ^= rngState >> 17;
+        rngState ^= rngState << 5;
+        return rngState;
+    }
+
+    // Sample-and-hold, shared by both kernels.
+    // phase advances by holdRatio each sample; every time it passes 1.0 we
+    // take a fresh sample. Because phase and the held value live in the
+    // struct, a hold that started in one block continues into the next.
+    template <typename T>
+    void sampleAndHold(T* samples, int n, T& held) {
+        for (int i = 0; i < n; ++i) {
+            if (phase >= 1.0) {
+                phase -= 1.0;
+                held = samples[i];
+            }
+            samples[i] = held;
+            phase += holdRatio;
+        }
+    }
+
+    // Float kernel: samples are in [-1, 1)
+    void processFloat(float* samples, int n) {
+        const float levels = static_cast<float>(1 << (bits - 1)); // Steps per unit of amplitude
+        const float invLevels = 1.0f / levels;
+
+        // Triangular (TPDF) dither = sum of two uniform randoms, spanning +-1 step.
+        // Generated up front (the generator is serial) so the quantize loop stays branch-free.
+        if (dither) {
+            for (int i = 0; i < n; ++i) {
+                const float r1 = (nextRandom() >> 8) * (1.0f / 16777216.0f);
+                const float r2 = (nextRandom() >> 8) * (1.0f / 16777216.0f);
+                noiseFloat[i] = r1 + r2 - 1.0f;
+            }
+        } else {
+            std::fill(noiseFloat.begin(), noiseFloat.begin() + n, 0.0f);
+        }
+
+        // Quantize: scale up, round to the nearest whole step, scale back down
+        for (int i = 0; i < n; ++i) {
+            const float q = std::nearbyint(samples[i] * levels + noiseFloat[i]);
+            samples[i] = std::clamp(q, -levels, levels - 1.0f) * invLevels;
+        }
+
+        sampleAndHold(samples, n, heldFloat);
+    }
+
+    // int16 kernel: works on raw PCM without leaving the integer domain
+    void processInt16(int16_t* samples, int n) {
+        const int shift = 16 - bits;     // Number of low bits we throw away
+        const int32_t step = 1 << shift; // Size of one quantization step in int16 units
+        const int32_t mask = step - 1;
+
+        // Triangular dither in whole int16 units, spanning +-(step - 1)
+        if (dither && shift > 0) {
+            for (int i = 0; i < n; ++i) {
+                noiseInt[i] = static_cast<int32_t>(nextRandom() & mask) + static_cast<int32_t>(nextRandom() & mask) - mask;
+            }
+        } else {
+            std::fill(noiseInt.begin(), noiseInt.begin() + n, 0);
+        }
+
+        // Round to the nearest multiple of step:
+        // add half a step, then clear the low bits with an arithmetic shift
+        const int32_t half = step >> 1;
+        for (int i = 0; i < n; ++i) {
+            int32_t v = static_cast<int32_t>(samples[i]) + noiseInt[i] + half;
+            v = (v >> shift) << shift;
+            samples[i] = static_cast<int16_t>(std::clamp<int32_t>(v, -32768, 32767 & ~mask));
+        }
+
+        sampleAndHold(samples, n, heldInt);
+    }
+};
+
+int main() {
+    const char* inputPath = "input.wav";
+    const char* outputPath = "output_bitcrush.wav";
+
+    // Crusher settings
+    const int bits = 6;              // 6-bit audio: 64 levels
+    const double targetRate = 8000;  // Sample-and-hold down to 8 kHz
+    const bool dither = true;
+    const bool useInt16Kernel = true; // false = convert to float and back
+
+    // Open input and output files
+    std::ifstream in(inputPath, std::ios::binary);
+    if (!in) {
+        std::cerr << "Error: Could not open input file.\n";
+        return 1;
+    }
+
+    WavHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(WavHeader));
+    if (!in) {
+        std::cerr << "Error: Failed to read WAV header.\n";
+        return 1;
+    }
+
+    std::ofstream out(outputPath, std::ios::binary);
+    if (!out) {
+        std::cerr << "Error: Could not open output file.\n";
+        return 1;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(WavHeader));
+
+    Bitcrusher crusher;
+    crusher.bits = bits;
+    crusher.holdRatio = targetRate / header.sampleRate;
+    crusher.dither = dither;
+
+    // Stream the file block by block, like gain_processor.cpp but 4096 samples at a time
+    std::vector<int16_t> block(maxBlockSize);
+    std::vector<float> floatBlock(maxBlockSize);
+    while (true) {
+        in.read(reinterpret_cast<char*>(block.data()), maxBlockSize * sizeof(int16_t));
+        const int n = static_cast<int>(in.gcount() / sizeof(int16_t));
+        if (n == 0)
+            break;
+
+        if (useInt16Kernel) {
+            crusher.processInt16(block.data(), n);
+        } else {
+            for (int i = 0; i < n; ++i) floatBlock[i] = block[i] / 32768.0f;
+            crusher.processFloat(floatBlock.data(), n);
+            for (int i = 0; i < n; ++i) {
+                block[i] = static_cast<int16_t>(std::clamp(floatBlock[i] * 32768.0f, -32768.0f, 32767.0f));
+            }
+        }
+
+        out.write(reinterpret_cast<const char*>(block.data()), n * sizeof(int16_t));
+    }
+    in.close();
+    out.close();
+    std::cout << "Wrote " << outputPath << " (" << bits << " bits, " << targetRate << " Hz hold)\n";
+
+    // Self-check: render the same audio with very different block sizes.
+    // If the state handling is right, every render must match bit for bit.
+    std::ifstream check(inputPath, std::ios::binary);
+    check.seekg(sizeof(WavHeader));
+    std::vector<int16_t> input(header.subchunk2Size / sizeof(int16_t));
+    check.read(reinterpret_cast<char*>(input.data()), input.size() * sizeof(int16_t));
+    input.resize(check.gcount() / sizeof(int16_t));
+    const size_t numSamples = input.size();
+
+    auto renderInt = [&](int blockLen) {
+        Bitcrusher c = crusher;
+        c.reset();
+        std::vector<int16_t> buf = input;
+        for (size_t start = 0; start < numSamples; start += blockLen) {
+            c.processInt16(buf.data() + start, static_cast<int>(std::min<size_t>(blockLen, numSamples - start)));
+        }
+        return buf;
+    };
+    auto renderFloat = [&](int blockLen) {
+        Bitcrusher c = crusher;
+        c.reset();
+        std::vector<float> buf(numSamples);
+        for (size_t i = 0; i < numSamples; ++i) buf[i] = input[i] / 32768.0f;
+        for (size_t start = 0; start < numSamples; start += blockLen) {
+            c.processFloat(buf.data() + start, static_cast<int>(std::min<size_t>(blockLen, numSamples - start)));
+        }
+        return buf;
+    };
+
+    // Odd sizes on purpose, so block edges land in the middle of held samples
+    const int blockSizes[] = { 1, 7, 333, 1000, maxBlockSize };
+    const std::vector<int16_t> referenceInt = renderInt(maxBlockSize);
+    const std::vector<float> referenceFloat = renderFloat(maxBlockSize);
+    bool identical = true;
+    for (int len : blockSizes) {
+        identical = identical && (renderInt(len) == referenceInt) && (renderFloat(len) == referenceFloat);
+    }
+    std::cout << "Block-size invariance check: " << (identical ? "PASS" : "FAIL") << "\n";
+
+    // Throughput of each kernel
+    for (int kernel = 0; kernel < 2; ++kernel) {
+        int runs = 0;
+        double seconds = 0.0;
+        while (seconds < 0.05) {
+            const auto t0 = std::chrono::steady_clock::now();
+            if (kernel == 0) renderInt(maxBlockSize);
+            else renderFloat(maxBlockSize);
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            ++runs;
+        }
+        std::cout << (kernel == 0 ? "int16 kernel: " : "float kernel: ")
+                  << seconds * 1e9 / (static_cast<double>(numSamples) * runs) << " ns/sample\n";
+    }
+
+    return identical ? 0 : 1;
+}